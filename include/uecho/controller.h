@@ -24,6 +24,12 @@ extern "C" {
  ****************************************/
 
 #define uEchoControllerPostResponseMaxMiliTime 5000
+
+enum {
+  uEchoControllerPostResultResponse = 0,
+  uEchoControllerPostResultErrorResponse = 1,
+  uEchoControllerPostResultTimeout = 2,
+};
   
 /****************************************
 * Data Type
@@ -33,7 +39,10 @@ extern "C" {
 typedef void uEchoController;
 #endif
   
+typedef int uEchoControllerPostResult;
+
 typedef void (*uEchoControllerMessageListener)(uEchoController *, uEchoMessage *);
+typedef void (*uEchoControllerPostResponseListener)(uEchoController *, uEchoControllerPostResult, uEchoMessage *, void *);
 
 /****************************************
  * Function
@@ -43,12 +52,21 @@ uEchoController *uecho_controller_new(void);
 bool uecho_controller_delete(uEchoController *ctrl);
 
 void uecho_controller_disableudpserver(uEchoController *ctrl);
+void uecho_controller_enableeventloop(uEchoController *ctrl);
+void uecho_controller_enableuring(uEchoController *ctrl);
+bool uecho_controller_setudpworkercount(uEchoController *ctrl, size_t workerCnt);
+bool uecho_controller_seteventloopworkercount(uEchoController *ctrl, size_t workerCnt);
+bool uecho_controller_setrecvbuffer(uEchoController *ctrl, size_t bufSize, size_t queueSize);
+size_t uecho_controller_gettruncatedcount(uEchoController *ctrl);
 
 bool uecho_controller_addnode(uEchoController *ctrl, uEchoNode *node);
 uEchoNode *uecho_controller_getnodebyaddress(uEchoController *ctrl, const char *addr);
 uEchoNode *uecho_controller_getnodes(uEchoController *ctrl);
 size_t uecho_controller_getnodecount(uEchoController *ctrl);
 
+size_t uecho_controller_getobjectsbycode(uEchoController *ctrl, uEchoObjectCode code, uEchoObject **objs, size_t maxObjCnt);
+size_t uecho_controller_getobjectsbyclasscode(uEchoController *ctrl, uEchoClassCode code, uEchoObject **objs, size_t maxObjCnt);
+
 void uecho_controller_setmessagelistener(uEchoController *ctrl, uEchoControllerMessageListener listener);
 uEchoControllerMessageListener uecho_controller_getmessagelistener(uEchoController *ctrl);
 bool uecho_controller_hasmessagelistener(uEchoController *ctrl);
@@ -62,6 +80,7 @@ bool uecho_controller_sendmessage(uEchoController *ctrl, uEchoObject *obj, uEcho
 void uecho_controller_setpostwaitemilitime(uEchoController *ctrl, clock_t mtime);
 clock_t uecho_controller_getpostwaitemilitime(uEchoController *ctrl);
 bool uecho_controller_postmessage(uEchoController *ctrl, uEchoObject *obj, uEchoMessage *reqMsg, uEchoMessage *resMsg);
+bool uecho_controller_postmessageasync(uEchoController *ctrl, uEchoObject *obj, uEchoMessage *reqMsg, uEchoControllerPostResponseListener listener, void *userData);
 
 bool uecho_controller_start(uEchoController *ctrl);
 bool uecho_controller_stop(uEchoController *ctrl);
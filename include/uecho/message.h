@@ -64,6 +64,7 @@ bool uecho_message_delete(uEchoMessage *msg);
 bool uecho_message_clear(uEchoMessage *msg);
 
 bool uecho_message_parse(uEchoMessage *msg, const byte *data, size_t dataLen);
+bool uecho_message_parseview(uEchoMessage *msg, const byte *data, size_t dataLen);
 
 void uecho_message_setehd1(uEchoMessage *msg, byte val);
 byte uecho_message_getehd1(uEchoMessage *msg);
@@ -96,6 +97,7 @@ bool uecho_message_clearproperties(uEchoMessage *msg);
 
 size_t uecho_message_size(uEchoMessage *msg);
 byte *uecho_message_getbytes(uEchoMessage *msg);
+size_t uecho_message_writebytes(uEchoMessage *msg, byte *buf, size_t bufLen);
 
 void uecho_message_setsourceaddress(uEchoMessage *msg, const char *addr);
 const char *uecho_message_getsourceaddress(uEchoMessage *msg);
@@ -58,6 +58,11 @@ bool uecho_node_setobject(uEchoNode *node, uEchoObjectCode code);
 bool uecho_node_start(uEchoNode *node);
 bool uecho_node_stop(uEchoNode *node);
 bool uecho_node_isrunning(uEchoNode *node);
+void uecho_node_enableeventloop(uEchoNode *node);
+bool uecho_node_seteventloopworkercount(uEchoNode *node, size_t workerCnt);
+void uecho_node_enableuring(uEchoNode *node);
+bool uecho_node_setrecvbuffer(uEchoNode *node, size_t bufSize, size_t queueSize);
+size_t uecho_node_gettruncatedcount(uEchoNode *node);
 
 bool uecho_node_setmanufacturercode(uEchoNode *node, uEchoManufacturerCode code);
 
@@ -12,11 +12,20 @@
 #define _UECHO_UTIL_TIME_H_
 
 #include <uecho/typedef.h>
+#include <stdint.h>
 
 #ifdef  __cplusplus
 extern "C" {
 #endif
 
+/****************************************
+* Data Type
+****************************************/
+
+typedef int64_t uEchoMiliTime;
+
+#define uEchoMiliTimeMax INT64_MAX
+
 /****************************************
 * Function
 ****************************************/
@@ -30,6 +39,7 @@ void uecho_waitrandom(clock_t mtime);
 #define uecho_sleeprandom(val) uecho_waitrandom(val)
 
 clock_t uecho_getcurrentsystemtime(void);
+uEchoMiliTime uecho_getcurrentsystemmilitime(void);
 
 #ifdef  __cplusplus
 }
@@ -10,8 +10,8 @@
 
 #include <uecho/controller_internal.h>
 #include <uecho/profile.h>
-
-#define uEchoControllerPostResponseLoopCount 50
+#include <uecho/misc.h>
+#include <uecho/util/timer.h>
 
 /****************************************
  * uecho_controller_new
@@ -21,6 +21,7 @@ uEchoController *uecho_controller_new(void)
 {
   uEchoController *ctrl;
   uEchoServer *server;
+  int n;
 
   ctrl = (uEchoController *)malloc(sizeof(uEchoController));
 
@@ -28,10 +29,20 @@ uEchoController *uecho_controller_new(void)
     return NULL;
 
   ctrl->mutex = uecho_mutex_new();
+  ctrl->nodeMutex = uecho_mutex_new();
   ctrl->node = uecho_node_new();
   ctrl->nodes = uecho_nodelist_new();
+  ctrl->nodeIndex = uecho_nodeindex_new();
+  ctrl->unindexedNodeCnt = 0;
+  ctrl->objIndex = uecho_objectmultiindex_new();
+  ctrl->clsIndex = uecho_objectmultiindex_new();
   ctrl->option = uEchoOptionNone;
   
+  for (n=0; n<uEchoControllerPostRequestTableSize; n++) {
+    ctrl->postReqs[n] = uecho_postrequestlist_new();
+  }
+  ctrl->postReqThread = NULL;
+  
   server = uecho_node_getserver(ctrl->node);
   uecho_server_setuserdata(server, ctrl);
   uecho_server_setmessagelistener(server, uecho_controller_servermessagelistener);
@@ -39,8 +50,6 @@ uEchoController *uecho_controller_new(void)
   uecho_controller_setuserdata(ctrl, NULL);
   uecho_controller_setlasttid(ctrl, 0);
   uecho_controller_setmessagelistener(ctrl, NULL);
-  uecho_controller_setpostrequestmessage(ctrl, NULL);
-  uecho_controller_setpostresponsemessage(ctrl, NULL);
   uecho_controller_setpostwaitemilitime(ctrl, uEchoControllerPostResponseMaxMiliTime);
   
   return ctrl;
@@ -52,14 +61,28 @@ uEchoController *uecho_controller_new(void)
 
 bool uecho_controller_delete(uEchoController *ctrl)
 {
+  int n;
+  
   if (!ctrl)
     return false;
   
   uecho_controller_stop(ctrl);
   
+  // No response arrives after the controller is stopped, so pending asynchronous requests time out now
+  
+  uecho_controller_expirepostrequests(ctrl, uEchoMiliTimeMax);
+  
   uecho_mutex_delete(ctrl->mutex);
   uecho_node_delete(ctrl->node);
+  uecho_mutex_delete(ctrl->nodeMutex);
+  uecho_nodeindex_delete(ctrl->nodeIndex);
   uecho_nodelist_delete(ctrl->nodes);
+  uecho_objectmultiindex_delete(ctrl->objIndex);
+  uecho_objectmultiindex_delete(ctrl->clsIndex);
+  
+  for (n=0; n<uEchoControllerPostRequestTableSize; n++) {
+    uecho_postrequestlist_delete(ctrl->postReqs[n]);
+  }
 
   free(ctrl);
 
@@ -102,6 +125,26 @@ bool uecho_controller_hasmessagelistener(uEchoController *ctrl)
   return ctrl->msgListener ? true : false;
 }
 
+/****************************************
+ * uecho_controller_postrequestaction
+ ****************************************/
+
+static void uecho_controller_postrequestaction(uEchoThread *thread)
+{
+  uEchoController *ctrl;
+  
+  ctrl = (uEchoController *)uecho_thread_getuserdata(thread);
+  if (!ctrl)
+    return;
+  
+  while (uecho_thread_isrunnable(thread)) {
+    uecho_sleep(uEchoControllerPostRequestCheckMiliTime);
+    if (!uecho_thread_isrunnable(thread))
+      break;
+    uecho_controller_expirepostrequests(ctrl, uecho_getcurrentsystemmilitime());
+  }
+}
+
 /****************************************
  * uecho_controller_start
  ****************************************/
@@ -113,9 +156,22 @@ bool uecho_controller_start(uEchoController *ctrl)
   if (!ctrl)
     return false;
   
+  uecho_controller_locknodes(ctrl);
+  uecho_nodeindex_clear(ctrl->nodeIndex);
+  ctrl->unindexedNodeCnt = 0;
   allActionsSucceeded &= uecho_nodelist_clear(ctrl->nodes);
+  uecho_objectmultiindex_clear(ctrl->objIndex);
+  uecho_objectmultiindex_clear(ctrl->clsIndex);
+  uecho_controller_unlocknodes(ctrl);
   allActionsSucceeded &= uecho_node_start(ctrl->node);
   
+  if (!ctrl->postReqThread) {
+    ctrl->postReqThread = uecho_thread_new();
+    uecho_thread_setaction(ctrl->postReqThread, uecho_controller_postrequestaction);
+    uecho_thread_setuserdata(ctrl->postReqThread, ctrl);
+    allActionsSucceeded &= uecho_thread_start(ctrl->postReqThread);
+  }
+  
   return allActionsSucceeded;
 }
 
@@ -132,6 +188,12 @@ bool uecho_controller_stop(uEchoController *ctrl)
 
   allActionsSucceeded &= uecho_node_stop(ctrl->node);
   
+  if (ctrl->postReqThread) {
+    allActionsSucceeded &= uecho_thread_stop(ctrl->postReqThread);
+    uecho_thread_delete(ctrl->postReqThread);
+    ctrl->postReqThread = NULL;
+  }
+  
   return allActionsSucceeded;
 }
 
@@ -150,12 +212,68 @@ bool uecho_controller_isrunning(uEchoController *ctrl)
   return true;
 }
 
+/****************************************
+ * uecho_controller_nodeobjectlistener
+ ****************************************/
+
+static void uecho_controller_nodeobjectlistener(uEchoNode *node, uEchoObject *obj, uEchoObjectCode objCode, bool isAdded)
+{
+  uEchoController *ctrl;
+  
+  ctrl = (uEchoController *)uecho_node_getobjectlistenerdata(node);
+  if (!ctrl)
+    return;
+  
+  if (isAdded) {
+    uecho_objectmultiindex_add(ctrl->objIndex, objCode, obj);
+    uecho_objectmultiindex_add(ctrl->clsIndex, uecho_objectcode2classcode(objCode), obj);
+  }
+  else {
+    uecho_objectmultiindex_remove(ctrl->objIndex, objCode, obj);
+    uecho_objectmultiindex_remove(ctrl->clsIndex, uecho_objectcode2classcode(objCode), obj);
+  }
+}
+
 /****************************************
  * uecho_controller_addnode
  ****************************************/
 
 bool uecho_controller_addnode(uEchoController *ctrl, uEchoNode *node)
 {
+  bool isAdded;
+  
+  if (!ctrl || !node)
+    return false;
+  
+  uecho_controller_locknodes(ctrl);
+  isAdded = uecho_controller_registernode(ctrl, node);
+  uecho_controller_unlocknodes(ctrl);
+  
+  return isAdded;
+}
+
+/****************************************
+ * uecho_controller_registernode
+ ****************************************/
+
+bool uecho_controller_registernode(uEchoController *ctrl, uEchoNode *node)
+{
+  uEchoObject *obj;
+  
+  if (!ctrl || !node)
+    return false;
+  
+  // Objects are indexed as they are added to the node, the existing ones are indexed here
+  
+  uecho_node_setobjectlistener(node, uecho_controller_nodeobjectlistener, ctrl);
+  for (obj = uecho_node_getobjects(node); obj; obj = uecho_object_next(obj))
+    uecho_controller_nodeobjectlistener(node, obj, uecho_object_getcode(obj), true);
+  
+  // The node is indexed by the address set before it is added
+  
+  if (!uecho_nodeindex_add(ctrl->nodeIndex, node))
+    ctrl->unindexedNodeCnt++;
+  
   return uecho_nodelist_add(ctrl->nodes, node);
 }
 
@@ -183,13 +301,69 @@ uEchoNode *uecho_controller_getnodes(uEchoController *ctrl)
 
 uEchoNode *uecho_controller_getnodebyaddress(uEchoController *ctrl, const char *addr)
 {
+  uEchoSocketAddress sockAddr;
   uEchoNode *node;
   
   if (!ctrl)
     return NULL;
 
+  uecho_controller_locknodes(ctrl);
+  
+  if (uecho_socket_address_setstring(&sockAddr, addr)) {
+    node = uecho_controller_findnodebysocketaddress(ctrl, &sockAddr);
+  }
+  else {
+    for (node = uecho_controller_getnodes(ctrl); node; node = uecho_node_next(node)) {
+      if (uecho_node_isaddress(node, addr))
+        break;
+    }
+  }
+  
+  uecho_controller_unlocknodes(ctrl);
+  
+  return node;
+}
+
+/****************************************
+ * uecho_controller_getnodebysocketaddress
+ ****************************************/
+
+uEchoNode *uecho_controller_getnodebysocketaddress(uEchoController *ctrl, const uEchoSocketAddress *sockAddr)
+{
+  uEchoNode *node;
+  
+  if (!ctrl || !sockAddr)
+    return NULL;
+  
+  uecho_controller_locknodes(ctrl);
+  node = uecho_controller_findnodebysocketaddress(ctrl, sockAddr);
+  uecho_controller_unlocknodes(ctrl);
+  
+  return node;
+}
+
+/****************************************
+ * uecho_controller_findnodebysocketaddress
+ ****************************************/
+
+uEchoNode *uecho_controller_findnodebysocketaddress(uEchoController *ctrl, const uEchoSocketAddress *sockAddr)
+{
+  uEchoNode *node;
+  
+  if (!ctrl || !sockAddr)
+    return NULL;
+  
+  node = uecho_nodeindex_getbysocketaddress(ctrl->nodeIndex, sockAddr);
+  if (node)
+    return node;
+  
+  // Nodes added without an address are not indexed
+  
+  if (ctrl->unindexedNodeCnt <= 0)
+    return NULL;
+  
   for (node = uecho_controller_getnodes(ctrl); node; node = uecho_node_next(node)) {
-    if (uecho_node_isaddress(node, addr))
+    if (uecho_node_issocketaddress(node, sockAddr))
       return node;
   }
   
@@ -202,19 +376,52 @@ uEchoNode *uecho_controller_getnodebyaddress(uEchoController *ctrl, const char *
 
 uEchoObject *uecho_controller_getobjectbycode(uEchoController *ctrl, uEchoObjectCode code)
 {
-  uEchoNode *node;
   uEchoObject *obj;
   
   if (!ctrl)
     return  NULL;
   
-  for (node = uecho_controller_getnodes(ctrl); node; node = uecho_node_next(node)) {
-    obj = uecho_node_getobjectbycode(node, code);
-    if (obj)
-      return obj;
-  }
+  uecho_controller_locknodes(ctrl);
+  obj = uecho_objectmultiindex_getobject(ctrl->objIndex, code);
+  uecho_controller_unlocknodes(ctrl);
   
-  return NULL;
+  return obj;
+}
+
+/****************************************
+ * uecho_controller_getobjectsbycode
+ ****************************************/
+
+size_t uecho_controller_getobjectsbycode(uEchoController *ctrl, uEchoObjectCode code, uEchoObject **objs, size_t maxObjCnt)
+{
+  size_t objCnt;
+  
+  if (!ctrl)
+    return 0;
+  
+  uecho_controller_locknodes(ctrl);
+  objCnt = uecho_objectmultiindex_getobjects(ctrl->objIndex, code, objs, maxObjCnt);
+  uecho_controller_unlocknodes(ctrl);
+  
+  return objCnt;
+}
+
+/****************************************
+ * uecho_controller_getobjectsbyclasscode
+ ****************************************/
+
+size_t uecho_controller_getobjectsbyclasscode(uEchoController *ctrl, uEchoClassCode code, uEchoObject **objs, size_t maxObjCnt)
+{
+  size_t objCnt;
+  
+  if (!ctrl)
+    return 0;
+  
+  uecho_controller_locknodes(ctrl);
+  objCnt = uecho_objectmultiindex_getobjects(ctrl->clsIndex, code, objs, maxObjCnt);
+  uecho_controller_unlocknodes(ctrl);
+  
+  return objCnt;
 }
 
 /****************************************
@@ -283,6 +490,72 @@ void uecho_controller_disableudpserver(uEchoController *ctrl)
   uecho_controller_enableoption(ctrl, uEchoControllerOptionDisableUdpServer);
 }
 
+/****************************************
+ * uecho_controller_enableeventloop
+ ****************************************/
+
+void uecho_controller_enableeventloop(uEchoController *ctrl)
+{
+  uecho_controller_enableoption(ctrl, uEchoControllerOptionEnableEventLoop);
+}
+
+/****************************************
+ * uecho_controller_enableuring
+ ****************************************/
+
+void uecho_controller_enableuring(uEchoController *ctrl)
+{
+  uecho_controller_enableoption(ctrl, uEchoControllerOptionEnableUring);
+}
+
+/****************************************
+ * uecho_controller_setudpworkercount
+ ****************************************/
+
+bool uecho_controller_setudpworkercount(uEchoController *ctrl, size_t workerCnt)
+{
+  if (!ctrl)
+    return false;
+  
+  return uecho_server_setudpworkercount(uecho_node_getserver(ctrl->node), workerCnt);
+}
+
+/****************************************
+ * uecho_controller_seteventloopworkercount
+ ****************************************/
+
+bool uecho_controller_seteventloopworkercount(uEchoController *ctrl, size_t workerCnt)
+{
+  if (!ctrl)
+    return false;
+  
+  return uecho_node_seteventloopworkercount(ctrl->node, workerCnt);
+}
+
+/****************************************
+ * uecho_controller_setrecvbuffer
+ ****************************************/
+
+bool uecho_controller_setrecvbuffer(uEchoController *ctrl, size_t bufSize, size_t queueSize)
+{
+  if (!ctrl)
+    return false;
+  
+  return uecho_node_setrecvbuffer(ctrl->node, bufSize, queueSize);
+}
+
+/****************************************
+ * uecho_controller_gettruncatedcount
+ ****************************************/
+
+size_t uecho_controller_gettruncatedcount(uEchoController *ctrl)
+{
+  if (!ctrl)
+    return 0;
+  
+  return uecho_node_gettruncatedcount(ctrl->node);
+}
+
 /****************************************
  * uecho_controller_setuserdata
  ****************************************/
@@ -335,16 +608,24 @@ uEchoTID uecho_controller_getlasttid(uEchoController *ctrl)
 
 uEchoTID uecho_controller_getnexttid(uEchoController *ctrl)
 {
+  uEchoTID nextTID;
+  
   if (!ctrl)
     return 0;
   
+  uecho_mutex_lock(ctrl->mutex);
+  
   if (uEchoTidMax <= ctrl->lastTID) {
     ctrl->lastTID = 1;
   }
   else {
     ctrl->lastTID++;
   }
-  return ctrl->lastTID;
+  nextTID = ctrl->lastTID;
+  
+  uecho_mutex_unlock(ctrl->mutex);
+  
+  return nextTID;
 }
 
 /****************************************
@@ -372,6 +653,18 @@ bool uecho_controller_announcemessage(uEchoController *ctrl, uEchoMessage *msg)
  ****************************************/
 
 bool uecho_controller_sendmessage(uEchoController *ctrl, uEchoObject *obj, uEchoMessage *msg)
+{
+  if (!ctrl)
+    return false;
+  
+  return uecho_controller_sendmessagewithtid(ctrl, obj, msg, uecho_controller_getnexttid(ctrl));
+}
+
+/****************************************
+ * uecho_controller_sendmessagewithtid
+ ****************************************/
+
+bool uecho_controller_sendmessagewithtid(uEchoController *ctrl, uEchoObject *obj, uEchoMessage *msg, uEchoTID tid)
 {
   uEchoObject *nodeProfObj;
   
@@ -384,105 +677,128 @@ bool uecho_controller_sendmessage(uEchoController *ctrl, uEchoObject *obj, uEcho
   if (!nodeProfObj)
     return false;
 
-  uecho_message_settid(msg, uecho_controller_getnexttid(ctrl));
+  uecho_message_settid(msg, tid);
   
   return uecho_object_sendmessage(nodeProfObj, obj, msg);
 }
 
 /****************************************
- * uecho_controller_setpostrequestmessage
+ * uecho_controller_addpostrequest
  ****************************************/
 
-void uecho_controller_setpostrequestmessage(uEchoController *ctrl, uEchoMessage *msg)
+bool uecho_controller_addpostrequest(uEchoController *ctrl, uEchoPostRequest *req)
 {
-  ctrl->postReqMsg = msg;
-}
-
-/****************************************
- * uecho_controller_getpostresponsemessage
- ****************************************/
-
-uEchoMessage *uecho_controller_getpostrequestmessage(uEchoController *ctrl)
-{
-  return ctrl->postReqMsg;
-}
-
-/****************************************
- * uecho_controller_haspostresponsemessage
- ****************************************/
-
-bool uecho_controller_haspostrequestmessage(uEchoController *ctrl)
-{
-  return ctrl->postReqMsg ? true : false;
-}
-
-/****************************************
- * uecho_controller_setpostresponsemessage
- ****************************************/
-
-void uecho_controller_setpostresponsemessage(uEchoController *ctrl, uEchoMessage *msg)
-{
-  ctrl->postResMsg = msg;
-}
-
-/****************************************
- * uecho_controller_getpostresponsemessage
- ****************************************/
-
-uEchoMessage *uecho_controller_getpostresponsemessage(uEchoController *ctrl)
-{
-  return ctrl->postResMsg;
-}
-
-/****************************************
- * uecho_controller_haspostresponsemessage
- ****************************************/
-
-bool uecho_controller_haspostresponsemessage(uEchoController *ctrl)
-{
-  return ctrl->postResMsg ? true : false;
+  bool isAdded;
+  
+  if (!ctrl || !req)
+    return false;
+  
+  uecho_mutex_lock(ctrl->mutex);
+  isAdded = uecho_postrequestlist_add(uecho_controller_getpostrequestlist(ctrl, uecho_postrequest_gettid(req)), req);
+  uecho_mutex_unlock(ctrl->mutex);
+  
+  return isAdded;
 }
 
 /****************************************
- * uecho_controller_haspostresponsemessage
+ * uecho_controller_removepostrequest
  ****************************************/
 
-bool uecho_controller_ispostresponsemessage(uEchoController *ctrl, uEchoMessage *msg)
+bool uecho_controller_removepostrequest(uEchoController *ctrl, uEchoPostRequest *req)
 {
-  if (!ctrl)
+  if (!ctrl || !req)
     return false;
   
-  if (!uecho_controller_haspostrequestmessage(ctrl))
-    return false;
+  uecho_mutex_lock(ctrl->mutex);
+  uecho_postrequest_remove(req);
+  uecho_mutex_unlock(ctrl->mutex);
   
-  return uecho_message_isresponsemessage(ctrl->postReqMsg, msg);
+  return true;
 }
 
 /****************************************
- * uecho_controller_ispostresponsereceived
+ * uecho_controller_handlepostresponse
  ****************************************/
 
-bool uecho_controller_ispostresponsereceived(uEchoController *ctrl)
+bool uecho_controller_handlepostresponse(uEchoController *ctrl, uEchoMessage *msg)
 {
-  if (!ctrl)
-    return false;
+  uEchoPostRequest *req;
+  bool isHandled;
   
-  if (!uecho_controller_haspostrequestmessage(ctrl) || !uecho_controller_haspostresponsemessage(ctrl))
+  if (!ctrl || !msg)
     return false;
   
-  return uecho_message_isresponsemessage(ctrl->postReqMsg, ctrl->postResMsg);
+  isHandled = false;
+  
+  uecho_mutex_lock(ctrl->mutex);
+  
+  req = uecho_postrequestlist_getbyresponsemessage(uecho_controller_getpostrequestlist(ctrl, uecho_message_gettid(msg)), msg);
+  if (req && !uecho_postrequest_isresponsereceived(req)) {
+    if (uecho_postrequest_isasync(req)) {
+      uecho_postrequest_remove(req);
+    }
+    else {
+      isHandled = uecho_postrequest_setresponse(req, msg);
+      req = NULL;
+    }
+  }
+  else {
+    req = NULL;
+  }
+  
+  uecho_mutex_unlock(ctrl->mutex);
+  
+  // Asynchronous requests are notified outside of the lock to allow posting from the listener
+  
+  if (req) {
+    isHandled = uecho_postrequest_notifyresponse(req, ctrl, msg);
+    uecho_postrequest_delete(req);
+  }
+  
+  return isHandled;
 }
 
 /****************************************
- * uecho_controller_ispostresponsewaiting
+ * uecho_controller_expirepostrequests
  ****************************************/
 
-bool uecho_controller_ispostresponsewaiting(uEchoController *ctrl)
+size_t uecho_controller_expirepostrequests(uEchoController *ctrl, uEchoMiliTime now)
 {
-  if (!uecho_controller_haspostrequestmessage(ctrl) || !uecho_controller_haspostresponsemessage(ctrl))
-    return false;
+  uEchoPostRequestList *expiredReqs;
+  uEchoPostRequest *req, *nextReq;
+  size_t expiredCnt;
+  int n;
   
-  return true;
+  if (!ctrl)
+    return 0;
+  
+  expiredReqs = uecho_postrequestlist_new();
+  if (!expiredReqs)
+    return 0;
+  
+  uecho_mutex_lock(ctrl->mutex);
+  
+  for (n=0; n<uEchoControllerPostRequestTableSize; n++) {
+    for (req = uecho_postrequestlist_gets(ctrl->postReqs[n]); req; req = nextReq) {
+      nextReq = uecho_postrequest_next(req);
+      if (!uecho_postrequest_isasync(req) || !uecho_postrequest_isexpired(req, now))
+        continue;
+      uecho_postrequest_remove(req);
+      uecho_postrequestlist_add(expiredReqs, req);
+    }
+  }
+  
+  uecho_mutex_unlock(ctrl->mutex);
+  
+  expiredCnt = uecho_postrequestlist_size(expiredReqs);
+  
+  for (req = uecho_postrequestlist_gets(expiredReqs); req; req = uecho_postrequest_next(req)) {
+    uecho_postrequest_notifyresponse(req, ctrl, NULL);
+  }
+  
+  uecho_postrequestlist_delete(expiredReqs);
+  
+  return expiredCnt;
 }
 
 /****************************************
@@ -515,35 +831,109 @@ clock_t uecho_controller_getpostwaitemilitime(uEchoController *ctrl)
 
 bool uecho_controller_postmessage(uEchoController *ctrl, uEchoObject *obj, uEchoMessage *reqMsg, uEchoMessage *resMsg)
 {
+  uEchoPostRequest *req;
   bool isResponceReceived;
-  int n;
   
-  if (!ctrl)
+  if (!ctrl || !obj || !reqMsg)
     return false;
   
-  uecho_mutex_lock(ctrl->mutex);
+  // Register the request before sending it not to miss a quick response
+  
+  req = uecho_postrequest_new();
+  if (!req)
+    return false;
   
-  uecho_controller_setpostrequestmessage(ctrl, reqMsg);
-  uecho_controller_setpostresponsemessage(ctrl, resMsg);
+  uecho_postrequest_settid(req, uecho_controller_getnexttid(ctrl));
+  uecho_postrequest_setesv(req, uecho_message_getesv(reqMsg));
+  uecho_postrequest_setdestination(req, uecho_node_getaddress(uecho_object_getparentnode(obj)), uecho_object_getcode(obj));
+  uecho_postrequest_setresponsemessage(req, resMsg);
   
-  if (!uecho_controller_sendmessage(ctrl, obj, reqMsg))
+  if (!uecho_controller_addpostrequest(ctrl, req)) {
+    uecho_postrequest_delete(req);
     return false;
-
+  }
+  
   isResponceReceived = false;
-  for (n=0; n<uEchoControllerPostResponseLoopCount; n++) {
-    uecho_sleep(ctrl->postResWaitMiliTime / uEchoControllerPostResponseLoopCount);
-    if (uecho_controller_ispostresponsereceived(ctrl)) {
-      isResponceReceived = true;
-      break;
-    }
+  
+  if (uecho_controller_sendmessagewithtid(ctrl, obj, reqMsg, uecho_postrequest_gettid(req))) {
+    uecho_mutex_lock(ctrl->mutex);
+    isResponceReceived = uecho_postrequest_waitresponse(req, ctrl->mutex, ctrl->postResWaitMiliTime);
+    uecho_mutex_unlock(ctrl->mutex);
+  }
+  
+  uecho_controller_removepostrequest(ctrl, req);
+  uecho_postrequest_delete(req);
+  
+  return isResponceReceived;
+}
+
+/****************************************
+ * uecho_controller_ispostrequestpending
+ ****************************************/
+
+static bool uecho_controller_ispostrequestpending(uEchoController *ctrl, uEchoPostRequest *req, uEchoTID tid)
+{
+  uEchoPostRequest *pendingReq;
+  
+  // The request may have been released already, so it is only compared with the pending requests
+  
+  for (pendingReq = uecho_postrequestlist_gets(uecho_controller_getpostrequestlist(ctrl, tid)); pendingReq; pendingReq = uecho_postrequest_next(pendingReq)) {
+    if ((pendingReq == req) && (uecho_postrequest_gettid(pendingReq) == tid))
+      return true;
+  }
+  
+  return false;
+}
+
+/****************************************
+ * uecho_controller_postmessageasync
+ ****************************************/
+
+bool uecho_controller_postmessageasync(uEchoController *ctrl, uEchoObject *obj, uEchoMessage *reqMsg, uEchoControllerPostResponseListener listener, void *userData)
+{
+  uEchoPostRequest *req;
+  uEchoTID tid;
+  bool isSent;
+  
+  if (!ctrl || !obj || !reqMsg || !listener)
+    return false;
+  
+  req = uecho_postrequest_new();
+  if (!req)
+    return false;
+  
+  uecho_postrequest_settid(req, uecho_controller_getnexttid(ctrl));
+  uecho_postrequest_setesv(req, uecho_message_getesv(reqMsg));
+  uecho_postrequest_setdestination(req, uecho_node_getaddress(uecho_object_getparentnode(obj)), uecho_object_getcode(obj));
+  uecho_postrequest_setresponselistener(req, listener, userData);
+  
+  // Register the request before sending it not to miss a quick response.
+  // The expire time is set after sending, so that the request does not expire while it is sent.
+  
+  tid = uecho_postrequest_gettid(req);
+  if (!uecho_controller_addpostrequest(ctrl, req)) {
+    uecho_postrequest_delete(req);
+    return false;
   }
   
-  uecho_controller_setpostrequestmessage(ctrl, NULL);
-  uecho_controller_setpostresponsemessage(ctrl, NULL);
+  isSent = uecho_controller_sendmessagewithtid(ctrl, obj, reqMsg, tid);
+  
+  // The request is released by the receive thread if the response has already been notified
+  
+  uecho_mutex_lock(ctrl->mutex);
+  
+  if (uecho_controller_ispostrequestpending(ctrl, req, tid)) {
+    if (isSent) {
+      uecho_postrequest_setexpiretime(req, (uecho_getcurrentsystemmilitime() + ctrl->postResWaitMiliTime));
+    }
+    else {
+      uecho_postrequest_delete(req);
+    }
+  }
   
   uecho_mutex_unlock(ctrl->mutex);
   
-  return isResponceReceived;
+  return isSent;
 }
 
 /****************************************
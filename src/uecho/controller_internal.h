@@ -14,6 +14,8 @@
 #include <uecho/typedef.h>
 #include <uecho/const.h>
 #include <uecho/util/mutex.h>
+#include <uecho/util/thread.h>
+#include <uecho/util/timer.h>
 #include <uecho/node_internal.h>
 
 #ifdef  __cplusplus
@@ -26,24 +28,55 @@ extern "C" {
 
 enum {
   uEchoControllerOptionDisableUdpServer = uEchoServerOptionDisableUdpServer,
+  uEchoControllerOptionEnableEventLoop = uEchoServerOptionEnableEventLoop,
+  uEchoControllerOptionEnableUring = uEchoServerOptionEnableUring,
+};
+
+enum {
+  uEchoControllerPostRequestTableSize = 64,
+  uEchoControllerPostRequestCheckMiliTime = 50,
 };
   
 /****************************************
 * Data Type
 ****************************************/
 
+struct _uEchoController;
+
+typedef struct _uEchoPostRequest {
+  UECHO_LIST_STRUCT_MEMBERS
+  
+  uEchoTID tid;
+  uEchoEsv esv;
+  char *dstAddr;
+  uEchoSocketAddress dstSockAddr;
+  uEchoObjectCode dstObjCode;
+  uEchoMessage *resMsg;
+  bool isResponseReceived;
+  uEchoCond *cond;
+  
+  void (*resListener)(struct _uEchoController *, int, uEchoMessage *, void *); /* uEchoControllerPostResponseListener */
+  void *userData;
+  uEchoMiliTime expireTime;
+} uEchoPostRequest, uEchoPostRequestList;
+
 typedef struct _uEchoController {
   uEchoMutex *mutex;
+  uEchoMutex *nodeMutex;
   uEchoNode *node;
   uEchoTID lastTID;
   uEchoNodeList *nodes;
+  uEchoNodeIndex *nodeIndex;
+  size_t unindexedNodeCnt;
+  uEchoObjectMultiIndex *objIndex;
+  uEchoObjectMultiIndex *clsIndex;
   void (*msgListener)(struct _uEchoController *, uEchoMessage *); /* uEchoControllerMessageListener */
   uEchoOption option;
   void *userData;
   
   clock_t postResWaitMiliTime;
-  uEchoMessage *postReqMsg;
-  uEchoMessage *postResMsg;
+  uEchoPostRequestList *postReqs[uEchoControllerPostRequestTableSize];
+  uEchoThread *postReqThread;
 } uEchoController;
 
 /****************************************
@@ -59,6 +92,14 @@ typedef struct _uEchoController {
 bool uecho_controller_searchallobjectswithesv(uEchoController *ctrl, uEchoEsv esv);
 bool uecho_controller_searchobjectwithesv(uEchoController *ctrl, byte objCode, uEchoEsv esv);
 
+// The found nodes are registered by the receive workers concurrently, so lock them while they are updated or looked up
+
+#define uecho_controller_locknodes(ctrl) uecho_mutex_lock(ctrl->nodeMutex)
+#define uecho_controller_unlocknodes(ctrl) uecho_mutex_unlock(ctrl->nodeMutex)
+
+bool uecho_controller_registernode(uEchoController *ctrl, uEchoNode *node);
+uEchoNode *uecho_controller_getnodebysocketaddress(uEchoController *ctrl, const uEchoSocketAddress *sockAddr);
+uEchoNode *uecho_controller_findnodebysocketaddress(uEchoController *ctrl, const uEchoSocketAddress *sockAddr); /* The nodes must be locked */
 uEchoObject *uecho_controller_getobjectbycode(uEchoController *ctrl, uEchoObjectCode code);
 uEchoObject *uecho_controller_getobjectbycodewithwait(uEchoController *ctrl, uEchoObjectCode code, clock_t waitMiliTime);
   
@@ -67,27 +108,69 @@ void uecho_controller_disableoption(uEchoController *ctrl, uEchoOption param);
 bool uecho_controller_isoptionenabled(uEchoController *ctrl, uEchoOption param);
 
 void uecho_controller_disableudpserver(uEchoController *ctrl);
+void uecho_controller_enableeventloop(uEchoController *ctrl);
+void uecho_controller_enableuring(uEchoController *ctrl);
 
 #define uecho_controller_enableudpserver(ctrl) uecho_controller_disableoption(ctrl, uEchoControllerOptionDisableUdpServer)
 #define uecho_controller_isudpserverenabled(ctrl) (!uecho_controller_isoptionenabled(ctrl, uEchoControllerOptionDisableUdpServer))
+#define uecho_controller_iseventloopenabled(ctrl) uecho_controller_isoptionenabled(ctrl, uEchoControllerOptionEnableEventLoop)
+#define uecho_controller_isuringenabled(ctrl) uecho_controller_isoptionenabled(ctrl, uEchoControllerOptionEnableUring)
 
 void uecho_controller_setlasttid(uEchoController *ctrl, uEchoTID tid);
 uEchoTID uecho_controller_getlasttid(uEchoController *ctrl);
 uEchoTID uecho_controller_getnexttid(uEchoController *ctrl);  
 
-void uecho_controller_setpostrequestmessage(uEchoController *ctrl, uEchoMessage *msg);
-uEchoMessage *uecho_controller_getpostrequestmessage(uEchoController *ctrl);
-bool uecho_controller_haspostrequestmessage(uEchoController *ctrl);
+bool uecho_controller_sendmessagewithtid(uEchoController *ctrl, uEchoObject *obj, uEchoMessage *msg, uEchoTID tid);
 
-void uecho_controller_setpostresponsemessage(uEchoController *ctrl, uEchoMessage *msg);
-uEchoMessage *uecho_controller_getpostresponsemessage(uEchoController *ctrl);
-bool uecho_controller_haspostresponsemessage(uEchoController *ctrl);
- 
-bool uecho_controller_ispostresponsemessage(uEchoController *ctrl, uEchoMessage *msg);
-bool uecho_controller_ispostresponsereceived(uEchoController *ctrl);
-bool uecho_controller_ispostresponsewaiting(uEchoController *ctrl);
+#define uecho_controller_getpostrequestlist(ctrl, tid) (ctrl->postReqs[(tid) % uEchoControllerPostRequestTableSize])
+bool uecho_controller_addpostrequest(uEchoController *ctrl, uEchoPostRequest *req);
+bool uecho_controller_removepostrequest(uEchoController *ctrl, uEchoPostRequest *req);
+bool uecho_controller_handlepostresponse(uEchoController *ctrl, uEchoMessage *msg);
+size_t uecho_controller_expirepostrequests(uEchoController *ctrl, uEchoMiliTime now);
 
 void uecho_controller_servermessagelistener(uEchoServer *server, uEchoMessage *msg);
+
+/****************************************
+ * Function (PostRequest)
+ ****************************************/
+
+uEchoPostRequest *uecho_postrequest_new(void);
+bool uecho_postrequest_delete(uEchoPostRequest *req);
+
+#define uecho_postrequest_next(req) (uEchoPostRequest *)uecho_list_next((uEchoList *)req)
+#define uecho_postrequest_remove(req) uecho_list_remove((uEchoList *)req)
+
+#define uecho_postrequest_settid(req, value) (req->tid = value)
+#define uecho_postrequest_gettid(req) (req->tid)
+#define uecho_postrequest_setesv(req, value) (req->esv = value)
+#define uecho_postrequest_getesv(req) (req->esv)
+#define uecho_postrequest_setresponsemessage(req, msg) (req->resMsg = msg)
+#define uecho_postrequest_getresponsemessage(req) (req->resMsg)
+#define uecho_postrequest_isresponsereceived(req) (req->isResponseReceived)
+
+bool uecho_postrequest_setdestination(uEchoPostRequest *req, const char *addr, uEchoObjectCode objCode);
+bool uecho_postrequest_isresponsemessage(uEchoPostRequest *req, uEchoMessage *msg);
+bool uecho_postrequest_setresponse(uEchoPostRequest *req, uEchoMessage *msg);
+bool uecho_postrequest_waitresponse(uEchoPostRequest *req, uEchoMutex *mutex, clock_t mtime);
+
+#define uecho_postrequest_isasync(req) (req->resListener ? true : false)
+#define uecho_postrequest_setexpiretime(req, value) (req->expireTime = value)
+#define uecho_postrequest_isexpired(req, now) ((0 < req->expireTime) && (req->expireTime <= now))
+void uecho_postrequest_setresponselistener(uEchoPostRequest *req, uEchoControllerPostResponseListener listener, void *userData);
+bool uecho_postrequest_notifyresponse(uEchoPostRequest *req, uEchoController *ctrl, uEchoMessage *msg);
+
+/****************************************
+ * Function (PostRequestList)
+ ****************************************/
+
+uEchoPostRequestList *uecho_postrequestlist_new(void);
+void uecho_postrequestlist_delete(uEchoPostRequestList *reqs);
+uEchoPostRequest *uecho_postrequestlist_getbyresponsemessage(uEchoPostRequestList *reqs, uEchoMessage *msg);
+
+#define uecho_postrequestlist_clear(reqs) uecho_list_clear((uEchoList *)reqs, (UECHO_LIST_DESTRUCTORFUNC)uecho_postrequest_delete)
+#define uecho_postrequestlist_size(reqs) uecho_list_size((uEchoList *)reqs)
+#define uecho_postrequestlist_gets(reqs) (uEchoPostRequest *)uecho_list_next((uEchoList *)reqs)
+#define uecho_postrequestlist_add(reqs,req) uecho_list_add((uEchoList *)reqs, (uEchoList *)req)
   
 #ifdef  __cplusplus
 }
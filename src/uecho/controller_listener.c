@@ -24,7 +24,7 @@ void uecho_controller_handlesearchmessage(uEchoController *ctrl, uEchoMessage *m
   byte *propData;
   size_t propSize, instanceSize;
   size_t idx;
-  const char *msgAddr;
+  const uEchoSocketAddress *msgSockAddr;
 
   // Check message
   
@@ -38,19 +38,25 @@ void uecho_controller_handlesearchmessage(uEchoController *ctrl, uEchoMessage *m
 
   // Get or create node
   
-  msgAddr = uecho_message_getsourceaddress(msg);
-  if (!msgAddr)
+  msgSockAddr = uecho_message_getsourcesocketaddress(msg);
+  if (!uecho_socket_address_isvalid(msgSockAddr))
     return;
   
-  node = uecho_controller_getnodebyaddress(ctrl, msgAddr);
+  uecho_controller_locknodes(ctrl);
+  
+  node = uecho_controller_findnodebysocketaddress(ctrl, msgSockAddr);
   if (!node) {
-    node = uecho_node_new();
-    if (!node)
+    node = uecho_node_remote_new();
+    if (!node) {
+      uecho_controller_unlocknodes(ctrl);
       return;
-    uecho_node_setaddress(node, uecho_message_getsourceaddress(msg));
-    uecho_controller_addnode(ctrl, node);
+    }
+    uecho_node_setsocketaddress(node, msgSockAddr);
+    uecho_controller_registernode(ctrl, node);
   }
   
+  uecho_node_setobject(node, uecho_message_getsourceobjectcode(msg));
+  
   // Updated node
   
   propData = uecho_property_getdata(prop);
@@ -61,6 +67,8 @@ void uecho_controller_handlesearchmessage(uEchoController *ctrl, uEchoMessage *m
     objCode = uecho_byte2integer((propData + idx), 3);
     uecho_node_setobject(node, objCode);
   }
+  
+  uecho_controller_unlocknodes(ctrl);
 }
 
 /****************************************
@@ -75,13 +83,14 @@ void uecho_controller_updatepropertydata(uEchoController *ctrl, uEchoMessage *ms
   uEchoPropertyCode msgPropCode;
   size_t msgOpc, n;
   
-  srcNode = uecho_controller_getnodebyaddress(ctrl, uecho_message_getsourceaddress(msg));
-  if (!srcNode)
-    return;
-
-  srcObj = uecho_node_getobjectbycode(srcNode, uecho_message_getsourceobjectcode(msg));
-  if (!srcObj)
+  uecho_controller_locknodes(ctrl);
+  
+  srcNode = uecho_controller_findnodebysocketaddress(ctrl, uecho_message_getsourcesocketaddress(msg));
+  srcObj = srcNode ? uecho_node_getobjectbycode(srcNode, uecho_message_getsourceobjectcode(msg)) : NULL;
+  if (!srcObj) {
+    uecho_controller_unlocknodes(ctrl);
     return;
+  }
   
   msgOpc = uecho_message_getopc(msg);
   for (n=0; n<msgOpc; n++) {
@@ -89,23 +98,10 @@ void uecho_controller_updatepropertydata(uEchoController *ctrl, uEchoMessage *ms
     if (!msgProp)
       continue;
     msgPropCode = uecho_property_getcode(msgProp);
-    if (!uecho_object_hasproperty(srcObj, msgPropCode)) {
-      uecho_object_setproperty(srcObj, msgPropCode, uEchoPropertyAttrNone);
-    }
-    uecho_object_setpropertydata(srcObj, msgPropCode, uecho_property_getdata(msgProp), uecho_property_getdatasize(msgProp));
+    uecho_object_cachepropertydata(srcObj, msgPropCode, uecho_property_getdata(msgProp), uecho_property_getdatasize(msgProp));
   }
-}
-
-/****************************************
- * uecho_controller_handlepostresponse
- ****************************************/
-
-void uecho_controller_handlepostresponse(uEchoController *ctrl, uEchoMessage *msg)
-{
-  if (!uecho_controller_ispostresponsemessage(ctrl, msg))
-    return;
-
-  uecho_message_set(uecho_controller_getpostresponsemessage(ctrl), msg);
+  
+  uecho_controller_unlocknodes(ctrl);
 }
 
 /****************************************
@@ -114,9 +110,7 @@ void uecho_controller_handlepostresponse(uEchoController *ctrl, uEchoMessage *ms
 
 void uecho_controller_handlerequestmessage(uEchoController *ctrl, uEchoMessage *msg)
 {
-  if (uecho_controller_ispostresponsewaiting(ctrl)) {
-    uecho_controller_handlepostresponse(ctrl, msg);
-  }
+  uecho_controller_handlepostresponse(ctrl, msg);
 
   if (uecho_message_issearchresponse(msg)) {
     uecho_controller_handlesearchmessage(ctrl, msg);
@@ -0,0 +1,489 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <uecho/core/event_loop.h>
+#include <uecho/util/timer.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_EPOLL)
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#endif
+
+/****************************************
+ * Static
+ ****************************************/
+
+static size_t uecho_event_loop_defaultworkercnt = uEchoEventLoopDefaultWorkerCount;
+
+#if defined(HAVE_EPOLL)
+static uEchoEventLoop *uecho_event_loop_shared = NULL;
+static pthread_mutex_t uecho_event_loop_sharedmutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#if defined(HAVE_EPOLL)
+
+/****************************************
+ * uecho_event_loop_rearmsource
+ ****************************************/
+
+static bool uecho_event_loop_rearmsource(uEchoEventLoop *loop, uEchoEventSource *source, int op)
+{
+  struct epoll_event event;
+
+  // Each source is armed for one event at a time so that only one worker handles a socket
+
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | EPOLLONESHOT;
+  event.data.u64 = source->id;
+
+  return (epoll_ctl(loop->epollFd, op, uecho_socket_getid(source->socket), &event) == 0) ? true : false;
+}
+
+/****************************************
+ * uecho_event_loop_dispatch
+ ****************************************/
+
+static void uecho_event_loop_dispatch(uEchoEventLoop *loop, uEchoEventLoopWorker *worker, size_t sourceId)
+{
+  uEchoEventSource *source;
+
+  // The source is looked up by the id because it might be removed while the event is pending
+
+  uecho_mutex_lock(loop->mutex);
+  for (source = (uEchoEventSource *)uecho_list_next((uEchoList *)loop->sources); source; source = (uEchoEventSource *)uecho_list_next((uEchoList *)source)) {
+    if (source->id == sourceId)
+      break;
+  }
+  if (!source || source->worker) {
+    uecho_mutex_unlock(loop->mutex);
+    return;
+  }
+  source->worker = worker;
+  worker->source = source;
+  uecho_mutex_unlock(loop->mutex);
+
+  source->handler(worker, source->userData);
+
+  uecho_mutex_lock(loop->mutex);
+  source->worker = NULL;
+  worker->source = NULL;
+  if (source->isRemoved) {
+    free(source);
+  }
+  else {
+    uecho_event_loop_rearmsource(loop, source, EPOLL_CTL_MOD);
+  }
+  uecho_mutex_unlock(loop->mutex);
+}
+
+/****************************************
+ * uecho_event_loop_action
+ ****************************************/
+
+static void uecho_event_loop_action(uEchoThread *thread)
+{
+  uEchoEventLoopWorker *worker;
+  uEchoEventLoop *loop;
+  struct epoll_event events[uEchoEventLoopMaxEventCount];
+  int eventCnt, n;
+
+  worker = (uEchoEventLoopWorker *)uecho_thread_getuserdata(thread);
+  if (!worker)
+    return;
+
+  loop = worker->loop;
+
+  // The receive buffers are owned by the worker and shared by all sockets it handles
+
+  for (n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    worker->dgmPkts[n] = uecho_socket_datagram_packet_new();
+  }
+  worker->arena = uecho_arena_new(uEchoEventLoopArenaSize);
+
+  // Wait with a timeout shorter than UECHO_THREAD_MIN_SLEEP to exit before the thread is deleted
+
+  while (uecho_thread_isrunnable(thread)) {
+    eventCnt = epoll_wait(loop->epollFd, events, uEchoEventLoopMaxEventCount, uEchoEventLoopWaitMiliTime);
+    if (!uecho_thread_isrunnable(thread))
+      break;
+    if (eventCnt < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    for (n=0; n<eventCnt; n++) {
+      uecho_event_loop_dispatch(loop, worker, (size_t)events[n].data.u64);
+    }
+  }
+
+  for (n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    uecho_socket_datagram_packet_delete(worker->dgmPkts[n]);
+    worker->dgmPkts[n] = NULL;
+  }
+  uecho_arena_delete(worker->arena);
+  worker->arena = NULL;
+}
+
+#endif
+
+/****************************************
+ * uecho_event_loop_new
+ ****************************************/
+
+uEchoEventLoop *uecho_event_loop_new(size_t workerCnt)
+{
+#if defined(HAVE_EPOLL)
+  uEchoEventLoop *loop;
+  size_t n;
+
+  if ((workerCnt <= 0) || (uEchoEventLoopMaxWorkerCount < workerCnt))
+    return NULL;
+
+  loop = (uEchoEventLoop *)malloc(sizeof(uEchoEventLoop));
+  if (!loop)
+    return NULL;
+
+  loop->epollFd = epoll_create1(0);
+  loop->mutex = uecho_mutex_new();
+  loop->sources = (uEchoEventSourceList *)malloc(sizeof(uEchoEventSourceList));
+  loop->lastSourceId = 0;
+  loop->workers = (uEchoEventLoopWorker *)calloc(workerCnt, sizeof(uEchoEventLoopWorker));
+  loop->workerCnt = workerCnt;
+  loop->refCnt = 0;
+
+  if ((loop->epollFd < 0) || !loop->mutex || !loop->sources || !loop->workers) {
+    if (0 <= loop->epollFd)
+      close(loop->epollFd);
+    uecho_mutex_delete(loop->mutex);
+    free(loop->sources);
+    free(loop->workers);
+    free(loop);
+    return NULL;
+  }
+
+  uecho_list_header_init((uEchoList *)loop->sources);
+
+  for (n=0; n<workerCnt; n++) {
+    loop->workers[n].loop = loop;
+  }
+
+  return loop;
+#else
+  return NULL;
+#endif
+}
+
+/****************************************
+ * uecho_event_loop_delete
+ ****************************************/
+
+bool uecho_event_loop_delete(uEchoEventLoop *loop)
+{
+#if defined(HAVE_EPOLL)
+  if (!loop)
+    return false;
+
+  uecho_event_loop_stop(loop);
+
+  uecho_list_clear((uEchoList *)loop->sources, NULL);
+  free(loop->sources);
+
+  close(loop->epollFd);
+  uecho_mutex_delete(loop->mutex);
+  free(loop->workers);
+  free(loop);
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/****************************************
+ * uecho_event_loop_start
+ ****************************************/
+
+bool uecho_event_loop_start(uEchoEventLoop *loop)
+{
+#if defined(HAVE_EPOLL)
+  uEchoEventLoopWorker *worker;
+  size_t n;
+
+  if (!loop)
+    return false;
+
+  uecho_event_loop_stop(loop);
+
+  for (n=0; n<loop->workerCnt; n++) {
+    worker = &loop->workers[n];
+    worker->thread = uecho_thread_new();
+    if (!worker->thread) {
+      uecho_event_loop_stop(loop);
+      return false;
+    }
+    uecho_thread_setaction(worker->thread, uecho_event_loop_action);
+    uecho_thread_setuserdata(worker->thread, worker);
+    if (!uecho_thread_start(worker->thread)) {
+      uecho_event_loop_stop(loop);
+      return false;
+    }
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/****************************************
+ * uecho_event_loop_stop
+ ****************************************/
+
+bool uecho_event_loop_stop(uEchoEventLoop *loop)
+{
+  uEchoEventLoopWorker *worker;
+  size_t n;
+
+  if (!loop)
+    return false;
+
+  for (n=0; n<loop->workerCnt; n++) {
+    worker = &loop->workers[n];
+    if (!worker->thread)
+      continue;
+    uecho_thread_stop(worker->thread);
+    uecho_thread_delete(worker->thread);
+    worker->thread = NULL;
+  }
+
+  return true;
+}
+
+/****************************************
+ * uecho_event_loop_isrunning
+ ****************************************/
+
+bool uecho_event_loop_isrunning(uEchoEventLoop *loop)
+{
+  size_t n;
+
+  if (!loop)
+    return false;
+
+  for (n=0; n<loop->workerCnt; n++) {
+    if (!uecho_thread_isrunning(loop->workers[n].thread))
+      return false;
+  }
+
+  return true;
+}
+
+/****************************************
+ * uecho_event_loop_addsocket
+ ****************************************/
+
+uEchoEventSource *uecho_event_loop_addsocket(uEchoEventLoop *loop, uEchoSocket *sock, uEchoEventLoopHandler handler, void *userData)
+{
+#if defined(HAVE_EPOLL)
+  uEchoEventSource *source;
+
+  if (!loop || !sock || !handler)
+    return NULL;
+
+  if (!uecho_socket_isbound(sock))
+    return NULL;
+
+  // The handlers read until the socket would block, so they never stall the other sockets
+
+  if (!uecho_socket_setblocking(sock, false))
+    return NULL;
+
+  source = (uEchoEventSource *)malloc(sizeof(uEchoEventSource));
+  if (!source)
+    return NULL;
+
+  uecho_list_node_init((uEchoList *)source);
+  source->socket = sock;
+  source->handler = handler;
+  source->userData = userData;
+  source->worker = NULL;
+  source->isRemoved = false;
+
+  uecho_mutex_lock(loop->mutex);
+  source->id = ++loop->lastSourceId;
+  uecho_list_add((uEchoList *)loop->sources, (uEchoList *)source);
+  if (!uecho_event_loop_rearmsource(loop, source, EPOLL_CTL_ADD)) {
+    uecho_list_remove((uEchoList *)source);
+    uecho_mutex_unlock(loop->mutex);
+    free(source);
+    return NULL;
+  }
+  uecho_mutex_unlock(loop->mutex);
+
+  return source;
+#else
+  return NULL;
+#endif
+}
+
+/****************************************
+ * uecho_event_loop_removesource
+ ****************************************/
+
+bool uecho_event_loop_removesource(uEchoEventLoop *loop, uEchoEventSource *source)
+{
+#if defined(HAVE_EPOLL)
+  if (!loop || !source)
+    return false;
+
+  uecho_mutex_lock(loop->mutex);
+
+  uecho_list_remove((uEchoList *)source);
+  epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, uecho_socket_getid(source->socket), NULL);
+
+  // A source removed by its own handler is released by the worker after the handler returns,
+  // otherwise wait for the worker handling it so that the socket can be closed safely
+
+  if (source->worker) {
+    if (uecho_thread_iscurrent(source->worker->thread)) {
+      source->isRemoved = true;
+      uecho_mutex_unlock(loop->mutex);
+      return true;
+    }
+    while (source->worker) {
+      uecho_mutex_unlock(loop->mutex);
+      uecho_wait(1);
+      uecho_mutex_lock(loop->mutex);
+    }
+  }
+
+  uecho_mutex_unlock(loop->mutex);
+
+  free(source);
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/****************************************
+ * uecho_event_loop_isdispatching
+ ****************************************/
+
+bool uecho_event_loop_isdispatching(uEchoEventLoop *loop, void *userData)
+{
+  uEchoEventLoopWorker *worker;
+  size_t n;
+
+  if (!loop)
+    return false;
+
+  for (n=0; n<loop->workerCnt; n++) {
+    worker = &loop->workers[n];
+    if (!uecho_thread_iscurrent(worker->thread))
+      continue;
+    if (!worker->source)
+      return false;
+    return (worker->source->userData == userData) ? true : false;
+  }
+
+  return false;
+}
+
+/****************************************
+ * uecho_event_loop_acquire
+ ****************************************/
+
+uEchoEventLoop *uecho_event_loop_acquire(size_t workerCnt)
+{
+#if defined(HAVE_EPOLL)
+  uEchoEventLoop *loop;
+
+  // All servers in the process share one loop, which runs while any server uses it.
+  // The worker count is applied when the loop is created, and zero means the default count.
+
+  pthread_mutex_lock(&uecho_event_loop_sharedmutex);
+
+  if (!uecho_event_loop_shared) {
+    uecho_event_loop_shared = uecho_event_loop_new((0 < workerCnt) ? workerCnt : uecho_event_loop_defaultworkercnt);
+    if (uecho_event_loop_shared && !uecho_event_loop_start(uecho_event_loop_shared)) {
+      uecho_event_loop_delete(uecho_event_loop_shared);
+      uecho_event_loop_shared = NULL;
+    }
+  }
+
+  loop = uecho_event_loop_shared;
+  if (loop)
+    loop->refCnt++;
+
+  pthread_mutex_unlock(&uecho_event_loop_sharedmutex);
+
+  return loop;
+#else
+  return NULL;
+#endif
+}
+
+/****************************************
+ * uecho_event_loop_release
+ ****************************************/
+
+void uecho_event_loop_release(uEchoEventLoop *loop)
+{
+#if defined(HAVE_EPOLL)
+  if (!loop)
+    return;
+
+  pthread_mutex_lock(&uecho_event_loop_sharedmutex);
+
+  if (0 < loop->refCnt)
+    loop->refCnt--;
+
+  if ((loop->refCnt == 0) && (loop == uecho_event_loop_shared)) {
+    uecho_event_loop_delete(loop);
+    uecho_event_loop_shared = NULL;
+  }
+
+  pthread_mutex_unlock(&uecho_event_loop_sharedmutex);
+#endif
+}
+
+/****************************************
+ * uecho_event_loop_setdefaultworkercount
+ ****************************************/
+
+bool uecho_event_loop_setdefaultworkercount(size_t workerCnt)
+{
+  if ((workerCnt <= 0) || (uEchoEventLoopMaxWorkerCount < workerCnt))
+    return false;
+
+  uecho_event_loop_defaultworkercnt = workerCnt;
+
+  return true;
+}
+
+/****************************************
+ * uecho_event_loop_getdefaultworkercount
+ ****************************************/
+
+size_t uecho_event_loop_getdefaultworkercount(void)
+{
+  return uecho_event_loop_defaultworkercnt;
+}
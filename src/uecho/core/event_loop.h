@@ -0,0 +1,108 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#ifndef _UECHO_EVENT_LOOP_H_
+#define _UECHO_EVENT_LOOP_H_
+
+#include <uecho/typedef.h>
+#include <uecho/net/socket.h>
+#include <uecho/util/arena.h>
+#include <uecho/util/list.h>
+#include <uecho/util/mutex.h>
+#include <uecho/util/thread.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/****************************************
+ * Constant
+ ****************************************/
+
+enum {
+  uEchoEventLoopDefaultWorkerCount = 1,
+  uEchoEventLoopMaxWorkerCount = 16,
+  uEchoEventLoopMaxEventCount = 16,
+  uEchoEventLoopWaitMiliTime = (UECHO_THREAD_MIN_SLEEP / 2),
+  uEchoEventLoopArenaSize = 4096,
+};
+
+/****************************************
+ * Data Type
+ ****************************************/
+
+struct _uEchoEventLoop;
+struct _uEchoEventLoopWorker;
+
+typedef struct _uEchoEventSource {
+  UECHO_LIST_STRUCT_MEMBERS
+
+  size_t id;
+  uEchoSocket *socket;
+  void (*handler)(struct _uEchoEventLoopWorker *, void *); /* uEchoEventLoopHandler */
+  void *userData;
+  struct _uEchoEventLoopWorker *worker;
+  bool isRemoved;
+} uEchoEventSource, uEchoEventSourceList;
+
+typedef struct _uEchoEventLoopWorker {
+  struct _uEchoEventLoop *loop;
+  uEchoThread *thread;
+  uEchoEventSource *source;
+  uEchoDatagramPacket *dgmPkts[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  uEchoArena *arena;
+} uEchoEventLoopWorker;
+
+typedef struct _uEchoEventLoop {
+  int epollFd;
+  uEchoMutex *mutex;
+  uEchoEventSourceList *sources;
+  size_t lastSourceId;
+  uEchoEventLoopWorker *workers;
+  size_t workerCnt;
+  size_t refCnt;
+} uEchoEventLoop;
+
+typedef void (*uEchoEventLoopHandler)(uEchoEventLoopWorker *, void *);
+
+/****************************************
+ * Function
+ ****************************************/
+
+uEchoEventLoop *uecho_event_loop_new(size_t workerCnt);
+bool uecho_event_loop_delete(uEchoEventLoop *loop);
+
+bool uecho_event_loop_start(uEchoEventLoop *loop);
+bool uecho_event_loop_stop(uEchoEventLoop *loop);
+bool uecho_event_loop_isrunning(uEchoEventLoop *loop);
+
+uEchoEventSource *uecho_event_loop_addsocket(uEchoEventLoop *loop, uEchoSocket *sock, uEchoEventLoopHandler handler, void *userData);
+bool uecho_event_loop_removesource(uEchoEventLoop *loop, uEchoEventSource *source);
+bool uecho_event_loop_isdispatching(uEchoEventLoop *loop, void *userData);
+
+#define uecho_event_loop_getworkercount(loop) (loop->workerCnt)
+#define uecho_event_loop_getsourcecount(loop) uecho_list_size((uEchoList *)loop->sources)
+
+#define uecho_event_loop_worker_getpackets(worker) (worker->dgmPkts)
+#define uecho_event_loop_worker_getarena(worker) (worker->arena)
+
+// Shared Event Loop
+
+uEchoEventLoop *uecho_event_loop_acquire(size_t workerCnt);
+void uecho_event_loop_release(uEchoEventLoop *loop);
+
+bool uecho_event_loop_setdefaultworkercount(size_t workerCnt);
+size_t uecho_event_loop_getdefaultworkercount(void);
+
+#ifdef  __cplusplus
+} /* extern C */
+#endif
+
+#endif /* _UECHO_EVENT_LOOP_H_ */
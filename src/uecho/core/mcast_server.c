@@ -28,6 +28,9 @@ uEchoMcastServer *uecho_mcast_server_new(void)
   
   server->socket = NULL;
   server->thread = NULL;
+  server->eventLoop = NULL;
+  server->eventSource = NULL;
+  server->sendQueue = uecho_socket_datagram_queue_new(uEchoServerSendQueueSize);
   
   return server;
 }
@@ -42,6 +45,7 @@ bool uecho_mcast_server_delete(uEchoMcastServer *server)
     return false;
  
   uecho_mcast_server_stop(server);
+  uecho_socket_datagram_queue_delete(server->sendQueue);
   uecho_mcast_server_remove(server);
   
   free(server);
@@ -76,6 +80,30 @@ void *uecho_mcast_server_getuserdata(uEchoMcastServer *server)
   return server->userData;
 }
 
+/****************************************
+ * uecho_mcast_server_seteventloop
+ ****************************************/
+
+void uecho_mcast_server_seteventloop(uEchoMcastServer *server, uEchoEventLoop *loop)
+{
+  server->eventLoop = loop;
+}
+
+/****************************************
+ * uecho_mcast_server_isdispatchthread
+ ****************************************/
+
+bool uecho_mcast_server_isdispatchthread(uEchoMcastServer *server)
+{
+  if (!server)
+    return false;
+  
+  if (server->eventSource)
+    return uecho_event_loop_isdispatching(server->eventLoop, server);
+  
+  return uecho_thread_iscurrent(server->thread);
+}
+
 /****************************************
  * uecho_mcast_server_open
  ****************************************/
@@ -98,9 +126,64 @@ bool uecho_mcast_server_open(uEchoMcastServer *server, const char *bindAddr)
     return false;
   }
   
+  uecho_socket_setmulticastttl(server->socket, UECHO_NET_SOCKET_MULTICAST_DEFAULT_TTL);
+  
   return true;
 }
 
+/****************************************
+ * uecho_mcast_server_setsocketrecvbuffer
+ ****************************************/
+
+static bool uecho_mcast_server_setsocketrecvbuffer(uEchoSocket *sock, size_t bufSize, size_t queueSize)
+{
+  if (!sock)
+    return false;
+  
+  if (!uecho_socket_setrecvbuffersize(sock, bufSize))
+    return false;
+  
+  if ((0 < queueSize) && !uecho_socket_setrecvqueuesize(sock, queueSize))
+    return false;
+  
+  return true;
+}
+
+/****************************************
+ * uecho_mcast_server_setrecvbuffer
+ ****************************************/
+
+bool uecho_mcast_server_setrecvbuffer(uEchoMcastServer *server, size_t bufSize, size_t queueSize)
+{
+  if (!server)
+    return false;
+  
+  // The sizes are applied to the opened sockets, so this is called between open and start
+  
+  if (!uecho_mcast_server_setsocketrecvbuffer(server->socket, bufSize, queueSize))
+    return false;
+  
+  return true;
+}
+
+/****************************************
+ * uecho_mcast_server_gettruncatedcount
+ ****************************************/
+
+size_t uecho_mcast_server_gettruncatedcount(uEchoMcastServer *server)
+{
+  size_t truncatedCnt;
+  
+  if (!server)
+    return 0;
+  
+  truncatedCnt = 0;
+  if (server->socket)
+    truncatedCnt += uecho_socket_gettruncatedcount(server->socket);
+  
+  return truncatedCnt;
+}
+
 /****************************************
  * uecho_mcast_server_close
  ****************************************/
@@ -152,6 +235,51 @@ bool uecho_mcast_server_performlistener(uEchoMcastServer *server, uEchoMessage *
   return true;
 }
 
+/****************************************
+ * uecho_mcast_server_dispatch
+ ****************************************/
+
+static void uecho_mcast_server_dispatch(uEchoMcastServer *server, uEchoDatagramPacket **dgmPkts, ssize_t dgmPktCnt, uEchoArena *arena)
+{
+  uEchoMessage *msg;
+  ssize_t n;
+  
+  // Handle each datagram with the temporary objects allocated from the arena
+  
+  for (n=0; n<dgmPktCnt; n++) {
+    msg = uecho_message_arena_new(arena);
+    if (!msg)
+      continue;
+    if (uecho_message_parsepacketview(msg, dgmPkts[n])) {
+      uecho_mcast_server_performlistener(server, msg);
+    }
+    uecho_message_delete(msg);
+    uecho_arena_reset(arena);
+  }
+}
+
+/****************************************
+ * uecho_mcast_server_handleevent
+ ****************************************/
+
+static void uecho_mcast_server_handleevent(uEchoEventLoopWorker *worker, void *userData)
+{
+  uEchoMcastServer *server;
+  uEchoDatagramPacket **dgmPkts;
+  ssize_t dgmPktCnt;
+  
+  server = (uEchoMcastServer *)userData;
+  dgmPkts = uecho_event_loop_worker_getpackets(worker);
+  
+  // The socket is non-blocking, so take one batch and let the loop rearm it for the rest
+  
+  dgmPktCnt = uecho_socket_recvbatch(server->socket, dgmPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE);
+  if (dgmPktCnt <= 0)
+    return;
+  
+  uecho_mcast_server_dispatch(server, dgmPkts, dgmPktCnt, uecho_event_loop_worker_getarena(worker));
+}
+
 /****************************************
  * uecho_mcast_server_action
  ****************************************/
@@ -159,40 +287,44 @@ bool uecho_mcast_server_performlistener(uEchoMcastServer *server, uEchoMessage *
 static void uecho_mcast_server_action(uEchoThread *thread)
 {
   uEchoMcastServer *server;
-  uEchoDatagramPacket *dgmPkt;
-  ssize_t dgmPktLen;
-  uEchoMessage *msg;
+  uEchoDatagramPacket *dgmPkts[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  ssize_t dgmPktCnt, n;
+  uEchoArena *arena;
   
   server = (uEchoMcastServer *)uecho_thread_getuserdata(thread);
-
+  
   if (!server)
     return;
-
+    
   if (!uecho_socket_isbound(server->socket))
     return;
   
+  // Receive datagrams into the packets and arena allocated once for this thread
+  
+  arena = uecho_arena_new(uEchoServerDatagramArenaSize);
+  if (!arena)
+    return;
+  
+  for (n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    dgmPkts[n] = uecho_socket_datagram_packet_new();
+  }
+  
   while (uecho_thread_isrunnable(thread)) {
-    dgmPkt = uecho_socket_datagram_packet_new();
-    if (!dgmPkt)
-      break;
- 
-    dgmPktLen = uecho_socket_recv(server->socket, dgmPkt);
-    if (dgmPktLen < 0)
+    dgmPktCnt = uecho_socket_recvbatch(server->socket, dgmPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE);
+    if (dgmPktCnt < 0)
       break;
     
     if (!uecho_thread_isrunnable(thread) || !uecho_socket_isbound(server->socket))
       break;
-      
-    msg = uecho_message_new();
-    if (!msg)
-      continue;
     
-    if (uecho_message_parsepacket(msg, dgmPkt)) {
-      uecho_mcast_server_performlistener(server, msg);
-    }
-    
-    uecho_message_delete(msg);
+    uecho_mcast_server_dispatch(server, dgmPkts, dgmPktCnt, arena);
+  }
+  
+  for (n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    uecho_socket_datagram_packet_delete(dgmPkts[n]);
   }
+  
+  uecho_arena_delete(arena);
 }
 
 /****************************************
@@ -209,6 +341,13 @@ bool uecho_mcast_server_start(uEchoMcastServer *server)
   if (!uecho_mcast_server_isopened(server))
     return false;
   
+  // Register the socket with the shared event loop if any instead of running a thread
+  
+  if (server->eventLoop) {
+    server->eventSource = uecho_event_loop_addsocket(server->eventLoop, server->socket, uecho_mcast_server_handleevent, server);
+    return server->eventSource ? true : false;
+  }
+  
   server->thread = uecho_thread_new();
   uecho_thread_setaction(server->thread, uecho_mcast_server_action);
   uecho_thread_setuserdata(server->thread, server);
@@ -229,6 +368,12 @@ bool uecho_mcast_server_stop(uEchoMcastServer *server)
   if (!server)
     return false;
     
+  if (server->eventSource) {
+    uecho_event_loop_removesource(server->eventLoop, server->eventSource);
+    server->eventSource = NULL;
+    uecho_mcast_server_close(server);
+  }
+  
   if (!server->thread)
     return true;
   
@@ -249,6 +394,9 @@ bool uecho_mcast_server_isrunning(uEchoMcastServer *server)
   if (!server)
     return false;
     
+  if (server->eventSource)
+    return uecho_event_loop_isrunning(server->eventLoop);
+  
   if (!server->thread)
     return false;
 
@@ -269,7 +417,51 @@ bool uecho_mcast_server_post(uEchoMcastServer *server, const byte *msg, size_t m
   if (!server->socket)
     return false;
   
+  if (0 < uecho_socket_datagram_queue_size(server->sendQueue)) {
+    if (!uecho_mcast_server_enqueue(server, msg, msgLen))
+      return false;
+    return uecho_mcast_server_flush(server);
+  }
+  
   sentLen = uecho_socket_sendto(server->socket, uEchoMulticastAddr, uEchoUdpPort, msg, msgLen);
   
   return (sentLen == msgLen) ? true : false;
 }
+
+/****************************************
+ * uecho_mcast_server_enqueue
+ ****************************************/
+
+bool uecho_mcast_server_enqueue(uEchoMcastServer *server, const byte *msg, size_t msgLen)
+{
+  if (!server)
+    return false;
+  
+  if (!server->socket || !server->sendQueue)
+    return false;
+  
+  if (uecho_socket_datagram_queue_add(server->sendQueue, uEchoMulticastAddr, uEchoUdpPort, msg, msgLen))
+    return true;
+  
+  // The queue is full, so flush the pending datagrams before queuing this one
+  
+  if (!uecho_mcast_server_flush(server))
+    return false;
+  
+  return uecho_socket_datagram_queue_add(server->sendQueue, uEchoMulticastAddr, uEchoUdpPort, msg, msgLen);
+}
+
+/****************************************
+ * uecho_mcast_server_flush
+ ****************************************/
+
+bool uecho_mcast_server_flush(uEchoMcastServer *server)
+{
+  if (!server)
+    return false;
+  
+  if (!server->socket || !server->sendQueue)
+    return false;
+  
+  return uecho_socket_datagram_queue_flush(server->sendQueue, server->socket);
+}
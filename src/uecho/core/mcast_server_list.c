@@ -67,6 +67,53 @@ void uecho_mcast_serverlist_setuserdata(uEchoMcastServerList *servers, void *dat
   }
 }
 
+/****************************************
+ * uecho_mcast_serverlist_seteventloop
+ ****************************************/
+
+void uecho_mcast_serverlist_seteventloop(uEchoMcastServerList *servers, uEchoEventLoop *loop)
+{
+  uEchoMcastServer *server;
+  
+  for (server = uecho_mcast_serverlist_gets(servers); server; server = uecho_mcast_server_next(server)) {
+    uecho_mcast_server_seteventloop(server, loop);
+  }
+}
+
+/****************************************
+ * uecho_mcast_serverlist_setrecvbuffer
+ ****************************************/
+
+bool uecho_mcast_serverlist_setrecvbuffer(uEchoMcastServerList *servers, size_t bufSize, size_t queueSize)
+{
+  uEchoMcastServer *server;
+  bool allActionsSucceeded;
+  
+  allActionsSucceeded = true;
+  for (server = uecho_mcast_serverlist_gets(servers); server; server = uecho_mcast_server_next(server)) {
+    allActionsSucceeded &= uecho_mcast_server_setrecvbuffer(server, bufSize, queueSize);
+  }
+  
+  return allActionsSucceeded;
+}
+
+/****************************************
+ * uecho_mcast_serverlist_gettruncatedcount
+ ****************************************/
+
+size_t uecho_mcast_serverlist_gettruncatedcount(uEchoMcastServerList *servers)
+{
+  uEchoMcastServer *server;
+  size_t truncatedCnt;
+  
+  truncatedCnt = 0;
+  for (server = uecho_mcast_serverlist_gets(servers); server; server = uecho_mcast_server_next(server)) {
+    truncatedCnt += uecho_mcast_server_gettruncatedcount(server);
+  }
+  
+  return truncatedCnt;
+}
+
 /****************************************
  * uecho_mcast_serverlist_open
  ****************************************/
@@ -195,6 +242,42 @@ bool uecho_mcast_serverlist_post(uEchoMcastServerList *servers, const byte *msg,
   return allActionsSucceeded;
 }
 
+/****************************************
+ * uecho_mcast_serverlist_enqueue
+ ****************************************/
+
+bool uecho_mcast_serverlist_enqueue(uEchoMcastServerList *servers, const byte *msg, size_t msgLen)
+{
+  uEchoMcastServer *server;
+  bool allActionsSucceeded;
+  
+  allActionsSucceeded = true;
+  for (server = uecho_mcast_serverlist_gets(servers); server; server = uecho_mcast_server_next(server)) {
+    allActionsSucceeded &= uecho_mcast_server_enqueue(server, msg, msgLen);
+  }
+  
+  return allActionsSucceeded;
+}
+
+/****************************************
+ * uecho_mcast_serverlist_flush
+ ****************************************/
+
+bool uecho_mcast_serverlist_flush(uEchoMcastServerList *servers)
+{
+  uEchoMcastServer *server;
+  bool allActionsSucceeded;
+  
+  allActionsSucceeded = true;
+  for (server = uecho_mcast_serverlist_gets(servers); server; server = uecho_mcast_server_next(server)) {
+    if (uecho_socket_datagram_queue_size(server->sendQueue) <= 0)
+      continue;
+    allActionsSucceeded &= uecho_mcast_server_flush(server);
+  }
+  
+  return allActionsSucceeded;
+}
+
 /****************************************
  * uecho_mcast_serverlist_isboundaddress
  ****************************************/
@@ -27,6 +27,11 @@ uEchoServer *uecho_server_new(void)
   server->mcastServers = uecho_mcast_serverlist_new();
   
   uecho_server_setoption(server, uEchoOptionNone);
+  server->eventLoop = NULL;
+  server->udpWorkerCnt = uEchoUdpServerDefaultWorkerCount;
+  server->eventLoopWorkerCnt = 0;
+  server->recvBufSize = UECHO_NET_SOCKET_DGRAM_RECV_BUFSIZE;
+  server->recvQueueSize = 0;
   
   return server;
 }
@@ -75,6 +80,72 @@ void *uecho_server_getuserdata(uEchoServer *server)
   return server->userData;
 }
 
+/****************************************
+ * uecho_server_setudpworkercount
+ ****************************************/
+
+bool uecho_server_setudpworkercount(uEchoServer *server, size_t workerCnt)
+{
+  if (!server)
+    return false;
+  
+  if ((workerCnt <= 0) || (uEchoUdpServerMaxWorkerCount < workerCnt))
+    return false;
+  
+  server->udpWorkerCnt = workerCnt;
+  
+  return true;
+}
+
+/****************************************
+ * uecho_server_seteventloopworkercount
+ ****************************************/
+
+bool uecho_server_seteventloopworkercount(uEchoServer *server, size_t workerCnt)
+{
+  if (!server)
+    return false;
+  
+  if ((workerCnt <= 0) || (uEchoEventLoopMaxWorkerCount < workerCnt))
+    return false;
+  
+  server->eventLoopWorkerCnt = workerCnt;
+  
+  return true;
+}
+
+/****************************************
+ * uecho_server_setrecvbuffer
+ ****************************************/
+
+bool uecho_server_setrecvbuffer(uEchoServer *server, size_t bufSize, size_t queueSize)
+{
+  if (!server)
+    return false;
+  
+  // A zero queue size keeps the SO_RCVBUF default of the system
+  
+  if ((bufSize <= 0) || (UECHO_NET_SOCKET_DGRAM_RECV_MAXBUFSIZE < bufSize))
+    return false;
+  
+  server->recvBufSize = bufSize;
+  server->recvQueueSize = queueSize;
+  
+  return true;
+}
+
+/****************************************
+ * uecho_server_gettruncatedcount
+ ****************************************/
+
+size_t uecho_server_gettruncatedcount(uEchoServer *server)
+{
+  if (!server)
+    return 0;
+  
+  return uecho_udp_serverlist_gettruncatedcount(server->udpServers) + uecho_mcast_serverlist_gettruncatedcount(server->mcastServers);
+}
+
 /****************************************
  * uecho_server_isboundaddress
  ****************************************/
@@ -106,14 +177,27 @@ bool uecho_server_start(uEchoServer *server)
 
   uecho_server_stop(server);
   
+  // Multiplex the sockets through the shared event loop, or fall back to one thread per socket
+  
+  if (uecho_server_iseventloopenabled(server)) {
+    server->eventLoop = uecho_event_loop_acquire(server->eventLoopWorkerCnt);
+  }
+  
   allActionsSucceeded &= uecho_mcast_serverlist_open(server->mcastServers);
+  allActionsSucceeded &= uecho_mcast_serverlist_setrecvbuffer(server->mcastServers, server->recvBufSize, server->recvQueueSize);
   uecho_mcast_serverlist_setuserdata(server->mcastServers, server);
+  uecho_mcast_serverlist_seteventloop(server->mcastServers, server->eventLoop);
   uecho_mcast_serverlist_setmessagelistener(server->mcastServers, uecho_mcast_server_msglistener);
   allActionsSucceeded &= uecho_mcast_serverlist_start(server->mcastServers);
 
   if (uecho_server_isudpserverenabled(server)) {
-    allActionsSucceeded &= uecho_udp_serverlist_open(server->udpServers);
+    // The receive workers of the UDP servers are sharded only when they run their own threads
+    
+    allActionsSucceeded &= uecho_udp_serverlist_openworkers(server->udpServers, (server->eventLoop ? uEchoUdpServerDefaultWorkerCount : server->udpWorkerCnt));
+    allActionsSucceeded &= uecho_udp_serverlist_setrecvbuffer(server->udpServers, server->recvBufSize, server->recvQueueSize);
     uecho_udp_serverlist_setuserdata(server->udpServers, server);
+    uecho_udp_serverlist_seteventloop(server->udpServers, server->eventLoop);
+    uecho_udp_serverlist_seturingenabled(server->udpServers, uecho_server_isuringenabled(server));
     uecho_udp_serverlist_setmessagelistener(server->udpServers, uecho_udp_server_msglistener);
     allActionsSucceeded &= uecho_udp_serverlist_start(server->udpServers);
   }
@@ -140,12 +224,17 @@ bool uecho_server_stop(uEchoServer *server)
   
   allActionsSucceeded &= uecho_mcast_serverlist_close(server->mcastServers);
   allActionsSucceeded &= uecho_mcast_serverlist_stop(server->mcastServers);
-  uecho_udp_serverlist_clear(server->mcastServers);
+  uecho_mcast_serverlist_clear(server->mcastServers);
   
   allActionsSucceeded &= uecho_udp_serverlist_close(server->udpServers);
   allActionsSucceeded &= uecho_udp_serverlist_stop(server->udpServers);
   uecho_udp_serverlist_clear(server->udpServers);
   
+  if (server->eventLoop) {
+    uecho_event_loop_release(server->eventLoop);
+    server->eventLoop = NULL;
+  }
+  
   return allActionsSucceeded;
 }
 
@@ -199,6 +288,10 @@ void uecho_udp_server_msglistener(uEchoUdpServer *udpServer, uEchoMessage *msg)
     return;
 
   uecho_server_performlistener(server, msg);
+  
+  // Send all responses queued while handling the message in one batch
+  
+  uecho_server_flush(server);
 }
 
 /****************************************
@@ -213,14 +306,26 @@ void uecho_mcast_server_msglistener(uEchoMcastServer *mcastServer, uEchoMessage
     return;
 
   uecho_server_performlistener(server, msg);
+  
+  // Send all responses queued while handling the message in one batch
+  
+  uecho_server_flush(server);
 }
 
 /****************************************
  * uecho_server_postannounce
  ****************************************/
 
-bool uecho_server_postannounce(uEchoServer *server, const byte *msg, size_t msgLen)
+bool uecho_server_postannounce(uEchoServer *server, const byte *msg, size_t msgLen, bool isDeferred)
 {
+  if (!server)
+    return false;
+  
+  // Deferred messages are queued only on the receive threads, which flush them after the listener returns
+  
+  if (isDeferred && uecho_server_isdispatchthread(server))
+    return uecho_mcast_serverlist_enqueue(server->mcastServers, msg, msgLen);
+  
   return uecho_mcast_serverlist_post(server->mcastServers, msg, msgLen);
 }
 
@@ -228,14 +333,38 @@ bool uecho_server_postannounce(uEchoServer *server, const byte *msg, size_t msgL
  * uecho_server_postresponse
  ****************************************/
 
-bool uecho_server_postresponse(uEchoServer *server, const char *addr, byte *msg, size_t msgLen)
+bool uecho_server_postresponse(uEchoServer *server, const char *addr, byte *msg, size_t msgLen, bool isDeferred)
 {
+  uEchoUdpServer *udpServer;
+  uEchoMcastServer *mcastServer;
   uEchoSocket *sock;
   size_t sentByteCnt;
   
   if (!server)
     return false;
- 
+  
+  // Send through the bound sockets on port 3610 to reuse them for every response.
+  // Deferred responses posted by the receive threads are queued and flushed after the request is handled.
+  
+  udpServer = uecho_udp_serverlist_selectserver(server->udpServers, addr);
+  if (udpServer) {
+    if (isDeferred && uecho_server_isdispatchthread(server)) {
+      if (uecho_udp_server_enqueue(udpServer, addr, msg, msgLen))
+        return true;
+    }
+    else {
+      if (uecho_udp_server_post(udpServer, addr, msg, msgLen))
+        return true;
+    }
+  }
+  
+  mcastServer = uecho_mcast_serverlist_gets(server->mcastServers);
+  if (mcastServer && uecho_mcast_getsocket(mcastServer)) {
+    sentByteCnt = uecho_socket_sendto(uecho_mcast_getsocket(mcastServer), addr, uEchoUdpPort, msg, msgLen);
+    if (msgLen == sentByteCnt)
+      return true;
+  }
+  
   sock = uecho_socket_dgram_new();
   if (!sock)
     return false;
@@ -246,3 +375,46 @@ bool uecho_server_postresponse(uEchoServer *server, const char *addr, byte *msg,
 
   return (msgLen == sentByteCnt) ? true : false;
 }
+
+/****************************************
+ * uecho_server_flush
+ ****************************************/
+
+bool uecho_server_flush(uEchoServer *server)
+{
+  bool allActionsSucceeded;
+  
+  if (!server)
+    return false;
+  
+  allActionsSucceeded = true;
+  allActionsSucceeded &= uecho_udp_serverlist_flush(server->udpServers);
+  allActionsSucceeded &= uecho_mcast_serverlist_flush(server->mcastServers);
+  
+  return allActionsSucceeded;
+}
+
+/****************************************
+ * uecho_server_isdispatchthread
+ ****************************************/
+
+bool uecho_server_isdispatchthread(uEchoServer *server)
+{
+  uEchoUdpServer *udpServer;
+  uEchoMcastServer *mcastServer;
+  
+  if (!server)
+    return false;
+  
+  for (udpServer = uecho_udp_serverlist_gets(server->udpServers); udpServer; udpServer = uecho_udp_server_next(udpServer)) {
+    if (uecho_udp_server_isdispatchthread(udpServer))
+      return true;
+  }
+  
+  for (mcastServer = uecho_mcast_serverlist_gets(server->mcastServers); mcastServer; mcastServer = uecho_mcast_server_next(mcastServer)) {
+    if (uecho_mcast_server_isdispatchthread(mcastServer))
+      return true;
+  }
+  
+  return false;
+}
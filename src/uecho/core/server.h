@@ -13,9 +13,11 @@
 
 #include <uecho/typedef.h>
 #include <uecho/net/socket.h>
+#include <uecho/util/arena.h>
 #include <uecho/util/thread.h>
 #include <uecho/util/list.h>
 #include <uecho/core/option.h>
+#include <uecho/core/event_loop.h>
 #include <uecho/object_internal.h>
 
 #ifdef  __cplusplus
@@ -28,6 +30,16 @@ extern "C" {
   
 enum {
   uEchoServerOptionDisableUdpServer = 0x01,
+  uEchoServerOptionEnableEventLoop = 0x02,
+  uEchoServerOptionEnableUring = 0x04,
+};
+
+enum {
+  uEchoServerSendQueueSize = UECHO_NET_SOCKET_DGRAM_SEND_QUEUESIZE,
+  uEchoUdpServerDefaultWorkerCount = 1,
+  uEchoUdpServerMaxWorkerCount = 64,
+  uEchoServerDatagramArenaSize = 4096,
+  uEchoServerUringWaitMiliTime = (UECHO_THREAD_MIN_SLEEP / 2),
 };
   
 /****************************************
@@ -36,11 +48,26 @@ enum {
   
 // UDP Server
 
+struct _uEchoUdpServer;
+
+typedef struct _uEchoUdpServerShard {
+  struct _uEchoUdpServer *server;
+  uEchoSocket *socket;
+  uEchoThread *thread;
+} uEchoUdpServerShard;
+
 typedef struct _uEchoUdpServer {
   UECHO_LIST_STRUCT_MEMBERS
 
   uEchoSocket *socket;
   uEchoThread *thread;
+  uEchoEventLoop *eventLoop;
+  uEchoEventSource *eventSource;
+  size_t workerCnt;
+  uEchoUdpServerShard *shards;
+  size_t shardCnt;
+  bool isUringEnabled;
+  uEchoDatagramQueue *sendQueue;
   void (*msgListener)(struct _uEchoUdpServer *, uEchoMessage *); /* uEchoUdpServerMessageListener */
   void *userData;
 } uEchoUdpServer, uEchoUdpServerList;
@@ -54,6 +81,9 @@ typedef struct _uEchoMcastServer {
   
   uEchoSocket *socket;
   uEchoThread *thread;
+  uEchoEventLoop *eventLoop;
+  uEchoEventSource *eventSource;
+  uEchoDatagramQueue *sendQueue;
   void (*msgListener)(struct _uEchoMcastServer *, uEchoMessage *); /* uEchoMcastServerMessageListener */
   void *userData;
 } uEchoMcastServer, uEchoMcastServerList;
@@ -68,6 +98,11 @@ typedef struct _uEchoServer {
   void (*msgListener)(struct _uEchoServer *, uEchoMessage *); /* uEchoServerMessageListener */
   void *userData;
   uEchoOption option;
+  uEchoEventLoop *eventLoop;
+  size_t udpWorkerCnt;
+  size_t eventLoopWorkerCnt;
+  size_t recvBufSize;
+  size_t recvQueueSize;
 } uEchoServer;
 
 typedef void (*uEchoServerMessageListener)(uEchoServer *, uEchoMessage *);
@@ -91,12 +126,25 @@ bool uecho_server_start(uEchoServer *server);
 bool uecho_server_stop(uEchoServer *server);
 bool uecho_server_isrunning(uEchoServer *server);
 
-bool uecho_server_postannounce(uEchoServer *server, const byte *msg, size_t msgLen);
-bool uecho_server_postresponse(uEchoServer *server, const char *addr, byte *msg, size_t msgLen);
+bool uecho_server_postannounce(uEchoServer *server, const byte *msg, size_t msgLen, bool isDeferred);
+bool uecho_server_postresponse(uEchoServer *server, const char *addr, byte *msg, size_t msgLen, bool isDeferred);
+bool uecho_server_flush(uEchoServer *server);
+bool uecho_server_isdispatchthread(uEchoServer *server);
 
 #define uecho_server_setoption(server, value) (server->option = value)
 #define uecho_server_isoptionenabled(server, value) (server->option & value)
 #define uecho_server_isudpserverenabled(ctrl) (!uecho_server_isoptionenabled(ctrl, uEchoServerOptionDisableUdpServer))
+#define uecho_server_iseventloopenabled(server) (uecho_server_isoptionenabled(server, uEchoServerOptionEnableEventLoop) ? true : false)
+#define uecho_server_geteventloop(server) (server->eventLoop)
+#define uecho_server_isuringenabled(server) (uecho_server_isoptionenabled(server, uEchoServerOptionEnableUring) ? true : false)
+bool uecho_server_setudpworkercount(uEchoServer *server, size_t workerCnt);
+#define uecho_server_getudpworkercount(server) (server->udpWorkerCnt)
+bool uecho_server_seteventloopworkercount(uEchoServer *server, size_t workerCnt);
+#define uecho_server_geteventloopworkercount(server) (server->eventLoopWorkerCnt)
+bool uecho_server_setrecvbuffer(uEchoServer *server, size_t bufSize, size_t queueSize);
+#define uecho_server_getrecvbuffersize(server) (server->recvBufSize)
+#define uecho_server_getrecvqueuesize(server) (server->recvQueueSize)
+size_t uecho_server_gettruncatedcount(uEchoServer *server);
 
 bool uecho_server_isboundaddress(uEchoServer *server, const char *addr);
   
@@ -113,6 +161,15 @@ bool uecho_udp_server_delete(uEchoUdpServer *server);
 void uecho_udp_server_setmessagelistener(uEchoUdpServer *server, uEchoUdpServerMessageListener listener);
 void uecho_udp_server_setuserdata(uEchoUdpServer *server, void *data);
 void *uecho_udp_server_getuserdata(uEchoUdpServer *server);
+void uecho_udp_server_seteventloop(uEchoUdpServer *server, uEchoEventLoop *loop);
+bool uecho_udp_server_isdispatchthread(uEchoUdpServer *server);
+bool uecho_udp_server_setworkercount(uEchoUdpServer *server, size_t workerCnt);
+#define uecho_udp_server_getworkercount(server) (server->workerCnt)
+#define uecho_udp_server_getshardcount(server) (server->shardCnt)
+void uecho_udp_server_seturingenabled(uEchoUdpServer *server, bool flag);
+#define uecho_udp_server_isuringenabled(server) (server->isUringEnabled)
+bool uecho_udp_server_setrecvbuffer(uEchoUdpServer *server, size_t bufSize, size_t queueSize);
+size_t uecho_udp_server_gettruncatedcount(uEchoUdpServer *server);
 
 bool uecho_udp_server_performlistener(uEchoUdpServer *server, uEchoMessage *msg);
 
@@ -122,6 +179,11 @@ bool uecho_udp_server_close(uEchoUdpServer *server);
 bool uecho_udp_server_start(uEchoUdpServer *server);
 bool uecho_udp_server_stop(uEchoUdpServer *server);
 bool uecho_udp_server_isrunning(uEchoUdpServer *server);
+
+bool uecho_udp_server_post(uEchoUdpServer *server, const char *addr, const byte *msg, size_t msgLen);
+bool uecho_udp_server_enqueue(uEchoUdpServer *server, const char *addr, const byte *msg, size_t msgLen);
+bool uecho_udp_server_flush(uEchoUdpServer *server);
+#define uecho_udp_server_getsendqueue(server) (server->sendQueue)
   
 // Multicast Server
   
@@ -136,6 +198,10 @@ bool uecho_mcast_server_delete(uEchoMcastServer *server);
 void uecho_mcast_server_setmessagelistener(uEchoMcastServer *server, uEchoMcastServerMessageListener listener);
 void uecho_mcast_server_setuserdata(uEchoMcastServer *server, void *data);
 void *uecho_mcast_server_getuserdata(uEchoMcastServer *server);
+void uecho_mcast_server_seteventloop(uEchoMcastServer *server, uEchoEventLoop *loop);
+bool uecho_mcast_server_isdispatchthread(uEchoMcastServer *server);
+bool uecho_mcast_server_setrecvbuffer(uEchoMcastServer *server, size_t bufSize, size_t queueSize);
+size_t uecho_mcast_server_gettruncatedcount(uEchoMcastServer *server);
 
 bool uecho_mcast_server_performlistener(uEchoMcastServer *server, uEchoMessage *msg);
 
@@ -148,6 +214,9 @@ bool uecho_mcast_server_stop(uEchoMcastServer *server);
 bool uecho_mcast_server_isrunning(uEchoMcastServer *server);
 
 bool uecho_mcast_server_post(uEchoMcastServer *server, const byte *msg, size_t msgLen);
+bool uecho_mcast_server_enqueue(uEchoMcastServer *server, const byte *msg, size_t msgLen);
+bool uecho_mcast_server_flush(uEchoMcastServer *server);
+#define uecho_mcast_server_getsendqueue(server) (server->sendQueue)
 
 /****************************************
  * Listener
@@ -165,13 +234,20 @@ void uecho_mcast_server_msglistener(uEchoMcastServer *server, uEchoMessage *msg)
 uEchoUdpServerList *uecho_udp_serverlist_new(void);
 void uecho_udp_serverlist_delete(uEchoUdpServerList *servers);
 bool uecho_udp_serverlist_open(uEchoUdpServerList *servers);
+bool uecho_udp_serverlist_openworkers(uEchoUdpServerList *servers, size_t workerCnt);
 bool uecho_udp_serverlist_close(uEchoUdpServerList *servers);
 bool uecho_udp_serverlist_start(uEchoUdpServerList *servers);
 bool uecho_udp_serverlist_stop(uEchoUdpServerList *servers);
 bool uecho_udp_serverlist_isrunning(uEchoUdpServerList *servers);
 void uecho_udp_serverlist_setmessagelistener(uEchoUdpServerList *servers, uEchoUdpServerMessageListener listener);
 void uecho_udp_serverlist_setuserdata(uEchoUdpServerList *servers, void *data);
-bool uecho_udp_serverlist_post(uEchoMcastServerList *servers, char *addr);
+void uecho_udp_serverlist_seteventloop(uEchoUdpServerList *servers, uEchoEventLoop *loop);
+void uecho_udp_serverlist_seturingenabled(uEchoUdpServerList *servers, bool flag);
+bool uecho_udp_serverlist_setrecvbuffer(uEchoUdpServerList *servers, size_t bufSize, size_t queueSize);
+size_t uecho_udp_serverlist_gettruncatedcount(uEchoUdpServerList *servers);
+bool uecho_udp_serverlist_post(uEchoUdpServerList *servers, const char *addr, const byte *msg, size_t msgLen);
+uEchoUdpServer *uecho_udp_serverlist_selectserver(uEchoUdpServerList *servers, const char *addr);
+bool uecho_udp_serverlist_flush(uEchoUdpServerList *servers);
 bool uecho_udp_serverlist_isboundaddress(uEchoUdpServerList *servers, const char *addr);
 
 #define uecho_udp_serverlist_clear(servers) uecho_list_clear((uEchoList *)servers, (UECHO_LIST_DESTRUCTORFUNC)uecho_udp_server_delete)
@@ -190,7 +266,12 @@ bool uecho_mcast_serverlist_stop(uEchoMcastServerList *servers);
 bool uecho_mcast_serverlist_isrunning(uEchoMcastServerList *servers);
 void uecho_mcast_serverlist_setmessagelistener(uEchoMcastServerList *servers, uEchoMcastServerMessageListener listener);
 void uecho_mcast_serverlist_setuserdata(uEchoMcastServerList *servers, void *data);
+void uecho_mcast_serverlist_seteventloop(uEchoMcastServerList *servers, uEchoEventLoop *loop);
+bool uecho_mcast_serverlist_setrecvbuffer(uEchoMcastServerList *servers, size_t bufSize, size_t queueSize);
+size_t uecho_mcast_serverlist_gettruncatedcount(uEchoMcastServerList *servers);
 bool uecho_mcast_serverlist_post(uEchoMcastServerList *servers, const byte *msg, size_t msgLen);
+bool uecho_mcast_serverlist_enqueue(uEchoMcastServerList *servers, const byte *msg, size_t msgLen);
+bool uecho_mcast_serverlist_flush(uEchoMcastServerList *servers);
 bool uecho_mcast_serverlist_isboundaddress(uEchoMcastServerList *servers, const char *addr);
 
 #define uecho_mcast_serverlist_clear(servers) uecho_list_clear((uEchoList *)servers, (UECHO_LIST_DESTRUCTORFUNC)uecho_mcast_server_delete)
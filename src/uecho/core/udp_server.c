@@ -9,6 +9,7 @@
  ******************************************************************/
 
 #include <uecho/core/server.h>
+#include <uecho/net/uring.h>
 
 /****************************************
 * uecho_udp_server_new
@@ -27,6 +28,13 @@ uEchoUdpServer *uecho_udp_server_new(void)
   
   server->socket = NULL;
   server->thread = NULL;
+  server->eventLoop = NULL;
+  server->eventSource = NULL;
+  server->workerCnt = uEchoUdpServerDefaultWorkerCount;
+  server->shards = NULL;
+  server->shardCnt = 0;
+  server->isUringEnabled = false;
+  server->sendQueue = uecho_socket_datagram_queue_new(uEchoServerSendQueueSize);
   
   return server;
 }
@@ -40,7 +48,10 @@ bool uecho_udp_server_delete(uEchoUdpServer *server)
   if (!server)
     return false;
     
-  uecho_socket_delete(server->socket);
+  uecho_udp_server_close(server);
+  if (server->shards)
+    free(server->shards);
+  uecho_socket_datagram_queue_delete(server->sendQueue);
   uecho_udp_server_remove(server);
   
   free(server);
@@ -75,35 +86,222 @@ void *uecho_udp_server_getuserdata(uEchoUdpServer *server)
   return server->userData;
 }
 
+/****************************************
+ * uecho_udp_server_seteventloop
+ ****************************************/
+
+void uecho_udp_server_seteventloop(uEchoUdpServer *server, uEchoEventLoop *loop)
+{
+  server->eventLoop = loop;
+}
+
+/****************************************
+ * uecho_udp_server_seturingenabled
+ ****************************************/
+
+void uecho_udp_server_seturingenabled(uEchoUdpServer *server, bool flag)
+{
+  if (!server)
+    return;
+  
+  // The rings are created by the threads using them, and the sockets are used directly when they are not available
+  
+  server->isUringEnabled = flag;
+  uecho_socket_datagram_queue_seturingenabled(server->sendQueue, flag);
+}
+
+/****************************************
+ * uecho_udp_server_isdispatchthread
+ ****************************************/
+
+bool uecho_udp_server_isdispatchthread(uEchoUdpServer *server)
+{
+  uEchoUdpServerShard *shard;
+  size_t n;
+  
+  if (!server)
+    return false;
+  
+  if (server->eventSource)
+    return uecho_event_loop_isdispatching(server->eventLoop, server);
+  
+  if (uecho_thread_iscurrent(server->thread))
+    return true;
+  
+  for (n=0; n<server->shardCnt; n++) {
+    shard = &server->shards[n];
+    if (uecho_thread_iscurrent(shard->thread))
+      return true;
+  }
+  
+  return false;
+}
+
+/****************************************
+ * uecho_udp_server_setworkercount
+ ****************************************/
+
+bool uecho_udp_server_setworkercount(uEchoUdpServer *server, size_t workerCnt)
+{
+  if (!server)
+    return false;
+  
+  if ((workerCnt <= 0) || (uEchoUdpServerMaxWorkerCount < workerCnt))
+    return false;
+  
+  server->workerCnt = workerCnt;
+  
+  return true;
+}
+
 /****************************************
  * uecho_udp_server_open
  ****************************************/
 
 bool uecho_udp_server_open(uEchoUdpServer *server, const char *bindAddr)
 {
+  uEchoUdpServerShard *shards;
+  size_t shardCnt, n;
+  
   if (!server)
     return false;
     
   uecho_udp_server_close(server);
   
+  // With several workers, the sockets share the port with SO_REUSEPORT and
+  // the kernel balances the received datagrams across them
+  
+  shardCnt = server->workerCnt - 1;
+  server->shardCnt = 0;
+  
   server->socket = uecho_socket_dgram_new();
+  uecho_socket_setreuseport(server->socket, (0 < shardCnt) ? true : false);
   if (!uecho_socket_bind(server->socket, uEchoUdpPort, bindAddr, true, true)) {
     uecho_udp_server_close(server);
     return false;
   }
   
+  // The TTL is set once here, since the batched sends of the queue do not set it per datagram
+  
+  uecho_socket_setmulticastttl(server->socket, UECHO_NET_SOCKET_MULTICAST_DEFAULT_TTL);
+  
+  if (shardCnt <= 0)
+    return true;
+  
+  shards = (uEchoUdpServerShard *)realloc(server->shards, sizeof(uEchoUdpServerShard) * shardCnt);
+  if (!shards) {
+    uecho_udp_server_close(server);
+    return false;
+  }
+  server->shards = shards;
+  
+  for (n=0; n<shardCnt; n++) {
+    shards[n].server = server;
+    shards[n].thread = NULL;
+    shards[n].socket = uecho_socket_dgram_new();
+    server->shardCnt = n + 1;
+    uecho_socket_setreuseport(shards[n].socket, true);
+    if (!uecho_socket_bind(shards[n].socket, uEchoUdpPort, bindAddr, true, true)) {
+      uecho_udp_server_close(server);
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+/****************************************
+ * uecho_udp_server_setsocketrecvbuffer
+ ****************************************/
+
+static bool uecho_udp_server_setsocketrecvbuffer(uEchoSocket *sock, size_t bufSize, size_t queueSize)
+{
+  if (!sock)
+    return false;
+  
+  if (!uecho_socket_setrecvbuffersize(sock, bufSize))
+    return false;
+  
+  if ((0 < queueSize) && !uecho_socket_setrecvqueuesize(sock, queueSize))
+    return false;
+  
+  return true;
+}
+
+/****************************************
+ * uecho_udp_server_setrecvbuffer
+ ****************************************/
+
+bool uecho_udp_server_setrecvbuffer(uEchoUdpServer *server, size_t bufSize, size_t queueSize)
+{
+  uEchoUdpServerShard *shard;
+  size_t n;
+  
+  if (!server)
+    return false;
+  
+  // The sizes are applied to the opened sockets, so this is called between open and start
+  
+  if (!uecho_udp_server_setsocketrecvbuffer(server->socket, bufSize, queueSize))
+    return false;
+  
+  for (n=0; n<server->shardCnt; n++) {
+    shard = &server->shards[n];
+    if (!uecho_udp_server_setsocketrecvbuffer(shard->socket, bufSize, queueSize))
+      return false;
+  }
+  
   return true;
 }
 
+/****************************************
+ * uecho_udp_server_gettruncatedcount
+ ****************************************/
+
+size_t uecho_udp_server_gettruncatedcount(uEchoUdpServer *server)
+{
+  uEchoUdpServerShard *shard;
+  size_t truncatedCnt, n;
+  
+  if (!server)
+    return 0;
+  
+  truncatedCnt = 0;
+  if (server->socket)
+    truncatedCnt += uecho_socket_gettruncatedcount(server->socket);
+  
+  for (n=0; n<server->shardCnt; n++) {
+    shard = &server->shards[n];
+    if (shard->socket)
+      truncatedCnt += uecho_socket_gettruncatedcount(shard->socket);
+  }
+  
+  return truncatedCnt;
+}
+
 /****************************************
  * uecho_udp_server_close
  ****************************************/
 
 bool uecho_udp_server_close(uEchoUdpServer *server)
 {
+  uEchoUdpServerShard *shard;
+  size_t n;
+  
   if (!server)
     return false;
     
+  // The shards are kept until the server is deleted because their threads refer to them
+  
+  for (n=0; n<server->shardCnt; n++) {
+    shard = &server->shards[n];
+    if (!shard->socket)
+      continue;
+    uecho_socket_close(shard->socket);
+    uecho_socket_delete(shard->socket);
+    shard->socket = NULL;
+  }
+  
   if (!server->socket)
     return true;
   
@@ -147,46 +345,131 @@ bool uecho_udp_server_performlistener(uEchoUdpServer *server, uEchoMessage *msg)
 }
 
 /****************************************
- * uecho_udp_server_action
+ * uecho_udp_server_dispatch
  ****************************************/
 
-static void uecho_udp_server_action(uEchoThread *thread)
+static void uecho_udp_server_dispatch(uEchoUdpServer *server, uEchoDatagramPacket **dgmPkts, ssize_t dgmPktCnt, uEchoArena *arena)
 {
-  uEchoUdpServer *server;
-  uEchoDatagramPacket *dgmPkt;
-  ssize_t dgmPktLen;
   uEchoMessage *msg;
+  ssize_t n;
   
-  server = (uEchoUdpServer *)uecho_thread_getuserdata(thread);
+  // Handle each datagram with the temporary objects allocated from the arena
   
-  if (!server)
+  for (n=0; n<dgmPktCnt; n++) {
+    msg = uecho_message_arena_new(arena);
+    if (!msg)
+      continue;
+    if (uecho_message_parsepacketview(msg, dgmPkts[n])) {
+      uecho_udp_server_performlistener(server, msg);
+    }
+    uecho_message_delete(msg);
+    uecho_arena_reset(arena);
+  }
+}
+
+/****************************************
+ * uecho_udp_server_handleevent
+ ****************************************/
+
+static void uecho_udp_server_handleevent(uEchoEventLoopWorker *worker, void *userData)
+{
+  uEchoUdpServer *server;
+  uEchoDatagramPacket **dgmPkts;
+  ssize_t dgmPktCnt;
+  
+  server = (uEchoUdpServer *)userData;
+  dgmPkts = uecho_event_loop_worker_getpackets(worker);
+  
+  // The socket is non-blocking, so take one batch and let the loop rearm it for the rest
+  
+  dgmPktCnt = uecho_socket_recvbatch(server->socket, dgmPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE);
+  if (dgmPktCnt <= 0)
     return;
-    
-  if (!uecho_socket_isbound(server->socket))
+  
+  uecho_udp_server_dispatch(server, dgmPkts, dgmPktCnt, uecho_event_loop_worker_getarena(worker));
+}
+
+/****************************************
+ * uecho_udp_server_receive
+ ****************************************/
+
+static void uecho_udp_server_receive(uEchoUdpServer *server, uEchoSocket **sock, uEchoThread *thread)
+{
+  uEchoDatagramPacket *dgmPkts[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  ssize_t dgmPktCnt, n;
+  uEchoArena *arena;
+  uEchoUring *ring;
+  
+  // The socket is referred through the owner because it is deleted when the server is closed
+  
+  if (!uecho_socket_isbound(*sock))
+    return;
+  
+  // Receive datagrams into the packets and arena allocated once for this thread
+  
+  arena = uecho_arena_new(uEchoServerDatagramArenaSize);
+  if (!arena)
     return;
   
+  for (n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    dgmPkts[n] = uecho_socket_datagram_packet_new();
+  }
+  
+  // Each thread owns its ring, a multishot receive keeps it fed without a system call per datagram
+  
+  ring = server->isUringEnabled ? uecho_uring_new(uEchoUringDefaultEntryCount) : NULL;
+  
   while (uecho_thread_isrunnable(thread)) {
-    dgmPkt = uecho_socket_datagram_packet_new();
-    if (!dgmPkt)
+    if (ring)
+      dgmPktCnt = uecho_uring_recvbatch(ring, *sock, dgmPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE, uEchoServerUringWaitMiliTime);
+    else
+      dgmPktCnt = uecho_socket_recvbatch(*sock, dgmPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE);
+    if (dgmPktCnt < 0)
       break;
     
-    dgmPktLen = uecho_socket_recv(server->socket, dgmPkt);
-    if (dgmPktLen < 0)
+    if (!uecho_thread_isrunnable(thread) || !uecho_socket_isbound(*sock))
       break;
     
-    if (!uecho_thread_isrunnable(thread) || !uecho_socket_isbound(server->socket))
-      break;
- 
-    msg = uecho_message_new();
-    if (!msg)
-      continue;
-    
-    if (uecho_message_parsepacket(msg, dgmPkt)) {
-      uecho_udp_server_performlistener(server, msg);
-    }
-    
-    uecho_message_delete(msg);
+    uecho_udp_server_dispatch(server, dgmPkts, dgmPktCnt, arena);
+  }
+  
+  uecho_uring_delete(ring);
+  
+  for (n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    uecho_socket_datagram_packet_delete(dgmPkts[n]);
   }
+  
+  uecho_arena_delete(arena);
+}
+
+/****************************************
+ * uecho_udp_server_action
+ ****************************************/
+
+static void uecho_udp_server_action(uEchoThread *thread)
+{
+  uEchoUdpServer *server;
+  
+  server = (uEchoUdpServer *)uecho_thread_getuserdata(thread);
+  if (!server)
+    return;
+  
+  uecho_udp_server_receive(server, &server->socket, thread);
+}
+
+/****************************************
+ * uecho_udp_server_shardaction
+ ****************************************/
+
+static void uecho_udp_server_shardaction(uEchoThread *thread)
+{
+  uEchoUdpServerShard *shard;
+  
+  shard = (uEchoUdpServerShard *)uecho_thread_getuserdata(thread);
+  if (!shard)
+    return;
+  
+  uecho_udp_server_receive(shard->server, &shard->socket, thread);
 }
 
 /****************************************
@@ -195,6 +478,9 @@ static void uecho_udp_server_action(uEchoThread *thread)
 
 bool uecho_udp_server_start(uEchoUdpServer *server)
 {
+  uEchoUdpServerShard *shard;
+  size_t cpuCnt, n;
+  
   if (!server)
     return false;
     
@@ -203,6 +489,15 @@ bool uecho_udp_server_start(uEchoUdpServer *server)
   if (!uecho_udp_server_isopened(server))
     return false;
   
+  // Register the socket with the shared event loop if any instead of running a thread
+  
+  if (server->eventLoop) {
+    if (0 < server->shardCnt)
+      return false;
+    server->eventSource = uecho_event_loop_addsocket(server->eventLoop, server->socket, uecho_udp_server_handleevent, server);
+    return server->eventSource ? true : false;
+  }
+  
   server->thread = uecho_thread_new();
   uecho_thread_setaction(server->thread, uecho_udp_server_action);
   uecho_thread_setuserdata(server->thread, server);
@@ -211,6 +506,26 @@ bool uecho_udp_server_start(uEchoUdpServer *server)
     return false;
   }
   
+  // Each shard socket has its own thread, and the shard threads are spread over the cores.
+  // The primary thread is left to the scheduler not to pile every server onto the same core.
+  
+  if (server->shardCnt <= 0)
+    return true;
+  
+  cpuCnt = uecho_thread_getcpucount();
+  
+  for (n=0; n<server->shardCnt; n++) {
+    shard = &server->shards[n];
+    shard->thread = uecho_thread_new();
+    uecho_thread_setaction(shard->thread, uecho_udp_server_shardaction);
+    uecho_thread_setuserdata(shard->thread, shard);
+    if (!uecho_thread_start(shard->thread)) {
+      uecho_udp_server_stop(server);
+      return false;
+    }
+    uecho_thread_setcpuaffinity(shard->thread, (int)((n + 1) % cpuCnt));
+  }
+  
   return true;
 }
 
@@ -220,17 +535,45 @@ bool uecho_udp_server_start(uEchoUdpServer *server)
 
 bool uecho_udp_server_stop(uEchoUdpServer *server)
 {
+  uEchoUdpServerShard *shard;
+  bool isSignaled;
+  size_t n;
+  
   if (!server)
     return false;
     
+  if (server->eventSource) {
+    uecho_event_loop_removesource(server->eventLoop, server->eventSource);
+    server->eventSource = NULL;
+    uecho_udp_server_close(server);
+  }
+  
   if (!server->thread)
     return true;
   
   uecho_udp_server_close(server);
-  uecho_thread_stop(server->thread);
+  
+  // Signal all threads first and wait for them once, not once per shard
+  
+  isSignaled = uecho_thread_signalstop(server->thread);
+  for (n=0; n<server->shardCnt; n++) {
+    isSignaled |= uecho_thread_signalstop(server->shards[n].thread);
+  }
+  if (isSignaled) {
+    uecho_thread_waitstop();
+  }
+  
   uecho_thread_delete(server->thread);
   server->thread = NULL;
   
+  for (n=0; n<server->shardCnt; n++) {
+    shard = &server->shards[n];
+    if (!shard->thread)
+      continue;
+    uecho_thread_delete(shard->thread);
+    shard->thread = NULL;
+  }
+  
   return true;
 }
 
@@ -243,8 +586,86 @@ bool uecho_udp_server_isrunning(uEchoUdpServer *server)
   if (!server)
     return false;
     
+  if (server->eventSource)
+    return uecho_event_loop_isrunning(server->eventLoop);
+  
   if (!server->thread)
     return false;
 
   return uecho_thread_isrunning(server->thread);
 }
+
+/****************************************
+ * uecho_udp_server_post
+ ****************************************/
+
+bool uecho_udp_server_post(uEchoUdpServer *server, const char *addr, const byte *msg, size_t msgLen)
+{
+#if !defined(WIN32)
+  uEchoSocketDestination dest;
+#endif
+  ssize_t sentLen;
+  
+  if (!server)
+    return false;
+  
+  if (!server->socket || !uecho_socket_isbound(server->socket))
+    return false;
+  
+  if (0 < uecho_socket_datagram_queue_size(server->sendQueue)) {
+    if (!uecho_udp_server_enqueue(server, addr, msg, msgLen))
+      return false;
+    return uecho_udp_server_flush(server);
+  }
+  
+#if defined(WIN32)
+  sentLen = (ssize_t)uecho_socket_sendto(server->socket, addr, uEchoUdpPort, msg, msgLen);
+#else
+  // The destination is resolved through the per-thread address cache and sent on the bound socket.
+  // Queued datagrams are resolved through the same cache when they are flushed.
+  
+  if (!uecho_socket_destination_set(&dest, addr, uEchoUdpPort))
+    return false;
+  sentLen = uecho_socket_sendtodestination(server->socket, &dest, msg, msgLen);
+#endif
+  
+  return (sentLen == (ssize_t)msgLen) ? true : false;
+}
+
+/****************************************
+ * uecho_udp_server_enqueue
+ ****************************************/
+
+bool uecho_udp_server_enqueue(uEchoUdpServer *server, const char *addr, const byte *msg, size_t msgLen)
+{
+  if (!server)
+    return false;
+  
+  if (!server->socket || !uecho_socket_isbound(server->socket) || !server->sendQueue)
+    return false;
+  
+  if (uecho_socket_datagram_queue_add(server->sendQueue, addr, uEchoUdpPort, msg, msgLen))
+    return true;
+  
+  // The queue is full, so flush the pending datagrams before queuing this one
+  
+  if (!uecho_udp_server_flush(server))
+    return false;
+  
+  return uecho_socket_datagram_queue_add(server->sendQueue, addr, uEchoUdpPort, msg, msgLen);
+}
+
+/****************************************
+ * uecho_udp_server_flush
+ ****************************************/
+
+bool uecho_udp_server_flush(uEchoUdpServer *server)
+{
+  if (!server)
+    return false;
+  
+  if (!server->socket || !server->sendQueue)
+    return false;
+  
+  return uecho_socket_datagram_queue_flush(server->sendQueue, server->socket);
+}
@@ -11,6 +11,10 @@
 #include <uecho/core/server.h>
 #include <uecho/net/interface.h>
 
+#if !defined(WIN32)
+#include <arpa/inet.h>
+#endif
+
 /****************************************
  * uecho_udp_serverlist_new
  ****************************************/
@@ -67,11 +71,80 @@ void uecho_udp_serverlist_setuserdata(uEchoUdpServerList *servers, void *data)
   }
 }
 
+/****************************************
+ * uecho_udp_serverlist_seteventloop
+ ****************************************/
+
+void uecho_udp_serverlist_seteventloop(uEchoUdpServerList *servers, uEchoEventLoop *loop)
+{
+  uEchoUdpServer *server;
+  
+  for (server = uecho_udp_serverlist_gets(servers); server; server = uecho_udp_server_next(server)) {
+    uecho_udp_server_seteventloop(server, loop);
+  }
+}
+
+/****************************************
+ * uecho_udp_serverlist_seturingenabled
+ ****************************************/
+
+void uecho_udp_serverlist_seturingenabled(uEchoUdpServerList *servers, bool flag)
+{
+  uEchoUdpServer *server;
+  
+  for (server = uecho_udp_serverlist_gets(servers); server; server = uecho_udp_server_next(server)) {
+    uecho_udp_server_seturingenabled(server, flag);
+  }
+}
+
+/****************************************
+ * uecho_udp_serverlist_setrecvbuffer
+ ****************************************/
+
+bool uecho_udp_serverlist_setrecvbuffer(uEchoUdpServerList *servers, size_t bufSize, size_t queueSize)
+{
+  uEchoUdpServer *server;
+  bool allActionsSucceeded;
+  
+  allActionsSucceeded = true;
+  for (server = uecho_udp_serverlist_gets(servers); server; server = uecho_udp_server_next(server)) {
+    allActionsSucceeded &= uecho_udp_server_setrecvbuffer(server, bufSize, queueSize);
+  }
+  
+  return allActionsSucceeded;
+}
+
+/****************************************
+ * uecho_udp_serverlist_gettruncatedcount
+ ****************************************/
+
+size_t uecho_udp_serverlist_gettruncatedcount(uEchoUdpServerList *servers)
+{
+  uEchoUdpServer *server;
+  size_t truncatedCnt;
+  
+  truncatedCnt = 0;
+  for (server = uecho_udp_serverlist_gets(servers); server; server = uecho_udp_server_next(server)) {
+    truncatedCnt += uecho_udp_server_gettruncatedcount(server);
+  }
+  
+  return truncatedCnt;
+}
+
 /****************************************
  * uecho_udp_serverlist_open
  ****************************************/
 
 bool uecho_udp_serverlist_open(uEchoUdpServerList *servers)
+{
+  return uecho_udp_serverlist_openworkers(servers, uEchoUdpServerDefaultWorkerCount);
+}
+
+/****************************************
+ * uecho_udp_serverlist_openworkers
+ ****************************************/
+
+bool uecho_udp_serverlist_openworkers(uEchoUdpServerList *servers, size_t workerCnt)
 {
   uEchoUdpServer *server;
   uEchoNetworkInterfaceList *netIfList;
@@ -96,7 +169,7 @@ bool uecho_udp_serverlist_open(uEchoUdpServerList *servers)
       break;
     }
     
-    if (!uecho_udp_server_open(server, uecho_net_interface_getaddress(netIf))) {
+    if (!uecho_udp_server_setworkercount(server, workerCnt) || !uecho_udp_server_open(server, uecho_net_interface_getaddress(netIf))) {
       allActionsSucceeded = false;
       uecho_udp_server_delete(server);
       break;
@@ -197,3 +270,91 @@ bool uecho_udp_serverlist_isboundaddress(uEchoUdpServerList *servers, const char
   return false;
 }
 
+
+/****************************************
+ * uecho_udp_serverlist_getprefixlength
+ ****************************************/
+
+static int uecho_udp_serverlist_getprefixlength(const char *addr1, const char *addr2)
+{
+  struct in_addr inAddr1, inAddr2;
+  uint32_t diffBits;
+  int prefixLen;
+  
+  if (!addr1 || !addr2)
+    return -1;
+  
+  if ((inet_pton(AF_INET, addr1, &inAddr1) != 1) || (inet_pton(AF_INET, addr2, &inAddr2) != 1))
+    return -1;
+  
+  diffBits = ntohl(inAddr1.s_addr) ^ ntohl(inAddr2.s_addr);
+  for (prefixLen = 0; prefixLen < 32; prefixLen++) {
+    if (diffBits & (0x80000000 >> prefixLen))
+      break;
+  }
+  
+  return prefixLen;
+}
+
+/****************************************
+ * uecho_udp_serverlist_selectserver
+ ****************************************/
+
+uEchoUdpServer *uecho_udp_serverlist_selectserver(uEchoUdpServerList *servers, const char *addr)
+{
+  uEchoUdpServer *server, *selectedServer;
+  uEchoSocket *sock;
+  int prefixLen, selectedPrefixLen;
+  
+  // Select the server bound to the interface closest to the address
+  
+  selectedServer = NULL;
+  selectedPrefixLen = -1;
+  
+  for (server = uecho_udp_serverlist_gets(servers); server; server = uecho_udp_server_next(server)) {
+    sock = uecho_udp_getsocket(server);
+    if (!sock || !uecho_socket_isbound(sock))
+      continue;
+    prefixLen = uecho_udp_serverlist_getprefixlength(uecho_socket_getaddress(sock), addr);
+    if (!selectedServer || (selectedPrefixLen < prefixLen)) {
+      selectedServer = server;
+      selectedPrefixLen = prefixLen;
+    }
+  }
+  
+  return selectedServer;
+}
+
+/****************************************
+ * uecho_udp_serverlist_post
+ ****************************************/
+
+bool uecho_udp_serverlist_post(uEchoUdpServerList *servers, const char *addr, const byte *msg, size_t msgLen)
+{
+  uEchoUdpServer *server;
+  
+  server = uecho_udp_serverlist_selectserver(servers, addr);
+  if (!server)
+    return false;
+  
+  return uecho_udp_server_post(server, addr, msg, msgLen);
+}
+
+/****************************************
+ * uecho_udp_serverlist_flush
+ ****************************************/
+
+bool uecho_udp_serverlist_flush(uEchoUdpServerList *servers)
+{
+  uEchoUdpServer *server;
+  bool allActionsSucceeded;
+  
+  allActionsSucceeded = true;
+  for (server = uecho_udp_serverlist_gets(servers); server; server = uecho_udp_server_next(server)) {
+    if (uecho_socket_datagram_queue_size(server->sendQueue) <= 0)
+      continue;
+    allActionsSucceeded &= uecho_udp_server_flush(server);
+  }
+  
+  return allActionsSucceeded;
+}
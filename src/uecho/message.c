@@ -9,25 +9,20 @@
  ******************************************************************/
 
 #include <arpa/inet.h>
+#include <string.h>
 
 #include <uecho/util/strings.h>
+#include <uecho/util/pool.h>
 #include <uecho/net/socket.h>
 #include <uecho/message_internal.h>
 #include <uecho/misc.h>
 
 /****************************************
-* uecho_message_new
+* uecho_message_init
 ****************************************/
 
-uEchoMessage *uecho_message_new(void)
+static void uecho_message_init(uEchoMessage *msg, uEchoArena *arena)
 {
-  uEchoMessage *msg;
-
-  msg = (uEchoMessage *)malloc(sizeof(uEchoMessage));
-
-  if (!msg)
-    return NULL;
-
   uecho_message_setehd1(msg, uEchoEhd1);
   uecho_message_setehd2(msg, uEchoEhd2);
   uecho_message_settid(msg, 0);
@@ -36,13 +31,56 @@ uEchoMessage *uecho_message_new(void)
   uecho_message_setesv(msg, 0);
 
   msg->EP = NULL;
+  msg->EPMemSize = 0;
   msg->OPC = 0;
   msg->bytes = NULL;
-  msg->srcAddr = NULL;
+  msg->bytesMemSize = 0;
+  msg->arena = arena;
+  uecho_socket_address_clear(&msg->srcSockAddr);
+  msg->srcAddr[0] = '\0';
+  msg->isSrcAddrFormatted = true;
+}
+
+/****************************************
+* uecho_message_new
+****************************************/
+
+uEchoMessage *uecho_message_new(void)
+{
+  uEchoMessage *msg;
+
+  msg = (uEchoMessage *)uecho_pool_alloc(uEchoPoolMessage, sizeof(uEchoMessage));
+
+  if (!msg)
+    return NULL;
+
+  uecho_message_init(msg, NULL);
  
   return msg;
 }
 
+/****************************************
+* uecho_message_arena_new
+****************************************/
+
+uEchoMessage *uecho_message_arena_new(uEchoArena *arena)
+{
+  uEchoMessage *msg;
+  
+  if (!arena)
+    return uecho_message_new();
+  
+  // The message, its properties and buffers are released all together when the arena is reset
+  
+  msg = (uEchoMessage *)uecho_arena_alloc(arena, sizeof(uEchoMessage));
+  if (!msg)
+    return NULL;
+  
+  uecho_message_init(msg, arena);
+  
+  return msg;
+}
+
 /****************************************
 * uecho_message_delete
 ****************************************/
@@ -54,11 +92,44 @@ bool uecho_message_delete(uEchoMessage *msg)
   
   uecho_message_clear(msg);
 
-  free(msg);
+  if (!msg->arena)
+    uecho_pool_free(uEchoPoolMessage, msg);
   
   return true;
 }
 
+/****************************************
+ * uecho_message_reallocmemory
+ ****************************************/
+
+static void *uecho_message_reallocmemory(uEchoMessage *msg, void *mem, size_t memSize, size_t newMemSize)
+{
+  void *newMem;
+  
+  if (!msg->arena)
+    return realloc(mem, newMemSize);
+  
+  newMem = uecho_arena_alloc(msg->arena, newMemSize);
+  if (!newMem)
+    return NULL;
+  if (mem && (0 < memSize))
+    memcpy(newMem, mem, ((memSize < newMemSize) ? memSize : newMemSize));
+  
+  return newMem;
+}
+
+/****************************************
+ * uecho_message_freememory
+ ****************************************/
+
+static void uecho_message_freememory(uEchoMessage *msg, void *mem)
+{
+  if (msg->arena)
+    return;
+  
+  free(mem);
+}
+
 /****************************************
  * uecho_message_clearproperties
  ****************************************/
@@ -70,16 +141,17 @@ bool uecho_message_clearproperties(uEchoMessage *msg)
   if (!msg)
     return false;
   
-  for (n=0; n<(int)(msg->OPC); n++) {
+  for (n=0; n<(int)(msg->EPMemSize); n++) {
     uecho_property_delete(msg->EP[n]);
     msg->EP[n] = NULL;
   }
   
   if (msg->EP) {
-    free(msg->EP);
+    uecho_message_freememory(msg, msg->EP);
     msg->EP = NULL;
   }
   
+  msg->EPMemSize = 0;
   msg->OPC = 0;
   
   return true;
@@ -95,14 +167,14 @@ bool uecho_message_clear(uEchoMessage *msg)
     return false;
 
   if (msg->bytes) {
-    free(msg->bytes);
+    uecho_message_freememory(msg, msg->bytes);
     msg->bytes = NULL;
   }
+  msg->bytesMemSize = 0;
 
-  if (msg->srcAddr) {
-    free(msg->srcAddr);
-    msg->srcAddr = NULL;
-  }
+  uecho_socket_address_clear(&msg->srcSockAddr);
+  msg->srcAddr[0] = '\0';
+  msg->isSrcAddrFormatted = true;
   
   if (!uecho_message_clearproperties(msg))
     return false;
@@ -210,9 +282,41 @@ bool uecho_message_setopc(uEchoMessage *msg, byte count)
   if (msg->OPC <= 0)
     return true;
   
-  msg->EP = (uEchoProperty**)malloc(sizeof(uEchoProperty*) * count);
+  msg->EP = (uEchoProperty**)uecho_message_reallocmemory(msg, NULL, 0, sizeof(uEchoProperty*) * count);
+  if (!msg->EP) {
+    msg->OPC = 0;
+    return false;
+  }
   for (n=0; n<(int)(msg->OPC); n++) {
-    msg->EP[n] = uecho_property_new();
+    msg->EP[n] = uecho_property_arena_new(msg->arena);
+  }
+  msg->EPMemSize = count;
+  
+  return true;
+}
+
+/****************************************
+ * uecho_message_reserveproperties
+ ****************************************/
+
+static bool uecho_message_reserveproperties(uEchoMessage *msg, size_t count)
+{
+  uEchoProperty **EP;
+  size_t n;
+  
+  if (count <= msg->EPMemSize)
+    return true;
+  
+  EP = (uEchoProperty**)uecho_message_reallocmemory(msg, msg->EP, sizeof(uEchoProperty*) * msg->EPMemSize, sizeof(uEchoProperty*) * count);
+  if (!EP)
+    return false;
+  msg->EP = EP;
+  
+  for (n=msg->EPMemSize; n<count; n++) {
+    msg->EP[n] = uecho_property_arena_new(msg->arena);
+    if (!msg->EP[n])
+      return false;
+    msg->EPMemSize = n + 1;
   }
   
   return true;
@@ -385,7 +489,33 @@ bool uecho_message_isresponsemessage(uEchoMessage *msg, uEchoMessage *resMeg)
 
 void uecho_message_setsourceaddress(uEchoMessage *msg, const char *addr)
 {
-  uecho_strloc(addr, &msg->srcAddr);
+  if (!msg)
+    return;
+  
+  uecho_socket_address_setstring(&msg->srcSockAddr, addr);
+  
+  msg->srcAddr[0] = '\0';
+  if (addr) {
+    strncpy(msg->srcAddr, addr, (sizeof(msg->srcAddr) - 1));
+    msg->srcAddr[sizeof(msg->srcAddr) - 1] = '\0';
+  }
+  msg->isSrcAddrFormatted = true;
+}
+
+/****************************************
+ * uecho_message_setsourcesocketaddress
+ ****************************************/
+
+void uecho_message_setsourcesocketaddress(uEchoMessage *msg, const uEchoSocketAddress *sockAddr)
+{
+  if (!msg || !sockAddr)
+    return;
+  
+  // The address string is formatted only when it is requested
+  
+  uecho_socket_address_copy(&msg->srcSockAddr, sockAddr);
+  msg->srcAddr[0] = '\0';
+  msg->isSrcAddrFormatted = false;
 }
 
 /****************************************
@@ -394,7 +524,16 @@ void uecho_message_setsourceaddress(uEchoMessage *msg, const char *addr)
 
 const char *uecho_message_getsourceaddress(uEchoMessage *msg)
 {
-  return msg->srcAddr;
+  if (!msg)
+    return NULL;
+  
+  if (!msg->isSrcAddrFormatted) {
+    msg->isSrcAddrFormatted = true;
+    if (!uecho_socket_address_tostring(&msg->srcSockAddr, msg->srcAddr, sizeof(msg->srcAddr)))
+      msg->srcAddr[0] = '\0';
+  }
+  
+  return (0 < strlen(msg->srcAddr)) ? msg->srcAddr : NULL;
 }
 
 /****************************************
@@ -403,7 +542,15 @@ const char *uecho_message_getsourceaddress(uEchoMessage *msg)
 
 bool uecho_message_issourceaddress(uEchoMessage *msg, const char *addr)
 {
-  return uecho_streq(msg->srcAddr, addr);
+  uEchoSocketAddress sockAddr;
+  
+  if (!msg)
+    return false;
+  
+  if (uecho_socket_address_isvalid(&msg->srcSockAddr) && uecho_socket_address_setstring(&sockAddr, addr))
+    return uecho_socket_address_equals(&msg->srcSockAddr, &sockAddr);
+  
+  return uecho_streq(uecho_message_getsourceaddress(msg), addr);
 }
 
 /****************************************
@@ -493,10 +640,20 @@ bool uecho_message_addproperty(uEchoMessage *msg, uEchoProperty *prop)
   if (!msg)
     return false;
   
-  msg->OPC++;
+  // Reuse a slot left by a former view parse before growing the array
+  
+  if (msg->OPC < msg->EPMemSize) {
+    uecho_property_delete(msg->EP[msg->OPC]);
+  }
+  else {
+    msg->EP = (uEchoProperty**)uecho_message_reallocmemory(msg, msg->EP, sizeof(uEchoProperty*) * msg->EPMemSize, sizeof(uEchoProperty*) * (msg->OPC + 1));
+    if (!msg->EP)
+      return false;
+    msg->EPMemSize = msg->OPC + 1;
+  }
   
-  msg->EP = (uEchoProperty**)realloc(msg->EP, sizeof(uEchoProperty*) * msg->OPC);
-  msg->EP[(msg->OPC - 1)] = prop;
+  msg->EP[msg->OPC] = prop;
+  msg->OPC++;
   
   return true;
 }
@@ -514,7 +671,7 @@ bool uecho_message_setproperty(uEchoMessage *msg, uEchoPropertyCode propCode, si
   
   prop = uecho_message_getpropertybycode(msg, propCode);
   if (!prop) {
-    prop = uecho_property_new();
+    prop = uecho_property_arena_new(msg->arena);
     if (!prop)
       return false;
     uecho_property_setcode(prop, propCode);
@@ -564,14 +721,11 @@ uEchoProperty *uecho_message_getpropertybycode(uEchoMessage *msg, uEchoPropertyC
 }
 
 /****************************************
- * uecho_message_parse
+ * uecho_message_parseheader
  ****************************************/
 
-bool uecho_message_parse(uEchoMessage *msg, const byte *data, size_t dataLen)
+static bool uecho_message_parseheader(uEchoMessage *msg, const byte *data, size_t dataLen)
 {
-  uEchoProperty *prop;
-  size_t n, offset, count;
-  
   if (!msg)
     return false;
   
@@ -607,6 +761,21 @@ bool uecho_message_parse(uEchoMessage *msg, const byte *data, size_t dataLen)
   
   uecho_message_setesv(msg, data[10]);
   
+  return true;
+}
+
+/****************************************
+ * uecho_message_parse
+ ****************************************/
+
+bool uecho_message_parse(uEchoMessage *msg, const byte *data, size_t dataLen)
+{
+  uEchoProperty *prop;
+  size_t n, offset, count;
+  
+  if (!uecho_message_parseheader(msg, data, dataLen))
+    return false;
+  
   // OPC
   
   uecho_message_setopc(msg, data[11]);
@@ -643,6 +812,57 @@ bool uecho_message_parse(uEchoMessage *msg, const byte *data, size_t dataLen)
   return true;
 }
 
+/****************************************
+ * uecho_message_parseview
+ ****************************************/
+
+bool uecho_message_parseview(uEchoMessage *msg, const byte *data, size_t dataLen)
+{
+  uEchoProperty *prop;
+  size_t n, opc, offset, count;
+  
+  if (!uecho_message_parseheader(msg, data, dataLen))
+    return false;
+  
+  // OPC
+  
+  opc = data[11];
+  msg->OPC = 0;
+  if (!uecho_message_reserveproperties(msg, opc))
+    return false;
+  
+  // EP (EDT points into the specified data without copying)
+  
+  offset = 12;
+  for (n = 0; n<opc; n++) {
+    prop = msg->EP[n];
+
+    // EPC
+    
+    if ((dataLen - 1) < offset)
+      return false;
+    uecho_property_setcode(prop, data[offset++]);
+    
+    // PDC
+    
+    if ((dataLen - 1) < offset)
+      return false;
+    count = data[offset++];
+    
+    // EDT
+    
+    if ((dataLen - 1) < (offset + count - 1))
+      return false;
+    if (!uecho_property_setdataview(prop, (data + offset), count))
+      return false;
+    offset += count;
+  }
+  
+  msg->OPC = opc;
+  
+  return true;
+}
+
 /****************************************
  * uecho_message_parsepacket
  ****************************************/
@@ -655,7 +875,24 @@ bool uecho_message_parsepacket(uEchoMessage *msg, uEchoDatagramPacket *dgmPkt)
   if (!uecho_message_parse(msg, uecho_socket_datagram_packet_getdata(dgmPkt), uecho_socket_datagram_packet_getlength(dgmPkt)))
     return false;
   
-  uecho_message_setsourceaddress(msg, uecho_socket_datagram_packet_getremoteaddress(dgmPkt));
+  uecho_message_setsourcesocketaddress(msg, uecho_socket_datagram_packet_getremotesocketaddress(dgmPkt));
+  
+  return true;
+}
+
+/****************************************
+ * uecho_message_parsepacketview
+ ****************************************/
+
+bool uecho_message_parsepacketview(uEchoMessage *msg, uEchoDatagramPacket *dgmPkt)
+{
+  if (!msg || !dgmPkt)
+    return false;
+  
+  if (!uecho_message_parseview(msg, uecho_socket_datagram_packet_getdata(dgmPkt), uecho_socket_datagram_packet_getlength(dgmPkt)))
+    return false;
+  
+  uecho_message_setsourcesocketaddress(msg, uecho_socket_datagram_packet_getremotesocketaddress(dgmPkt));
   
   return true;
 }
@@ -686,50 +923,151 @@ size_t uecho_message_size(uEchoMessage *msg)
 }
 
 /****************************************
- * uecho_message_getbytes
+ * uecho_message_writebytes
  ****************************************/
 
-byte *uecho_message_getbytes(uEchoMessage *msg)
+size_t uecho_message_writebytes(uEchoMessage *msg, byte *buf, size_t bufLen)
 {
   uEchoProperty *prop;
   size_t n, offset, count;
   
-  if (msg->bytes) {
-    free(msg->bytes);
+  if (!msg || !buf)
+    return 0;
+  
+  if (bufLen < uecho_message_size(msg))
+    return 0;
+  
+  buf[0] = msg->EHD1;
+  buf[1] = msg->EHD2;
+  buf[2] = msg->TID[0];
+  buf[3] = msg->TID[1];
+  buf[4] = msg->SEOJ[0];
+  buf[5] = msg->SEOJ[1];
+  buf[6] = msg->SEOJ[2];
+  buf[7] = msg->DEOJ[0];
+  buf[8] = msg->DEOJ[1];
+  buf[9] = msg->DEOJ[2];
+  buf[10] = msg->ESV;
+  buf[11] = msg->OPC;
+
+  offset = uEchoMessageMinLen;
+  for (n = 0; n<(size_t)(msg->OPC); n++) {
+    prop = uecho_message_getproperty(msg, n);
+    if (!prop)
+      continue;
+    count = uecho_property_getdatasize(prop);
+    buf[offset++] = uecho_property_getcode(prop);
+    buf[offset++] = count;
+    if (count <= 0)
+      continue;
+    memcpy((buf + offset), uecho_property_getdata(prop), count);
+    offset += count;
   }
+  
+  return offset;
+}
 
-  msg->bytes = (byte *)malloc(uecho_message_size(msg));
-
-  msg->bytes[0] = msg->EHD1;
-  msg->bytes[1] = msg->EHD2;
-  msg->bytes[2] = msg->TID[0];
-  msg->bytes[3] = msg->TID[1];
-  msg->bytes[4] = msg->SEOJ[0];
-  msg->bytes[5] = msg->SEOJ[1];
-  msg->bytes[6] = msg->SEOJ[2];
-  msg->bytes[7] = msg->DEOJ[0];
-  msg->bytes[8] = msg->DEOJ[1];
-  msg->bytes[9] = msg->DEOJ[2];
-  msg->bytes[10] = msg->ESV;
-  msg->bytes[11] = msg->OPC;
+/****************************************
+ * uecho_message_getbytes
+ ****************************************/
 
-  offset = 12;
+byte *uecho_message_getbytes(uEchoMessage *msg)
+{
+  size_t msgLen;
+  byte *msgBytes;
+  
+  if (!msg)
+    return NULL;
+  
+  // Reuse the previous buffer unless the message has grown
+  
+  msgLen = uecho_message_size(msg);
+  if (msg->bytesMemSize < msgLen) {
+    msgBytes = (byte *)uecho_message_reallocmemory(msg, msg->bytes, msg->bytesMemSize, msgLen);
+    if (!msgBytes)
+      return NULL;
+    msg->bytes = msgBytes;
+    msg->bytesMemSize = msgLen;
+  }
+  
+  uecho_message_writebytes(msg, msg->bytes, msg->bytesMemSize);
+  
+  return msg->bytes;
+}
+
+#if !defined(WIN32)
+
+/****************************************
+ * uecho_message_getiovecs
+ ****************************************/
+
+size_t uecho_message_getiovecs(uEchoMessage *msg, byte *hdrBuf, size_t hdrBufLen, struct iovec *iovs, size_t iovCnt)
+{
+  uEchoProperty *prop;
+  size_t n, hdrOffset, iovIdx, count;
+  
+  if (!msg || !hdrBuf || !iovs || (iovCnt < 1))
+    return 0;
+  
+  if (hdrBufLen < uecho_message_getiovecheadersize(msg))
+    return 0;
+  
+  // The header and the property codes and counts are written into hdrBuf,
+  // and the property data are referred in place.
+  
+  hdrBuf[0] = msg->EHD1;
+  hdrBuf[1] = msg->EHD2;
+  hdrBuf[2] = msg->TID[0];
+  hdrBuf[3] = msg->TID[1];
+  hdrBuf[4] = msg->SEOJ[0];
+  hdrBuf[5] = msg->SEOJ[1];
+  hdrBuf[6] = msg->SEOJ[2];
+  hdrBuf[7] = msg->DEOJ[0];
+  hdrBuf[8] = msg->DEOJ[1];
+  hdrBuf[9] = msg->DEOJ[2];
+  hdrBuf[10] = msg->ESV;
+  hdrBuf[11] = msg->OPC;
+  
+  hdrOffset = uEchoMessageMinLen;
+  iovIdx = 0;
+  iovs[iovIdx].iov_base = hdrBuf;
+  iovs[iovIdx].iov_len = hdrOffset;
+  
   for (n = 0; n<(size_t)(msg->OPC); n++) {
     prop = uecho_message_getproperty(msg, n);
     if (!prop)
       continue;
     count = uecho_property_getdatasize(prop);
-    msg->bytes[offset++] = uecho_property_getcode(prop);
-    msg->bytes[offset++] = count;
+    
+    // Extend the current header vector while no property data is between
+    
+    if (((byte *)iovs[iovIdx].iov_base + iovs[iovIdx].iov_len) != (hdrBuf + hdrOffset)) {
+      if (iovCnt <= (iovIdx + 1))
+        return 0;
+      iovIdx++;
+      iovs[iovIdx].iov_base = hdrBuf + hdrOffset;
+      iovs[iovIdx].iov_len = 0;
+    }
+    
+    hdrBuf[hdrOffset++] = uecho_property_getcode(prop);
+    hdrBuf[hdrOffset++] = count;
+    iovs[iovIdx].iov_len += 2;
+    
     if (count <= 0)
       continue;
-    memcpy((msg->bytes + offset), uecho_property_getdata(prop), count);
-    offset += count;
+    
+    if (iovCnt <= (iovIdx + 1))
+      return 0;
+    iovIdx++;
+    iovs[iovIdx].iov_base = uecho_property_getdata(prop);
+    iovs[iovIdx].iov_len = count;
   }
   
-  return msg->bytes;
+  return (iovIdx + 1);
 }
 
+#endif
+
 /****************************************
  * uecho_message_set
  ****************************************/
@@ -750,7 +1088,10 @@ bool uecho_message_set(uEchoMessage *msg, uEchoMessage *srcMsg)
   uecho_message_setsourceobjectcode(msg, uecho_message_getsourceobjectcode(srcMsg));
   uecho_message_setdestinationobjectcode(msg, uecho_message_getdestinationobjectcode(srcMsg));
   uecho_message_setesv(msg, uecho_message_getesv(srcMsg));
-  uecho_message_setsourceaddress(msg, uecho_message_getsourceaddress(srcMsg));
+  if (uecho_socket_address_isvalid(&srcMsg->srcSockAddr))
+    uecho_message_setsourcesocketaddress(msg, &srcMsg->srcSockAddr);
+  else
+    uecho_message_setsourceaddress(msg, uecho_message_getsourceaddress(srcMsg));
   
   srcMsgOpc = uecho_message_getopc(srcMsg);
   for (n=0; n<srcMsgOpc; n++) {
@@ -789,15 +1130,43 @@ uEchoMessage *uecho_message_copy(uEchoMessage *srcMsg)
 
 bool uecho_message_equals(uEchoMessage *msg1, uEchoMessage *msg2)
 {
-  size_t msgSize;
-  byte *msg1Bytes, *msg2Bytes;
-
-  msgSize = uecho_message_size(msg1);
-  if (msgSize != uecho_message_size(msg2))
+  uEchoProperty *prop1, *prop2;
+  size_t propSize, n;
+  
+  if (!msg1 || !msg2)
     return false;
-
-  msg1Bytes = uecho_message_getbytes(msg1);
-  msg2Bytes = uecho_message_getbytes(msg2);
-
-  return (memcmp(msg1Bytes, msg2Bytes, msgSize) == 0) ? true : false;
+  
+  // Compare the fields directly instead of serializing the messages
+  
+  if ((msg1->EHD1 != msg2->EHD1) || (msg1->EHD2 != msg2->EHD2))
+    return false;
+  if (memcmp(msg1->TID, msg2->TID, uEchoTIDSize) != 0)
+    return false;
+  if (memcmp(msg1->SEOJ, msg2->SEOJ, uEchoEOJSize) != 0)
+    return false;
+  if (memcmp(msg1->DEOJ, msg2->DEOJ, uEchoEOJSize) != 0)
+    return false;
+  if (((byte)msg1->ESV != (byte)msg2->ESV) || (msg1->OPC != msg2->OPC))
+    return false;
+  
+  for (n = 0; n<(size_t)(msg1->OPC); n++) {
+    prop1 = uecho_message_getproperty(msg1, n);
+    prop2 = uecho_message_getproperty(msg2, n);
+    if (!prop1 || !prop2) {
+      if (prop1 != prop2)
+        return false;
+      continue;
+    }
+    if (uecho_property_getcode(prop1) != uecho_property_getcode(prop2))
+      return false;
+    propSize = uecho_property_getdatasize(prop1);
+    if (propSize != uecho_property_getdatasize(prop2))
+      return false;
+    if (propSize <= 0)
+      continue;
+    if (memcmp(uecho_property_getdata(prop1), uecho_property_getdata(prop2), propSize) != 0)
+      return false;
+  }
+  
+  return true;
 }
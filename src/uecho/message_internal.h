@@ -32,6 +32,7 @@ enum {
   uEchoEhd2 = 0x81,
   uEchoTIDSize = 2,
   uEchoEOJSize = 3,
+  uEchoMessageFrameMaxLen = 65507,
 };
 
 /****************************************
@@ -48,9 +49,14 @@ typedef struct _uEchoMessage
   int ESV;
   byte OPC;
   uEchoProperty **EP;
+  size_t EPMemSize;
   byte *bytes;
+  size_t bytesMemSize;
+  uEchoArena *arena;
 
-  char *srcAddr;
+  uEchoSocketAddress srcSockAddr;
+  char srcAddr[UECHO_NET_SOCKET_ADDRSTRLEN];
+  bool isSrcAddrFormatted;
 } uEchoMessage;
 
 /****************************************
@@ -63,12 +69,25 @@ typedef struct _uEchoMessage
  * Function
  ****************************************/
 
+uEchoMessage *uecho_message_arena_new(uEchoArena *arena);
+#define uecho_message_getarena(msg) (msg->arena)
+
 bool uecho_message_isresponserequired(uEchoMessage *msg);
 bool uecho_message_isresponsemessage(uEchoMessage *msg, uEchoMessage *resMeg);
 bool uecho_message_requestesv2responseesv(uEchoEsv reqEsv, uEchoEsv *resEsv);
 bool uecho_message_requestesv2errorresponseesv(uEchoEsv reqEsv, uEchoEsv *resEsv);
 
 bool uecho_message_parsepacket(uEchoMessage *msg, uEchoDatagramPacket *dgmPkt);
+bool uecho_message_parsepacketview(uEchoMessage *msg, uEchoDatagramPacket *dgmPkt);
+
+#if !defined(WIN32)
+size_t uecho_message_getiovecs(uEchoMessage *msg, byte *hdrBuf, size_t hdrBufLen, struct iovec *iovs, size_t iovCnt);
+#define uecho_message_getiovecheadersize(msg) (uEchoMessageMinLen + (2 * (size_t)(msg->OPC)))
+#define uecho_message_getiovecmaxcount(msg) (1 + (2 * (size_t)(msg->OPC)))
+#endif
+
+void uecho_message_setsourcesocketaddress(uEchoMessage *msg, const uEchoSocketAddress *sockAddr);
+#define uecho_message_getsourcesocketaddress(msg) (&msg->srcSockAddr)
 
 #ifdef  __cplusplus
 } /* extern C */
@@ -9,6 +9,8 @@
  ******************************************************************/
 
 #include <uecho/net/socket.h>
+#include <uecho/net/interface.h>
+#include <uecho/util/pool.h>
 
 /****************************************
 * uecho_socket_datagram_packet_new
@@ -18,17 +20,20 @@ uEchoDatagramPacket *uecho_socket_datagram_packet_new(void)
 {
   uEchoDatagramPacket *dgmPkt;
 
-  dgmPkt = (uEchoDatagramPacket *)malloc(sizeof(uEchoDatagramPacket));
+  dgmPkt = (uEchoDatagramPacket *)uecho_pool_alloc(uEchoPoolDatagramPacket, sizeof(uEchoDatagramPacket));
 
   if (!dgmPkt)
     return NULL;
 
   dgmPkt->data = NULL;
   dgmPkt->dataLen = 0;
+  dgmPkt->dataMemSize = 0;
   
-  uecho_string_new();
   dgmPkt->localAddress = uecho_string_new();
+  dgmPkt->isLocalAddressFormatted = true;
   dgmPkt->remoteAddress = uecho_string_new();
+  dgmPkt->isRemoteAddressFormatted = true;
+  uecho_socket_address_clear(&dgmPkt->remoteSockAddr);
 
   uecho_socket_datagram_packet_setlocalport(dgmPkt, 0);
   uecho_socket_datagram_packet_setremoteport(dgmPkt, 0);
@@ -50,7 +55,7 @@ void uecho_socket_datagram_packet_delete(uEchoDatagramPacket *dgmPkt)
   uecho_string_delete(dgmPkt->localAddress);
   uecho_string_delete(dgmPkt->remoteAddress);
 
-  free(dgmPkt);
+  uecho_pool_free(uEchoPoolDatagramPacket, dgmPkt);
 }
 
 /****************************************
@@ -62,13 +67,12 @@ bool uecho_socket_datagram_packet_setdata(uEchoDatagramPacket *dgmPkt, const byt
   if (!dgmPkt)
     return false;
   
-  uecho_socket_datagram_packet_clear(dgmPkt);
+  dgmPkt->dataLen = 0;
 
   if (!data || (dataLen <= 0))
     return true;
   
-  dgmPkt->data = malloc(dataLen);
-  if (!dgmPkt->data)
+  if (!uecho_socket_datagram_packet_reserve(dgmPkt, dataLen))
     return false;
   
   memcpy(dgmPkt->data, data, dataLen);
@@ -77,6 +81,31 @@ bool uecho_socket_datagram_packet_setdata(uEchoDatagramPacket *dgmPkt, const byt
   return true;
 }
 
+/****************************************
+ * uecho_socket_datagram_packet_reserve
+ ****************************************/
+
+bool uecho_socket_datagram_packet_reserve(uEchoDatagramPacket *dgmPkt, size_t dataMemSize)
+{
+  if (!dgmPkt)
+    return false;
+  
+  // The buffer is kept and reused while it is large enough
+  
+  if (dataMemSize <= dgmPkt->dataMemSize)
+    return true;
+  
+  uecho_socket_datagram_packet_clear(dgmPkt);
+  
+  dgmPkt->data = malloc(dataMemSize);
+  if (!dgmPkt->data)
+    return false;
+  
+  dgmPkt->dataMemSize = dataMemSize;
+  
+  return true;
+}
+
 /****************************************
  * uecho_socket_datagram_packet_clear
  ****************************************/
@@ -91,6 +120,7 @@ bool uecho_socket_datagram_packet_clear(uEchoDatagramPacket *dgmPkt)
     dgmPkt->data = NULL;
   }
   dgmPkt->dataLen = 0;
+  dgmPkt->dataMemSize = 0;
 
   return true;
 }
@@ -112,3 +142,101 @@ bool uecho_socket_datagram_packet_copy(uEchoDatagramPacket *dstDgmPkt, uEchoData
 
   return true;
 }
+
+/****************************************
+* uecho_socket_datagram_packet_setlocaladdress
+****************************************/
+
+void uecho_socket_datagram_packet_setlocaladdress(uEchoDatagramPacket *dgmPkt, const char *addr)
+{
+  if (!dgmPkt)
+    return;
+  
+  uecho_string_setvalue(dgmPkt->localAddress, addr);
+  dgmPkt->isLocalAddressFormatted = true;
+}
+
+/****************************************
+* uecho_socket_datagram_packet_getlocaladdress
+****************************************/
+
+const char *uecho_socket_datagram_packet_getlocaladdress(uEchoDatagramPacket *dgmPkt)
+{
+  struct sockaddr_in remoteAddr;
+  char *localAddr;
+  
+  if (!dgmPkt)
+    return NULL;
+  
+  // The interface address is selected only when it is requested because it scans all interfaces
+  
+  if (!dgmPkt->isLocalAddressFormatted) {
+    dgmPkt->isLocalAddressFormatted = true;
+    uecho_string_setvalue(dgmPkt->localAddress, "");
+    if (dgmPkt->remoteSockAddr.family == AF_INET) {
+      memset(&remoteAddr, 0, sizeof(remoteAddr));
+      remoteAddr.sin_family = AF_INET;
+      memcpy(&remoteAddr.sin_addr, dgmPkt->remoteSockAddr.addr, sizeof(remoteAddr.sin_addr));
+      localAddr = uecho_net_selectaddr((struct sockaddr *)&remoteAddr);
+      if (localAddr) {
+        uecho_string_setvalue(dgmPkt->localAddress, localAddr);
+        free(localAddr);
+      }
+    }
+  }
+  
+  return uecho_string_getvalue(dgmPkt->localAddress);
+}
+
+/****************************************
+* uecho_socket_datagram_packet_setremoteaddress
+****************************************/
+
+void uecho_socket_datagram_packet_setremoteaddress(uEchoDatagramPacket *dgmPkt, const char *addr)
+{
+  if (!dgmPkt)
+    return;
+  
+  uecho_socket_address_setstring(&dgmPkt->remoteSockAddr, addr);
+  uecho_string_setvalue(dgmPkt->remoteAddress, addr);
+  dgmPkt->isRemoteAddressFormatted = true;
+  dgmPkt->isLocalAddressFormatted = false;
+}
+
+/****************************************
+* uecho_socket_datagram_packet_getremoteaddress
+****************************************/
+
+const char *uecho_socket_datagram_packet_getremoteaddress(uEchoDatagramPacket *dgmPkt)
+{
+  char addr[UECHO_NET_SOCKET_ADDRSTRLEN];
+  
+  if (!dgmPkt)
+    return NULL;
+  
+  if (!dgmPkt->isRemoteAddressFormatted) {
+    dgmPkt->isRemoteAddressFormatted = true;
+    if (uecho_socket_address_tostring(&dgmPkt->remoteSockAddr, addr, sizeof(addr)))
+      uecho_string_setvalue(dgmPkt->remoteAddress, addr);
+    else
+      uecho_string_setvalue(dgmPkt->remoteAddress, "");
+  }
+  
+  return uecho_string_getvalue(dgmPkt->remoteAddress);
+}
+
+/****************************************
+* uecho_socket_datagram_packet_setremotesocketaddress
+****************************************/
+
+void uecho_socket_datagram_packet_setremotesocketaddress(uEchoDatagramPacket *dgmPkt, const uEchoSocketAddress *sockAddr)
+{
+  if (!dgmPkt || !sockAddr)
+    return;
+  
+  // The address string is formatted only when it is requested
+  
+  uecho_socket_address_copy(&dgmPkt->remoteSockAddr, sockAddr);
+  dgmPkt->isRemoteAddressFormatted = false;
+  dgmPkt->isLocalAddressFormatted = false;
+}
@@ -0,0 +1,197 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/net/socket.h>
+#include <uecho/net/uring.h>
+
+/****************************************
+* uecho_socket_datagram_queue_new
+****************************************/
+
+uEchoDatagramQueue *uecho_socket_datagram_queue_new(size_t maxPktCnt)
+{
+  uEchoDatagramQueue *queue;
+  size_t n;
+  
+  if (maxPktCnt <= 0)
+    return NULL;
+  
+  queue = (uEchoDatagramQueue *)malloc(sizeof(uEchoDatagramQueue));
+  if (!queue)
+    return NULL;
+  
+  queue->pktCnt = 0;
+  queue->maxPktCnt = maxPktCnt;
+  queue->mutex = uecho_mutex_new();
+  queue->uring = NULL;
+  queue->pkts = (uEchoDatagramPacket **)calloc(maxPktCnt, sizeof(uEchoDatagramPacket *));
+  
+  if (!queue->mutex || !queue->pkts) {
+    uecho_socket_datagram_queue_delete(queue);
+    return NULL;
+  }
+  
+  // Packets are allocated once and their buffers are reused by every flush
+  
+  for (n=0; n<maxPktCnt; n++) {
+    queue->pkts[n] = uecho_socket_datagram_packet_new();
+    if (!queue->pkts[n]) {
+      uecho_socket_datagram_queue_delete(queue);
+      return NULL;
+    }
+  }
+  
+  return queue;
+}
+
+/****************************************
+* uecho_socket_datagram_queue_delete
+****************************************/
+
+void uecho_socket_datagram_queue_delete(uEchoDatagramQueue *queue)
+{
+  size_t n;
+  
+  if (!queue)
+    return;
+  
+  if (queue->pkts) {
+    for (n=0; n<queue->maxPktCnt; n++) {
+      if (queue->pkts[n])
+        uecho_socket_datagram_packet_delete(queue->pkts[n]);
+    }
+    free(queue->pkts);
+  }
+  
+  if (queue->mutex)
+    uecho_mutex_delete(queue->mutex);
+  
+  uecho_uring_delete(queue->uring);
+  
+  free(queue);
+}
+
+/****************************************
+* uecho_socket_datagram_queue_add
+****************************************/
+
+bool uecho_socket_datagram_queue_add(uEchoDatagramQueue *queue, const char *addr, int port, const byte *data, size_t dataLen)
+{
+  uEchoDatagramPacket *dgmPkt;
+  bool isAdded;
+  
+  if (!queue || !addr || !data || (dataLen <= 0))
+    return false;
+  
+  uecho_mutex_lock(queue->mutex);
+  
+  // Return false without blocking when the queue is full so that the caller can flush it first
+  
+  isAdded = false;
+  if (queue->pktCnt < queue->maxPktCnt) {
+    dgmPkt = queue->pkts[queue->pktCnt];
+    if (uecho_socket_datagram_packet_setdata(dgmPkt, data, dataLen)) {
+      uecho_socket_datagram_packet_setremoteaddress(dgmPkt, addr);
+      uecho_socket_datagram_packet_setremoteport(dgmPkt, port);
+      queue->pktCnt++;
+      isAdded = true;
+    }
+  }
+  
+  uecho_mutex_unlock(queue->mutex);
+  
+  return isAdded;
+}
+
+/****************************************
+* uecho_socket_datagram_queue_flush
+****************************************/
+
+bool uecho_socket_datagram_queue_flush(uEchoDatagramQueue *queue, uEchoSocket *sock)
+{
+  ssize_t sentCnt;
+  
+  if (!queue || !sock)
+    return false;
+  
+  uecho_mutex_lock(queue->mutex);
+  
+  sentCnt = 0;
+  if (0 < queue->pktCnt) {
+    if (queue->uring)
+      sentCnt = uecho_uring_sendbatch(queue->uring, sock, queue->pkts, queue->pktCnt);
+    else
+      sentCnt = uecho_socket_sendbatch(sock, queue->pkts, queue->pktCnt);
+  }
+  
+  // Unsent datagrams are dropped as with a failed sendto()
+  
+  queue->pktCnt = 0;
+  
+  uecho_mutex_unlock(queue->mutex);
+  
+  return (0 <= sentCnt) ? true : false;
+}
+
+/****************************************
+* uecho_socket_datagram_queue_size
+****************************************/
+
+size_t uecho_socket_datagram_queue_size(uEchoDatagramQueue *queue)
+{
+  size_t pktCnt;
+  
+  if (!queue)
+    return 0;
+  
+  uecho_mutex_lock(queue->mutex);
+  pktCnt = queue->pktCnt;
+  uecho_mutex_unlock(queue->mutex);
+  
+  return pktCnt;
+}
+
+/****************************************
+* uecho_socket_datagram_queue_isfull
+****************************************/
+
+bool uecho_socket_datagram_queue_isfull(uEchoDatagramQueue *queue)
+{
+  if (!queue)
+    return false;
+  
+  return (queue->maxPktCnt <= uecho_socket_datagram_queue_size(queue)) ? true : false;
+}
+
+/****************************************
+* uecho_socket_datagram_queue_seturingenabled
+****************************************/
+
+bool uecho_socket_datagram_queue_seturingenabled(uEchoDatagramQueue *queue, bool flag)
+{
+  if (!queue)
+    return false;
+  
+  uecho_mutex_lock(queue->mutex);
+  
+  // The ring is used only under the queue lock, so the flushing threads never share it concurrently
+  
+  if (flag && !queue->uring)
+    queue->uring = uecho_uring_new(uEchoUringDefaultEntryCount);
+  
+  if (!flag && queue->uring) {
+    uecho_uring_delete(queue->uring);
+    queue->uring = NULL;
+  }
+  
+  uecho_mutex_unlock(queue->mutex);
+  
+  return (flag == uecho_socket_datagram_queue_isuringenabled(queue)) ? true : false;
+}
@@ -8,11 +8,20 @@
  *
  ******************************************************************/
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if (defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <uecho/net/socket.h>
 #include <uecho/net/interface.h>
 #include <uecho/util/timer.h>
 
 #include <string.h>
+#include <limits.h>
 
 #if defined(WIN32)
 #include <winsock2.h>
@@ -125,6 +134,10 @@ uEchoSocket *uecho_socket_new(int type)
 
   uecho_socket_setaddress(sock, "");
   uecho_socket_setport(sock, -1);
+  uecho_socket_setreuseport(sock, false);
+  sock->multicastTtl = -1;
+  sock->recvBufSize = UECHO_NET_SOCKET_DGRAM_RECV_BUFSIZE;
+  sock->truncatedCnt = 0;
 
 #if defined(UECHO_USE_OPENSSL)
   sock->ctx = NULL;
@@ -194,6 +207,7 @@ void uecho_socket_setid(uEchoSocket *sock, SOCKET value)
     return;
   
   sock->id=value;
+  sock->multicastTtl = -1;
 
 #if defined(WIN32) || defined(HAVE_IP_PKTINFO)
   if ( UECHO_NET_SOCKET_DGRAM == uecho_socket_gettype(socket) ) 
@@ -249,6 +263,7 @@ bool uecho_socket_close(uEchoSocket *sock)
 
   uecho_socket_setaddress(sock, "");
   uecho_socket_setport(sock, -1);
+  sock->multicastTtl = -1;
 
   return true;
 }
@@ -534,7 +549,11 @@ size_t uecho_socket_skip(uEchoSocket *sock, size_t skipLen)
 
 size_t uecho_socket_sendto(uEchoSocket *sock, const char *addr, int port, const byte *data, size_t dataLen)
 {
+#if defined(WIN32)
   struct addrinfo *addrInfo;
+#else
+  uEchoSocketDestination dest;
+#endif
   ssize_t sentLen;
   bool isBoundFlag;
 
@@ -547,6 +566,7 @@ size_t uecho_socket_sendto(uEchoSocket *sock, const char *addr, int port, const
   isBoundFlag = uecho_socket_isbound(sock);
   sentLen = -1;
 
+#if defined(WIN32)
   if (uecho_socket_tosockaddrinfo(uecho_socket_getrawtype(sock), addr, port, &addrInfo, true) == false)
     return -1;
   if (isBoundFlag == false)
@@ -558,6 +578,20 @@ size_t uecho_socket_sendto(uEchoSocket *sock, const char *addr, int port, const
   if (0 <= sock->id)
     sentLen = sendto(sock->id, data, dataLen, 0, addrInfo->ai_addr, addrInfo->ai_addrlen);
   freeaddrinfo(addrInfo);
+#else
+  // The destination is resolved through the address cache instead of getaddrinfo() for every send
+  
+  if (uecho_socket_destination_set(&dest, addr, port) == false)
+    return -1;
+  if (isBoundFlag == false)
+    uecho_socket_setid(sock, socket(dest.sockAddr.ss_family, uecho_socket_getrawtype(sock), 0));
+  
+  /* Setting multicast time to live in any case to default */
+  uecho_socket_setmulticastttl(sock, UECHO_NET_SOCKET_MULTICAST_DEFAULT_TTL);
+  
+  if (0 <= sock->id)
+    sentLen = sendto(sock->id, data, dataLen, 0, (struct sockaddr *)&dest.sockAddr, dest.sockAddrLen);
+#endif
 
   if (isBoundFlag == false)
     uecho_socket_close(sock);
@@ -565,6 +599,74 @@ size_t uecho_socket_sendto(uEchoSocket *sock, const char *addr, int port, const
   return sentLen;
 }
 
+#if !defined(WIN32)
+
+/****************************************
+* uecho_socket_sendmsg
+****************************************/
+
+ssize_t uecho_socket_sendmsg(uEchoSocket *sock, const char *addr, int port, const struct iovec *iovs, size_t iovCnt)
+{
+  uEchoSocketDestination dest;
+  struct msghdr msgHdr;
+  ssize_t sentLen;
+  bool isBoundFlag;
+  
+  if (!sock || !iovs || (iovCnt <= 0))
+    return -1;
+  
+  isBoundFlag = uecho_socket_isbound(sock);
+  sentLen = -1;
+  
+  if (uecho_socket_destination_set(&dest, addr, port) == false)
+    return -1;
+  if (isBoundFlag == false)
+    uecho_socket_setid(sock, socket(dest.sockAddr.ss_family, uecho_socket_getrawtype(sock), 0));
+  
+  /* Setting multicast time to live in any case to default */
+  uecho_socket_setmulticastttl(sock, UECHO_NET_SOCKET_MULTICAST_DEFAULT_TTL);
+  
+  memset(&msgHdr, 0, sizeof(msgHdr));
+  msgHdr.msg_name = &dest.sockAddr;
+  msgHdr.msg_namelen = dest.sockAddrLen;
+  msgHdr.msg_iov = (struct iovec *)iovs;
+  msgHdr.msg_iovlen = iovCnt;
+  
+  if (0 <= sock->id)
+    sentLen = sendmsg(sock->id, &msgHdr, 0);
+  
+  if (isBoundFlag == false)
+    uecho_socket_close(sock);
+  
+  return sentLen;
+}
+
+#endif
+
+/****************************************
+* uecho_socket_datagram_packet_setaddresses
+****************************************/
+
+void uecho_socket_datagram_packet_setaddresses(uEchoSocket *sock, uEchoDatagramPacket *dgmPkt, struct sockaddr *from, socklen_t fromLen)
+{
+  uEchoSocketAddress remoteSockAddr;
+  int remotePort;
+  
+  // Keep the binary source address, the address strings are formatted only on demand
+  
+  uecho_socket_address_setsockaddr(&remoteSockAddr, from);
+  
+  remotePort = 0;
+  if ((from->sa_family == AF_INET) && (sizeof(struct sockaddr_in) <= fromLen))
+    remotePort = ntohs(((struct sockaddr_in *)from)->sin_port);
+  else if ((from->sa_family == AF_INET6) && (sizeof(struct sockaddr_in6) <= fromLen))
+    remotePort = ntohs(((struct sockaddr_in6 *)from)->sin6_port);
+  
+  uecho_socket_datagram_packet_setlocalport(dgmPkt, uecho_socket_getport(sock));
+  uecho_socket_datagram_packet_setremotesocketaddress(dgmPkt, &remoteSockAddr);
+  uecho_socket_datagram_packet_setremoteport(dgmPkt, remotePort);
+}
+
 /****************************************
 * uecho_socket_recv
 ****************************************/
@@ -572,38 +674,182 @@ size_t uecho_socket_sendto(uEchoSocket *sock, const char *addr, int port, const
 ssize_t uecho_socket_recv(uEchoSocket *sock, uEchoDatagramPacket *dgmPkt)
 {
   ssize_t recvLen = 0;
-  byte recvBuf[UECHO_NET_SOCKET_DGRAM_RECV_BUFSIZE+1];
-  char remoteAddr[UECHO_NET_SOCKET_MAXHOST];
-  char remotePort[UECHO_NET_SOCKET_MAXSERV];
-  char *localAddr;
   struct sockaddr_storage from;
   socklen_t fromLen;
+#if !defined(WIN32)
+  struct msghdr msg;
+  struct iovec iov;
+#endif
   
-  if (!sock)
+  if (!sock || !dgmPkt)
     return -1;
   
+  if (!uecho_socket_datagram_packet_reserve(dgmPkt, sock->recvBufSize))
+    return -1;
+  
+#if defined(WIN32)
   fromLen = sizeof(from);
-  recvLen = recvfrom(sock->id, recvBuf, sizeof(recvBuf)-1, 0, (struct sockaddr *)&from, &fromLen);
+  recvLen = recvfrom(sock->id, dgmPkt->data, (int)sock->recvBufSize, 0, (struct sockaddr *)&from, &fromLen);
+#else
+  memset(&msg, 0, sizeof(msg));
+  iov.iov_base = dgmPkt->data;
+  iov.iov_len = sock->recvBufSize;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_name = &from;
+  msg.msg_namelen = sizeof(from);
+  
+  recvLen = recvmsg(sock->id, &msg, 0);
+  fromLen = msg.msg_namelen;
+#endif
 
   if (recvLen <= 0)
     return recvLen;
 
-  uecho_socket_datagram_packet_setdata(dgmPkt, recvBuf, recvLen);
+#if !defined(WIN32)
+  // A datagram larger than the buffer is dropped rather than parsed as a truncated frame
+  
+  if (msg.msg_flags & MSG_TRUNC) {
+    sock->truncatedCnt++;
+    return 0;
+  }
+#endif
+
+  uecho_socket_datagram_packet_setlength(dgmPkt, recvLen);
+  uecho_socket_datagram_packet_setaddresses(sock, dgmPkt, (struct sockaddr *)&from, fromLen);
 
-  uecho_socket_datagram_packet_setlocalport(dgmPkt, uecho_socket_getport(sock));
-  uecho_socket_datagram_packet_setremoteaddress(dgmPkt, "");
-  uecho_socket_datagram_packet_setremoteport(dgmPkt, 0);
+  return recvLen;
+}
 
-  if (getnameinfo((struct sockaddr *)&from, fromLen, remoteAddr, sizeof(remoteAddr), remotePort, sizeof(remotePort), NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
-    uecho_socket_datagram_packet_setremoteaddress(dgmPkt, remoteAddr);
-    uecho_socket_datagram_packet_setremoteport(dgmPkt, uecho_str2int(remotePort));
+/****************************************
+* uecho_socket_recvbatch
+****************************************/
+
+ssize_t uecho_socket_recvbatch(uEchoSocket *sock, uEchoDatagramPacket **dgmPkts, size_t dgmPktCnt)
+{
+#if defined(HAVE_RECVMMSG)
+  struct mmsghdr msgs[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  struct iovec iovecs[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  struct sockaddr_storage froms[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  uEchoDatagramPacket *dgmPkt;
+  int recvCnt, pktCnt, n;
+#else
+  ssize_t recvLen;
+#endif
+  
+  if (!sock || !dgmPkts || (dgmPktCnt <= 0))
+    return -1;
+  
+#if defined(HAVE_RECVMMSG)
+  if (UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE < dgmPktCnt)
+    dgmPktCnt = UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE;
+  
+  memset(msgs, 0, sizeof(struct mmsghdr) * dgmPktCnt);
+  for (n=0; n<(int)dgmPktCnt; n++) {
+    if (!uecho_socket_datagram_packet_reserve(dgmPkts[n], sock->recvBufSize))
+      return -1;
+    iovecs[n].iov_base = dgmPkts[n]->data;
+    iovecs[n].iov_len = sock->recvBufSize;
+    msgs[n].msg_hdr.msg_iov = &iovecs[n];
+    msgs[n].msg_hdr.msg_iovlen = 1;
+    msgs[n].msg_hdr.msg_name = &froms[n];
+    msgs[n].msg_hdr.msg_namelen = sizeof(froms[n]);
   }
+  
+  // Block until the first datagram arrives, then take all queued ones without blocking
+  
+  recvCnt = recvmmsg(sock->id, msgs, (unsigned int)dgmPktCnt, MSG_WAITFORONE, NULL);
+  if (recvCnt <= 0)
+    return (recvCnt == 0) ? 0 : -1;
+  
+  // Truncated datagrams are dropped, and the following packets are moved up to keep the batch contiguous
+  
+  pktCnt = 0;
+  for (n=0; n<recvCnt; n++) {
+    if (msgs[n].msg_hdr.msg_flags & MSG_TRUNC) {
+      sock->truncatedCnt++;
+      continue;
+    }
+    if (pktCnt != n) {
+      dgmPkt = dgmPkts[pktCnt];
+      dgmPkts[pktCnt] = dgmPkts[n];
+      dgmPkts[n] = dgmPkt;
+    }
+    uecho_socket_datagram_packet_setlength(dgmPkts[pktCnt], msgs[n].msg_len);
+    uecho_socket_datagram_packet_setaddresses(sock, dgmPkts[pktCnt], (struct sockaddr *)&froms[n], msgs[n].msg_hdr.msg_namelen);
+    pktCnt++;
+  }
+  
+  return pktCnt;
+#else
+  recvLen = uecho_socket_recv(sock, dgmPkts[0]);
+  if (recvLen < 0)
+    return -1;
+  
+  return (0 < recvLen) ? 1 : 0;
+#endif
+}
 
-  localAddr = uecho_net_selectaddr((struct sockaddr *)&from);
-  uecho_socket_datagram_packet_setlocaladdress(dgmPkt, localAddr);
-  free(localAddr);
+/****************************************
+* uecho_socket_sendbatch
+****************************************/
 
-  return recvLen;
+ssize_t uecho_socket_sendbatch(uEchoSocket *sock, uEchoDatagramPacket **dgmPkts, size_t dgmPktCnt)
+{
+#if defined(HAVE_SENDMMSG)
+  struct mmsghdr msgs[UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE];
+  struct iovec iovecs[UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE];
+  uEchoSocketDestination dests[UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE];
+  size_t batchCnt, addrCnt;
+  int sentCnt;
+#endif
+  ssize_t totalSentCnt;
+  size_t n;
+  
+  if (!sock || !dgmPkts)
+    return -1;
+  
+  totalSentCnt = 0;
+  
+#if defined(HAVE_SENDMMSG)
+  if (uecho_socket_isbound(sock)) {
+    for (n=0; n<dgmPktCnt; n+=batchCnt) {
+      batchCnt = dgmPktCnt - n;
+      if (UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE < batchCnt)
+        batchCnt = UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE;
+      
+      memset(msgs, 0, sizeof(struct mmsghdr) * batchCnt);
+      for (addrCnt=0; addrCnt<batchCnt; addrCnt++) {
+        uEchoDatagramPacket *dgmPkt = dgmPkts[n + addrCnt];
+        if (!uecho_socket_destination_set(&dests[addrCnt], uecho_socket_datagram_packet_getremoteaddress(dgmPkt), uecho_socket_datagram_packet_getremoteport(dgmPkt)))
+          break;
+        iovecs[addrCnt].iov_base = uecho_socket_datagram_packet_getdata(dgmPkt);
+        iovecs[addrCnt].iov_len = uecho_socket_datagram_packet_getlength(dgmPkt);
+        msgs[addrCnt].msg_hdr.msg_iov = &iovecs[addrCnt];
+        msgs[addrCnt].msg_hdr.msg_iovlen = 1;
+        msgs[addrCnt].msg_hdr.msg_name = &dests[addrCnt].sockAddr;
+        msgs[addrCnt].msg_hdr.msg_namelen = dests[addrCnt].sockAddrLen;
+      }
+      
+      sentCnt = (0 < addrCnt) ? sendmmsg(sock->id, msgs, (unsigned int)addrCnt, 0) : 0;
+      
+      if (sentCnt < 0)
+        return (0 < totalSentCnt) ? totalSentCnt : -1;
+      totalSentCnt += sentCnt;
+      if ((size_t)sentCnt < batchCnt)
+        return totalSentCnt;
+    }
+    return totalSentCnt;
+  }
+#endif
+  
+  for (n=0; n<dgmPktCnt; n++) {
+    if (uecho_socket_sendto(sock, uecho_socket_datagram_packet_getremoteaddress(dgmPkts[n]), uecho_socket_datagram_packet_getremoteport(dgmPkts[n]), uecho_socket_datagram_packet_getdata(dgmPkts[n]), uecho_socket_datagram_packet_getlength(dgmPkts[n])) != uecho_socket_datagram_packet_getlength(dgmPkts[n]))
+      break;
+    totalSentCnt++;
+  }
+  
+  return totalSentCnt;
 }
 
 /****************************************
@@ -633,6 +879,12 @@ bool uecho_socket_setreuseaddress(uEchoSocket *sock, bool flag)
     sockOptRet = setsockopt(sock->id, SOL_SOCKET, SO_REUSEPORT, (const char *)&optval, sizeof(optval));
   }
   #endif
+  #if defined(SO_REUSEPORT)
+  // Sockets sharing a port with SO_REUSEPORT get the datagrams balanced by the kernel
+  if ((sockOptRet == 0) && uecho_socket_isreuseportenabled(sock)) {
+    sockOptRet = setsockopt(sock->id, SOL_SOCKET, SO_REUSEPORT, (const char *)&optval, sizeof(optval));
+  }
+  #endif
 #endif
 
   return (sockOptRet == 0) ? true : false;
@@ -651,6 +903,11 @@ bool uecho_socket_setmulticastttl(uEchoSocket *sock, int ttl)
   if (!sock)
     return false;
 
+  // The senders set the TTL before every send, so skip the option calls when it is unchanged
+
+  if (sock->multicastTtl == ttl)
+    return true;
+
 #if defined (WIN32)
   sockOptRet = setsockopt(sock->id, IPPROTO_IP, IP_MULTICAST_TTL, (const char *)&ttl, sizeof(ttl));
 #else
@@ -661,7 +918,12 @@ bool uecho_socket_setmulticastttl(uEchoSocket *sock, int ttl)
   }
 #endif
 
-  return (sockOptRet == 0) ? true : false;
+  if (sockOptRet != 0)
+    return false;
+
+  sock->multicastTtl = ttl;
+
+  return true;
 }
 
 /****************************************
@@ -699,6 +961,93 @@ bool uecho_socket_settimeout(uEchoSocket *sock, int sec)
   return (sockOptRet == 0) ? true : false;
 }
 
+/****************************************
+* uecho_socket_setblocking
+****************************************/
+
+bool uecho_socket_setblocking(uEchoSocket *sock, bool flag)
+{
+#if defined (WIN32)
+  u_long nonBlocking;
+  
+  if (!sock)
+    return false;
+  
+  nonBlocking = (flag == true) ? 0 : 1;
+  return (ioctlsocket(sock->id, FIONBIO, &nonBlocking) == 0) ? true : false;
+#else
+  int fileFlags;
+  
+  if (!sock)
+    return false;
+  
+  fileFlags = fcntl(sock->id, F_GETFL, 0);
+  if (fileFlags < 0)
+    return false;
+  
+  fileFlags = (flag == true) ? (fileFlags & ~O_NONBLOCK) : (fileFlags | O_NONBLOCK);
+  
+  return (fcntl(sock->id, F_SETFL, fileFlags) == 0) ? true : false;
+#endif
+}
+
+/****************************************
+* uecho_socket_setrecvbuffersize
+****************************************/
+
+bool uecho_socket_setrecvbuffersize(uEchoSocket *sock, size_t bufSize)
+{
+  if (!sock)
+    return false;
+  
+  if ((bufSize <= 0) || (UECHO_NET_SOCKET_DGRAM_RECV_MAXBUFSIZE < bufSize))
+    return false;
+  
+  sock->recvBufSize = bufSize;
+  
+  return true;
+}
+
+/****************************************
+* uecho_socket_setrecvqueuesize
+****************************************/
+
+bool uecho_socket_setrecvqueuesize(uEchoSocket *sock, size_t queueSize)
+{
+  int optSize;
+  
+  if (!sock || !uecho_socket_isbound(sock))
+    return false;
+  
+  if ((queueSize <= 0) || (INT_MAX < queueSize))
+    return false;
+  
+  // The kernel may double or clamp the size, uecho_socket_getrecvqueuesize() returns the applied value
+  
+  optSize = (int)queueSize;
+  
+  return (setsockopt(sock->id, SOL_SOCKET, SO_RCVBUF, (const char *)&optSize, sizeof(optSize)) == 0) ? true : false;
+}
+
+/****************************************
+* uecho_socket_getrecvqueuesize
+****************************************/
+
+size_t uecho_socket_getrecvqueuesize(uEchoSocket *sock)
+{
+  int optSize;
+  socklen_t optLen;
+  
+  if (!sock || !uecho_socket_isbound(sock))
+    return 0;
+  
+  optLen = sizeof(optSize);
+  if (getsockopt(sock->id, SOL_SOCKET, SO_RCVBUF, (char *)&optSize, &optLen) != 0)
+    return 0;
+  
+  return (0 < optSize) ? (size_t)optSize : 0;
+}
+
 /****************************************
 * uecho_socket_joingroup
 ****************************************/
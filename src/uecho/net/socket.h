@@ -13,6 +13,14 @@
 
 #include <uecho/typedef.h>
 #include <uecho/util/strings.h>
+#include <uecho/util/mutex.h>
+
+#if !defined(WIN32)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#endif
 
 #if defined(UECHO_USE_OPENSSL)
 #include <openssl/ssl.h>
@@ -36,6 +44,8 @@ extern "C" {
 
 #define UECHO_NET_SOCKET_MAXHOST 32
 #define UECHO_NET_SOCKET_MAXSERV 32
+#define UECHO_NET_SOCKET_ADDRSTRLEN 46
+#define UECHO_NET_SOCKET_ADDRBYTESIZE 16
 
 #if !defined(WIN32)
 typedef int SOCKET;
@@ -44,8 +54,13 @@ typedef int SOCKET;
 #define UECHO_SOCKET_LF '\n'
 
 #define UECHO_NET_SOCKET_DGRAM_RECV_BUFSIZE 512
+#define UECHO_NET_SOCKET_DGRAM_RECV_MAXBUFSIZE 65536
+#define UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE 16
+#define UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE 16
+#define UECHO_NET_SOCKET_DGRAM_SEND_QUEUESIZE 32
 #define UECHO_NET_SOCKET_DGRAM_ANCILLARY_BUFSIZE 512
 #define UECHO_NET_SOCKET_MULTICAST_DEFAULT_TTL 4
+#define UECHO_NET_SOCKET_ADDRCACHE_SIZE 32
 #define UECHO_NET_SOCKET_AUTO_IP_NET 0xa9fe0000
 #define UECHO_NET_SOCKET_AUTO_IP_MASK 0xffff0000 
 
@@ -61,23 +76,68 @@ typedef struct _uEchoSocket {
   int direction;
   uEchoString *ipaddr;
   int port;
+  bool isReusePortEnabled;
+  int multicastTtl;
+  size_t recvBufSize;
+  size_t truncatedCnt;
 #if defined(UECHO_USE_OPENSSL)
   SSL_CTX* ctx;
   SSL* ssl;
 #endif
 } uEchoSocket;
 
+typedef struct _uEchoSocketAddress {
+  int family;
+  byte addr[UECHO_NET_SOCKET_ADDRBYTESIZE];
+} uEchoSocketAddress;
+
+#if !defined(WIN32)
+typedef struct _uEchoSocketDestination {
+  struct sockaddr_storage sockAddr;
+  socklen_t sockAddrLen;
+} uEchoSocketDestination;
+
+typedef struct _uEchoSocketAddressCacheEntry {
+  char addr[UECHO_NET_SOCKET_ADDRSTRLEN];
+  int port;
+  uEchoSocketDestination dest;
+  size_t lastUsed;
+} uEchoSocketAddressCacheEntry;
+
+typedef struct _uEchoSocketAddressCache {
+  uEchoSocketAddressCacheEntry entries[UECHO_NET_SOCKET_ADDRCACHE_SIZE];
+  size_t entryCnt;
+  size_t useCnt;
+  size_t hitCnt;
+  size_t missCnt;
+} uEchoSocketAddressCache;
+#endif
+
 typedef struct _uEchoDatagramPacket {
   byte *data;
   size_t dataLen;
+  size_t dataMemSize;
   
   uEchoString *localAddress;
+  bool isLocalAddressFormatted;
   int localPort;
   
+  uEchoSocketAddress remoteSockAddr;
   uEchoString *remoteAddress;
+  bool isRemoteAddressFormatted;
   int remotePort;
 } uEchoDatagramPacket;
 
+struct _uEchoUring;
+
+typedef struct _uEchoDatagramQueue {
+  uEchoDatagramPacket **pkts;
+  size_t pktCnt;
+  size_t maxPktCnt;
+  uEchoMutex *mutex;
+  struct _uEchoUring *uring;
+} uEchoDatagramQueue;
+
 /****************************************
 * Function (Socket)
 ****************************************/
@@ -125,6 +185,11 @@ size_t uecho_socket_skip(uEchoSocket *sock, size_t skipLen);
 
 size_t uecho_socket_sendto(uEchoSocket *sock, const char *addr, int port, const byte *data, size_t dataeLen);
 ssize_t uecho_socket_recv(uEchoSocket *sock, uEchoDatagramPacket *dgmPkt);
+ssize_t uecho_socket_recvbatch(uEchoSocket *sock, uEchoDatagramPacket **dgmPkts, size_t dgmPktCnt);
+ssize_t uecho_socket_sendbatch(uEchoSocket *sock, uEchoDatagramPacket **dgmPkts, size_t dgmPktCnt);
+#if !defined(WIN32)
+ssize_t uecho_socket_sendmsg(uEchoSocket *sock, const char *addr, int port, const struct iovec *iovs, size_t iovCnt);
+#endif
 
 /****************************************
 * Function (Multicast)
@@ -137,8 +202,16 @@ bool uecho_socket_joingroup(uEchoSocket *sock, const char *mcastAddr, const char
 ****************************************/
 
 bool uecho_socket_setreuseaddress(uEchoSocket *socket, bool flag);
+#define uecho_socket_setreuseport(socket, flag) (socket->isReusePortEnabled = flag)
+#define uecho_socket_isreuseportenabled(socket) (socket->isReusePortEnabled)
 bool uecho_socket_setmulticastttl(uEchoSocket *sock,  int ttl);
 bool uecho_socket_settimeout(uEchoSocket *sock, int sec);
+bool uecho_socket_setblocking(uEchoSocket *sock, bool flag);
+bool uecho_socket_setrecvbuffersize(uEchoSocket *sock, size_t bufSize);
+#define uecho_socket_getrecvbuffersize(socket) (socket->recvBufSize)
+bool uecho_socket_setrecvqueuesize(uEchoSocket *sock, size_t queueSize);
+size_t uecho_socket_getrecvqueuesize(uEchoSocket *sock);
+#define uecho_socket_gettruncatedcount(socket) (socket->truncatedCnt)
 
 /****************************************
 * Function (DatagramPacket)
@@ -148,20 +221,66 @@ uEchoDatagramPacket *uecho_socket_datagram_packet_new(void);
 void uecho_socket_datagram_packet_delete(uEchoDatagramPacket *dgmPkt);
 bool uecho_socket_datagram_packet_setdata(uEchoDatagramPacket *dgmPkt, const byte *data, size_t dataLen);
 bool uecho_socket_datagram_packet_clear(uEchoDatagramPacket *dgmPkt);
+bool uecho_socket_datagram_packet_reserve(uEchoDatagramPacket *dgmPkt, size_t dataMemSize);
+#define uecho_socket_datagram_packet_setlength(dgmPkt, len) (dgmPkt->dataLen = len)
 
 #define uecho_socket_datagram_packet_getdata(dgmPkt) (dgmPkt->data)
 #define uecho_socket_datagram_packet_getlength(dgmPkt) (dgmPkt->dataLen)
 
-#define uecho_socket_datagram_packet_setlocaladdress(dgmPkt, addr) uecho_string_setvalue(dgmPkt->localAddress, addr)
-#define uecho_socket_datagram_packet_getlocaladdress(dgmPkt) uecho_string_getvalue(dgmPkt->localAddress)
+void uecho_socket_datagram_packet_setlocaladdress(uEchoDatagramPacket *dgmPkt, const char *addr);
+const char *uecho_socket_datagram_packet_getlocaladdress(uEchoDatagramPacket *dgmPkt);
 #define uecho_socket_datagram_packet_setlocalport(dgmPkt, port) (dgmPkt->localPort = port)
 #define uecho_socket_datagram_packet_getlocalport(dgmPkt) (dgmPkt->localPort)
-#define uecho_socket_datagram_packet_setremoteaddress(dgmPkt, addr) uecho_string_setvalue(dgmPkt->remoteAddress, addr)
-#define uecho_socket_datagram_packet_getremoteaddress(dgmPkt) uecho_string_getvalue(dgmPkt->remoteAddress)
+void uecho_socket_datagram_packet_setremoteaddress(uEchoDatagramPacket *dgmPkt, const char *addr);
+const char *uecho_socket_datagram_packet_getremoteaddress(uEchoDatagramPacket *dgmPkt);
+void uecho_socket_datagram_packet_setremotesocketaddress(uEchoDatagramPacket *dgmPkt, const uEchoSocketAddress *sockAddr);
+#define uecho_socket_datagram_packet_getremotesocketaddress(dgmPkt) (&dgmPkt->remoteSockAddr)
 #define uecho_socket_datagram_packet_setremoteport(dgmPkt, port) (dgmPkt->remotePort = port)
 #define uecho_socket_datagram_packet_getremoteport(dgmPkt) (dgmPkt->remotePort)
 
 bool uecho_socket_datagram_packet_copy(uEchoDatagramPacket *dstDgmPkt, uEchoDatagramPacket *srcDgmPkt);
+#if !defined(WIN32)
+void uecho_socket_datagram_packet_setaddresses(uEchoSocket *sock, uEchoDatagramPacket *dgmPkt, struct sockaddr *from, socklen_t fromLen);
+#endif
+
+/****************************************
+* Function (SocketAddress)
+****************************************/
+
+void uecho_socket_address_clear(uEchoSocketAddress *sockAddr);
+bool uecho_socket_address_setsockaddr(uEchoSocketAddress *sockAddr, const struct sockaddr *addr);
+bool uecho_socket_address_setstring(uEchoSocketAddress *sockAddr, const char *addr);
+bool uecho_socket_address_tostring(const uEchoSocketAddress *sockAddr, char *buf, size_t bufLen);
+bool uecho_socket_address_equals(const uEchoSocketAddress *sockAddr, const uEchoSocketAddress *otherSockAddr);
+#define uecho_socket_address_isvalid(sockAddr) ((sockAddr)->family != AF_UNSPEC)
+#define uecho_socket_address_copy(dstSockAddr, srcSockAddr) memcpy(dstSockAddr, srcSockAddr, sizeof(uEchoSocketAddress))
+
+/****************************************
+* Function (SocketDestination)
+****************************************/
+
+#if !defined(WIN32)
+bool uecho_socket_destination_set(uEchoSocketDestination *dest, const char *addr, int port);
+ssize_t uecho_socket_sendtodestination(uEchoSocket *sock, const uEchoSocketDestination *dest, const byte *data, size_t dataLen);
+
+void uecho_socket_addresscache_clear(void);
+size_t uecho_socket_addresscache_size(void);
+size_t uecho_socket_addresscache_gethitcount(void);
+size_t uecho_socket_addresscache_getmisscount(void);
+#endif
+
+/****************************************
+* Function (DatagramQueue)
+****************************************/
+
+uEchoDatagramQueue *uecho_socket_datagram_queue_new(size_t maxPktCnt);
+void uecho_socket_datagram_queue_delete(uEchoDatagramQueue *queue);
+bool uecho_socket_datagram_queue_add(uEchoDatagramQueue *queue, const char *addr, int port, const byte *data, size_t dataLen);
+bool uecho_socket_datagram_queue_flush(uEchoDatagramQueue *queue, uEchoSocket *sock);
+size_t uecho_socket_datagram_queue_size(uEchoDatagramQueue *queue);
+bool uecho_socket_datagram_queue_isfull(uEchoDatagramQueue *queue);
+bool uecho_socket_datagram_queue_seturingenabled(uEchoDatagramQueue *queue, bool flag);
+#define uecho_socket_datagram_queue_isuringenabled(queue) ((queue)->uring ? true : false)
 
 /****************************************
 * Function (SSLSocket)
@@ -0,0 +1,118 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/net/socket.h>
+
+#if !defined(WIN32)
+#include <arpa/inet.h>
+#endif
+
+/****************************************
+* uecho_socket_address_clear
+****************************************/
+
+void uecho_socket_address_clear(uEchoSocketAddress *sockAddr)
+{
+  if (!sockAddr)
+    return;
+  
+  memset(sockAddr, 0, sizeof(uEchoSocketAddress));
+  sockAddr->family = AF_UNSPEC;
+}
+
+/****************************************
+* uecho_socket_address_setsockaddr
+****************************************/
+
+bool uecho_socket_address_setsockaddr(uEchoSocketAddress *sockAddr, const struct sockaddr *addr)
+{
+  if (!sockAddr)
+    return false;
+  
+  uecho_socket_address_clear(sockAddr);
+  
+  if (!addr)
+    return false;
+  
+  switch (addr->sa_family) {
+  case AF_INET:
+    sockAddr->family = AF_INET;
+    memcpy(sockAddr->addr, &((const struct sockaddr_in *)addr)->sin_addr, sizeof(struct in_addr));
+    return true;
+  case AF_INET6:
+    sockAddr->family = AF_INET6;
+    memcpy(sockAddr->addr, &((const struct sockaddr_in6 *)addr)->sin6_addr, sizeof(struct in6_addr));
+    return true;
+  }
+  
+  return false;
+}
+
+/****************************************
+* uecho_socket_address_setstring
+****************************************/
+
+bool uecho_socket_address_setstring(uEchoSocketAddress *sockAddr, const char *addr)
+{
+  if (!sockAddr)
+    return false;
+  
+  uecho_socket_address_clear(sockAddr);
+  
+  if (!addr)
+    return false;
+  
+  if (inet_pton(AF_INET, addr, sockAddr->addr) == 1) {
+    sockAddr->family = AF_INET;
+    return true;
+  }
+  
+  if (inet_pton(AF_INET6, addr, sockAddr->addr) == 1) {
+    sockAddr->family = AF_INET6;
+    return true;
+  }
+  
+  uecho_socket_address_clear(sockAddr);
+  
+  return false;
+}
+
+/****************************************
+* uecho_socket_address_tostring
+****************************************/
+
+bool uecho_socket_address_tostring(const uEchoSocketAddress *sockAddr, char *buf, size_t bufLen)
+{
+  if (!sockAddr || !buf || (bufLen <= 0))
+    return false;
+  
+  if (!uecho_socket_address_isvalid(sockAddr))
+    return false;
+  
+  return inet_ntop(sockAddr->family, (void *)sockAddr->addr, buf, bufLen) ? true : false;
+}
+
+/****************************************
+* uecho_socket_address_equals
+****************************************/
+
+bool uecho_socket_address_equals(const uEchoSocketAddress *sockAddr, const uEchoSocketAddress *otherSockAddr)
+{
+  if (!sockAddr || !otherSockAddr)
+    return false;
+  
+  if (!uecho_socket_address_isvalid(sockAddr))
+    return false;
+  
+  if (sockAddr->family != otherSockAddr->family)
+    return false;
+  
+  return (memcmp(sockAddr->addr, otherSockAddr->addr, UECHO_NET_SOCKET_ADDRBYTESIZE) == 0) ? true : false;
+}
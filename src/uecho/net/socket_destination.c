@@ -0,0 +1,194 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <uecho/net/socket.h>
+
+#include <string.h>
+
+#if !defined(WIN32)
+#include <netdb.h>
+
+/****************************************
+* prototype
+****************************************/
+
+bool uecho_socket_tosockaddrinfo(int sockType, const char *addr, int port, struct addrinfo **addrInfo, bool isBindAddr);
+
+/****************************************
+* static variable
+****************************************/
+
+#if defined(HAVE_THREAD_LOCAL)
+static __thread uEchoSocketAddressCache uecho_socket_addrcache;
+#endif
+
+/****************************************
+* uecho_socket_destination_resolve
+****************************************/
+
+static bool uecho_socket_destination_resolve(uEchoSocketDestination *dest, const char *addr, int port)
+{
+  struct addrinfo *addrInfo;
+  
+  if (!uecho_socket_tosockaddrinfo(SOCK_DGRAM, addr, port, &addrInfo, true))
+    return false;
+  
+  if (sizeof(dest->sockAddr) < addrInfo->ai_addrlen) {
+    freeaddrinfo(addrInfo);
+    return false;
+  }
+  
+  memset(dest, 0, sizeof(uEchoSocketDestination));
+  memcpy(&dest->sockAddr, addrInfo->ai_addr, addrInfo->ai_addrlen);
+  dest->sockAddrLen = addrInfo->ai_addrlen;
+  
+  freeaddrinfo(addrInfo);
+  
+  return true;
+}
+
+/****************************************
+* uecho_socket_destination_set
+****************************************/
+
+bool uecho_socket_destination_set(uEchoSocketDestination *dest, const char *addr, int port)
+{
+#if defined(HAVE_THREAD_LOCAL)
+  uEchoSocketAddressCache *cache;
+  uEchoSocketAddressCacheEntry *entry, *lruEntry;
+  size_t n;
+#endif
+  
+  if (!dest || !addr)
+    return false;
+  
+#if defined(HAVE_THREAD_LOCAL)
+  // Each thread keeps its own cache, so the lookups need no locks
+  
+  cache = &uecho_socket_addrcache;
+  cache->useCnt++;
+  
+  lruEntry = NULL;
+  for (n=0; n<cache->entryCnt; n++) {
+    entry = &cache->entries[n];
+    if ((entry->port == port) && (strcmp(entry->addr, addr) == 0)) {
+      entry->lastUsed = cache->useCnt;
+      memcpy(dest, &entry->dest, sizeof(uEchoSocketDestination));
+      cache->hitCnt++;
+      return true;
+    }
+    if (!lruEntry || (entry->lastUsed < lruEntry->lastUsed))
+      lruEntry = entry;
+  }
+  
+  cache->missCnt++;
+  
+  if (!uecho_socket_destination_resolve(dest, addr, port))
+    return false;
+  
+  // Addresses too long for an entry are resolved every time
+  
+  if (sizeof(lruEntry->addr) <= strlen(addr))
+    return true;
+  
+  if (cache->entryCnt < UECHO_NET_SOCKET_ADDRCACHE_SIZE)
+    lruEntry = &cache->entries[cache->entryCnt++];
+  
+  strcpy(lruEntry->addr, addr);
+  lruEntry->port = port;
+  lruEntry->lastUsed = cache->useCnt;
+  memcpy(&lruEntry->dest, dest, sizeof(uEchoSocketDestination));
+  
+  return true;
+#else
+  return uecho_socket_destination_resolve(dest, addr, port);
+#endif
+}
+
+/****************************************
+* uecho_socket_sendtodestination
+****************************************/
+
+ssize_t uecho_socket_sendtodestination(uEchoSocket *sock, const uEchoSocketDestination *dest, const byte *data, size_t dataLen)
+{
+  if (!sock || !dest)
+    return -1;
+  
+  if (!data || (dataLen <= 0))
+    return 0;
+  
+  // An unbound socket gets a socket for the destination family once, and keeps it until it is closed.
+  // The multicast TTL is set only then, bound sockets have it set when they are opened.
+  
+  if (!uecho_socket_isbound(sock)) {
+    uecho_socket_setid(sock, socket(dest->sockAddr.ss_family, SOCK_DGRAM, 0));
+    if (!uecho_socket_isbound(sock))
+      return -1;
+    uecho_socket_setmulticastttl(sock, UECHO_NET_SOCKET_MULTICAST_DEFAULT_TTL);
+  }
+  
+  return sendto(sock->id, data, dataLen, 0, (const struct sockaddr *)&dest->sockAddr, dest->sockAddrLen);
+}
+
+/****************************************
+* uecho_socket_addresscache_clear
+****************************************/
+
+void uecho_socket_addresscache_clear(void)
+{
+#if defined(HAVE_THREAD_LOCAL)
+  memset(&uecho_socket_addrcache, 0, sizeof(uEchoSocketAddressCache));
+#endif
+}
+
+/****************************************
+* uecho_socket_addresscache_size
+****************************************/
+
+size_t uecho_socket_addresscache_size(void)
+{
+#if defined(HAVE_THREAD_LOCAL)
+  return uecho_socket_addrcache.entryCnt;
+#else
+  return 0;
+#endif
+}
+
+/****************************************
+* uecho_socket_addresscache_gethitcount
+****************************************/
+
+size_t uecho_socket_addresscache_gethitcount(void)
+{
+#if defined(HAVE_THREAD_LOCAL)
+  return uecho_socket_addrcache.hitCnt;
+#else
+  return 0;
+#endif
+}
+
+/****************************************
+* uecho_socket_addresscache_getmisscount
+****************************************/
+
+size_t uecho_socket_addresscache_getmisscount(void)
+{
+#if defined(HAVE_THREAD_LOCAL)
+  return uecho_socket_addrcache.missCnt;
+#else
+  return 0;
+#endif
+}
+
+#endif
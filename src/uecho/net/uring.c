@@ -0,0 +1,517 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <uecho/net/uring.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_IO_URING)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#if defined(HAVE_IO_URING)
+
+/****************************************
+* Define
+****************************************/
+
+#define uecho_uring_getsqe(ring, idx) (&((struct io_uring_sqe *)ring->sqes)[idx])
+#define uecho_uring_getcqe(ring, idx) (&((struct io_uring_cqe *)ring->cqes)[idx])
+#define uecho_uring_getbufring(ring) ((struct io_uring_buf_ring *)ring->bufRing)
+#define uecho_uring_getbuf(ring, bid) (ring->bufs + ((size_t)(bid) * ring->bufSize))
+
+enum {
+  uEchoUringUserDataRecv = 1,
+  uEchoUringUserDataSend = 2,
+};
+
+/****************************************
+* uecho_uring_enter
+****************************************/
+
+static int uecho_uring_enter(uEchoUring *ring, unsigned int submitCnt, unsigned int minCompleteCnt, clock_t waitMiliTime)
+{
+  struct io_uring_getevents_arg arg;
+  struct __kernel_timespec ts;
+  unsigned int flags;
+  
+  flags = (0 < minCompleteCnt) ? IORING_ENTER_GETEVENTS : 0;
+  
+  if (waitMiliTime <= 0)
+    return (int)syscall(__NR_io_uring_enter, ring->fd, submitCnt, minCompleteCnt, flags, NULL, 0);
+  
+  // Wait with a timeout so that the caller can check whether it should keep running
+  
+  memset(&arg, 0, sizeof(arg));
+  ts.tv_sec = waitMiliTime / 1000;
+  ts.tv_nsec = (waitMiliTime % 1000) * 1000000;
+  arg.ts = (unsigned long)&ts;
+  
+  return (int)syscall(__NR_io_uring_enter, ring->fd, submitCnt, minCompleteCnt, (flags | IORING_ENTER_EXT_ARG), &arg, sizeof(arg));
+}
+
+/****************************************
+* uecho_uring_submit
+****************************************/
+
+static size_t uecho_uring_submit(uEchoUring *ring, unsigned int submitCnt, unsigned int minCompleteCnt)
+{
+  unsigned int head, tail;
+  
+  while (uecho_uring_enter(ring, submitCnt, minCompleteCnt, 0) < 0) {
+    if (errno != EINTR)
+      break;
+  }
+  
+  // Drop the entries the kernel did not take, their buffers may not outlive the caller
+  
+  head = __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+  tail = *ring->sqTail;
+  if (head != tail) {
+    __atomic_store_n(ring->sqTail, head, __ATOMIC_RELEASE);
+    submitCnt -= (tail - head);
+  }
+  
+  return submitCnt;
+}
+
+/****************************************
+* uecho_uring_nextsqe
+****************************************/
+
+static struct io_uring_sqe *uecho_uring_nextsqe(uEchoUring *ring)
+{
+  struct io_uring_sqe *sqe;
+  unsigned int head, tail, idx;
+  
+  head = __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+  tail = *ring->sqTail;
+  if ((*ring->sqMask + 1) <= (tail - head))
+    return NULL;
+  
+  idx = tail & *ring->sqMask;
+  sqe = uecho_uring_getsqe(ring, idx);
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  ring->sqArray[idx] = idx;
+  
+  __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+  
+  return sqe;
+}
+
+/****************************************
+* uecho_uring_addrecvbuffer
+****************************************/
+
+static void uecho_uring_addrecvbuffer(uEchoUring *ring, unsigned short bid)
+{
+  struct io_uring_buf_ring *bufRing;
+  struct io_uring_buf *buf;
+  
+  bufRing = uecho_uring_getbufring(ring);
+  buf = &bufRing->bufs[ring->bufRingTail & (uEchoUringRecvBufferCount - 1)];
+  buf->addr = (unsigned long)uecho_uring_getbuf(ring, bid);
+  buf->len = (unsigned int)ring->bufSize;
+  buf->bid = bid;
+  
+  ring->bufRingTail++;
+  __atomic_store_n(&bufRing->tail, ring->bufRingTail, __ATOMIC_RELEASE);
+}
+
+/****************************************
+* uecho_uring_armrecv
+****************************************/
+
+static bool uecho_uring_armrecv(uEchoUring *ring, uEchoSocket *sock)
+{
+  struct io_uring_sqe *sqe;
+  unsigned short n;
+  
+  // The buffers are sized for the first socket received on, since the kernel may still hold some of them afterwards
+  
+  if (!ring->bufs) {
+    ring->bufSize = uEchoUringRecvHeaderSize + uecho_socket_getrecvbuffersize(sock);
+    ring->bufs = (byte *)malloc(uEchoUringRecvBufferCount * ring->bufSize);
+    if (!ring->bufs)
+      return false;
+    for (n=0; n<uEchoUringRecvBufferCount; n++)
+      uecho_uring_addrecvbuffer(ring, n);
+  }
+  
+  // A multishot recvmsg keeps posting a completion per datagram until it is cancelled or runs out of buffers
+  
+  sqe = uecho_uring_nextsqe(ring);
+  if (!sqe)
+    return false;
+  
+  memset(&ring->recvMsgHdr, 0, sizeof(ring->recvMsgHdr));
+  ring->recvMsgHdr.msg_namelen = sizeof(struct sockaddr_storage);
+  
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = sock->id;
+  sqe->addr = (unsigned long)&ring->recvMsgHdr;
+  sqe->len = 1;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = uEchoUringRecvBufferGroup;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->user_data = uEchoUringUserDataRecv;
+  
+  if (uecho_uring_submit(ring, 1, 0) <= 0)
+    return false;
+  
+  ring->recvSockId = sock->id;
+  ring->isRecvArmed = true;
+  
+  return true;
+}
+
+#endif
+
+/****************************************
+* uecho_uring_new
+****************************************/
+
+uEchoUring *uecho_uring_new(size_t entryCnt)
+{
+#if defined(HAVE_IO_URING)
+  struct io_uring_params params;
+  struct io_uring_buf_reg bufReg;
+  uEchoUring *ring;
+  
+  ring = (uEchoUring *)calloc(1, sizeof(uEchoUring));
+  if (!ring)
+    return NULL;
+  
+  ring->fd = -1;
+  ring->recvSockId = -1;
+  ring->isRecvArmed = false;
+  ring->isRecvSupported = true;
+  
+  memset(&params, 0, sizeof(params));
+  ring->fd = (int)syscall(__NR_io_uring_setup, (unsigned int)entryCnt, &params);
+  if (ring->fd < 0) {
+    uecho_uring_delete(ring);
+    return NULL;
+  }
+  
+  // The receive timeout relies on IORING_ENTER_EXT_ARG, so older kernels use the socket functions instead
+  
+  if (!(params.features & IORING_FEAT_EXT_ARG)) {
+    uecho_uring_delete(ring);
+    return NULL;
+  }
+  
+  ring->sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+  ring->cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->sqRingSize < ring->cqRingSize)
+      ring->sqRingSize = ring->cqRingSize;
+    ring->cqRingSize = 0;
+  }
+  
+  ring->sqRing = mmap(NULL, ring->sqRingSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sqRing == MAP_FAILED) {
+    ring->sqRing = NULL;
+    uecho_uring_delete(ring);
+    return NULL;
+  }
+  
+  if (0 < ring->cqRingSize) {
+    ring->cqRing = mmap(NULL, ring->cqRingSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cqRing == MAP_FAILED) {
+      ring->cqRing = NULL;
+      uecho_uring_delete(ring);
+      return NULL;
+    }
+  }
+  
+  ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqesSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), ring->fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    ring->sqes = NULL;
+    uecho_uring_delete(ring);
+    return NULL;
+  }
+  
+  ring->sqHead = (unsigned int *)((byte *)ring->sqRing + params.sq_off.head);
+  ring->sqTail = (unsigned int *)((byte *)ring->sqRing + params.sq_off.tail);
+  ring->sqMask = (unsigned int *)((byte *)ring->sqRing + params.sq_off.ring_mask);
+  ring->sqArray = (unsigned int *)((byte *)ring->sqRing + params.sq_off.array);
+  
+  ring->cqHead = (unsigned int *)((byte *)(ring->cqRing ? ring->cqRing : ring->sqRing) + params.cq_off.head);
+  ring->cqTail = (unsigned int *)((byte *)(ring->cqRing ? ring->cqRing : ring->sqRing) + params.cq_off.tail);
+  ring->cqMask = (unsigned int *)((byte *)(ring->cqRing ? ring->cqRing : ring->sqRing) + params.cq_off.ring_mask);
+  ring->cqes = (byte *)(ring->cqRing ? ring->cqRing : ring->sqRing) + params.cq_off.cqes;
+  
+  // Register a provided buffer ring, the kernel picks one buffer per datagram after the first receive fills it
+  
+  ring->bufRingSize = uEchoUringRecvBufferCount * sizeof(struct io_uring_buf);
+  ring->bufRing = mmap(NULL, ring->bufRingSize, (PROT_READ | PROT_WRITE), (MAP_ANONYMOUS | MAP_PRIVATE), -1, 0);
+  if (ring->bufRing == MAP_FAILED) {
+    ring->bufRing = NULL;
+    uecho_uring_delete(ring);
+    return NULL;
+  }
+  
+  memset(&bufReg, 0, sizeof(bufReg));
+  bufReg.ring_addr = (unsigned long)ring->bufRing;
+  bufReg.ring_entries = uEchoUringRecvBufferCount;
+  bufReg.bgid = uEchoUringRecvBufferGroup;
+  if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PBUF_RING, &bufReg, 1) != 0)
+    ring->isRecvSupported = false;
+  
+  ring->bufs = NULL;
+  ring->bufSize = 0;
+  ring->bufRingTail = 0;
+  
+  return ring;
+#else
+  return NULL;
+#endif
+}
+
+/****************************************
+* uecho_uring_delete
+****************************************/
+
+void uecho_uring_delete(uEchoUring *ring)
+{
+  if (!ring)
+    return;
+  
+#if defined(HAVE_IO_URING)
+  // Closing the ring cancels the pending multishot receive and releases the socket
+  
+  if (0 <= ring->fd)
+    close(ring->fd);
+  if (ring->sqes)
+    munmap(ring->sqes, ring->sqesSize);
+  if (ring->cqRing)
+    munmap(ring->cqRing, ring->cqRingSize);
+  if (ring->sqRing)
+    munmap(ring->sqRing, ring->sqRingSize);
+  if (ring->bufRing)
+    munmap(ring->bufRing, ring->bufRingSize);
+#endif
+  
+  if (ring->bufs)
+    free(ring->bufs);
+  
+  free(ring);
+}
+
+/****************************************
+* uecho_uring_isavailable
+****************************************/
+
+bool uecho_uring_isavailable(void)
+{
+  uEchoUring *ring;
+  bool isAvailable;
+  
+  ring = uecho_uring_new(uEchoUringDefaultEntryCount);
+  if (!ring)
+    return false;
+  
+  isAvailable = ring->isRecvSupported;
+  
+  uecho_uring_delete(ring);
+  
+  return isAvailable;
+}
+
+/****************************************
+* uecho_uring_recvbatch
+****************************************/
+
+ssize_t uecho_uring_recvbatch(uEchoUring *ring, uEchoSocket *sock, uEchoDatagramPacket **dgmPkts, size_t dgmPktCnt, clock_t waitMiliTime)
+{
+#if defined(HAVE_IO_URING)
+  struct io_uring_cqe *cqe;
+  struct io_uring_recvmsg_out *msgOut;
+  unsigned int head, tail;
+  unsigned short bid;
+  byte *buf, *payload;
+  size_t payloadLen, headerLen;
+  ssize_t recvCnt;
+  int res;
+#endif
+  
+  if (!ring || !sock || !dgmPkts || (dgmPktCnt <= 0))
+    return -1;
+  
+#if defined(HAVE_IO_URING)
+  if (!ring->isRecvSupported)
+    return uecho_socket_recvbatch(sock, dgmPkts, dgmPktCnt);
+  
+  if (!ring->isRecvArmed || (ring->recvSockId != sock->id)) {
+    if (!uecho_uring_armrecv(ring, sock))
+      return -1;
+  }
+  
+  head = *ring->cqHead;
+  tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    if (uecho_uring_enter(ring, 0, 1, waitMiliTime) < 0)
+      return ((errno == ETIME) || (errno == EINTR)) ? 0 : -1;
+    tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+  }
+  
+  recvCnt = 0;
+  for (; (head != tail) && (recvCnt < (ssize_t)dgmPktCnt); head++) {
+    cqe = uecho_uring_getcqe(ring, head & *ring->cqMask);
+    if (cqe->user_data != uEchoUringUserDataRecv)
+      continue;
+  
+    if (!(cqe->flags & IORING_CQE_F_MORE))
+      ring->isRecvArmed = false;
+  
+    res = cqe->res;
+    if (res < 0) {
+      // Kernels without multishot recvmsg reject it, so keep receiving with the socket functions
+  
+      if (res == -EINVAL)
+        ring->isRecvSupported = false;
+      continue;
+    }
+  
+    if (!(cqe->flags & IORING_CQE_F_BUFFER))
+      continue;
+  
+    bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    buf = uecho_uring_getbuf(ring, bid);
+    msgOut = (struct io_uring_recvmsg_out *)buf;
+    headerLen = sizeof(struct io_uring_recvmsg_out) + ring->recvMsgHdr.msg_namelen + ring->recvMsgHdr.msg_controllen;
+  
+    // Truncated datagrams are dropped as in the socket functions
+  
+    if (msgOut->flags & MSG_TRUNC) {
+      sock->truncatedCnt++;
+    }
+    else if (headerLen <= (size_t)res) {
+      payload = buf + headerLen;
+      payloadLen = (size_t)res - headerLen;
+      if (msgOut->payloadlen < payloadLen)
+        payloadLen = msgOut->payloadlen;
+      if (uecho_socket_datagram_packet_setdata(dgmPkts[recvCnt], payload, payloadLen)) {
+        uecho_socket_datagram_packet_setaddresses(sock, dgmPkts[recvCnt], (struct sockaddr *)(buf + sizeof(struct io_uring_recvmsg_out)), ((msgOut->namelen < ring->recvMsgHdr.msg_namelen) ? msgOut->namelen : ring->recvMsgHdr.msg_namelen));
+        recvCnt++;
+      }
+    }
+  
+    uecho_uring_addrecvbuffer(ring, bid);
+  }
+  
+  __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+  
+  return recvCnt;
+#else
+  return uecho_socket_recvbatch(sock, dgmPkts, dgmPktCnt);
+#endif
+}
+
+/****************************************
+* uecho_uring_sendbatch
+****************************************/
+
+ssize_t uecho_uring_sendbatch(uEchoUring *ring, uEchoSocket *sock, uEchoDatagramPacket **dgmPkts, size_t dgmPktCnt)
+{
+#if defined(HAVE_IO_URING)
+  struct io_uring_sqe *sqe;
+  struct io_uring_cqe *cqe;
+  struct msghdr msgHdrs[UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE];
+  struct iovec iovecs[UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE];
+  uEchoSocketDestination dests[UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE];
+  unsigned int head, tail;
+  size_t batchCnt, addrCnt, submitCnt, doneCnt, sentCnt, n;
+  ssize_t totalSentCnt;
+#endif
+  
+  if (!ring || !sock || !dgmPkts)
+    return -1;
+  
+#if defined(HAVE_IO_URING)
+  if (!uecho_socket_isbound(sock))
+    return uecho_socket_sendbatch(sock, dgmPkts, dgmPktCnt);
+  
+  totalSentCnt = 0;
+  for (n=0; n<dgmPktCnt; n+=batchCnt) {
+    batchCnt = dgmPktCnt - n;
+    if (UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE < batchCnt)
+      batchCnt = UECHO_NET_SOCKET_DGRAM_SEND_BATCHSIZE;
+  
+    // Queue a sendmsg per datagram and submit them all with a single system call
+  
+    for (addrCnt=0; addrCnt<batchCnt; addrCnt++) {
+      uEchoDatagramPacket *dgmPkt = dgmPkts[n + addrCnt];
+      if (!uecho_socket_destination_set(&dests[addrCnt], uecho_socket_datagram_packet_getremoteaddress(dgmPkt), uecho_socket_datagram_packet_getremoteport(dgmPkt)))
+        break;
+      sqe = uecho_uring_nextsqe(ring);
+      if (!sqe)
+        break;
+      iovecs[addrCnt].iov_base = uecho_socket_datagram_packet_getdata(dgmPkt);
+      iovecs[addrCnt].iov_len = uecho_socket_datagram_packet_getlength(dgmPkt);
+      memset(&msgHdrs[addrCnt], 0, sizeof(struct msghdr));
+      msgHdrs[addrCnt].msg_iov = &iovecs[addrCnt];
+      msgHdrs[addrCnt].msg_iovlen = 1;
+      msgHdrs[addrCnt].msg_name = &dests[addrCnt].sockAddr;
+      msgHdrs[addrCnt].msg_namelen = dests[addrCnt].sockAddrLen;
+      sqe->opcode = IORING_OP_SENDMSG;
+      sqe->fd = sock->id;
+      sqe->addr = (unsigned long)&msgHdrs[addrCnt];
+      sqe->len = 1;
+      sqe->user_data = uEchoUringUserDataSend;
+    }
+  
+    submitCnt = (0 < addrCnt) ? uecho_uring_submit(ring, (unsigned int)addrCnt, (unsigned int)addrCnt) : 0;
+  
+    // Reap the completions before the message headers on the stack go away
+  
+    sentCnt = 0;
+    for (doneCnt=0; doneCnt<submitCnt; ) {
+      head = *ring->cqHead;
+      tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+      if (head == tail) {
+        if ((uecho_uring_enter(ring, 0, 1, 0) < 0) && (errno != EINTR))
+          break;
+        continue;
+      }
+      for (; head != tail; head++) {
+        cqe = uecho_uring_getcqe(ring, head & *ring->cqMask);
+        if (cqe->user_data != uEchoUringUserDataSend)
+          continue;
+        if (0 <= cqe->res)
+          sentCnt++;
+        doneCnt++;
+      }
+      __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+  
+    if ((0 < addrCnt) && (submitCnt <= 0))
+      return (0 < totalSentCnt) ? totalSentCnt : -1;
+    totalSentCnt += sentCnt;
+    if ((size_t)sentCnt < batchCnt)
+      return totalSentCnt;
+  }
+  
+  return totalSentCnt;
+#else
+  return uecho_socket_sendbatch(sock, dgmPkts, dgmPktCnt);
+#endif
+}
@@ -0,0 +1,82 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#ifndef _UECHO_NET_URING_H_
+#define _UECHO_NET_URING_H_
+
+#include <uecho/typedef.h>
+#include <uecho/net/socket.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/****************************************
+* Constant
+****************************************/
+
+enum {
+  uEchoUringDefaultEntryCount = 64,
+  uEchoUringRecvBufferCount = 64,
+  uEchoUringRecvHeaderSize = 256,
+  uEchoUringRecvBufferGroup = 1,
+};
+
+/****************************************
+* Data Type
+****************************************/
+
+typedef struct _uEchoUring {
+  int fd;
+
+  void *sqRing;
+  size_t sqRingSize;
+  unsigned int *sqHead;
+  unsigned int *sqTail;
+  unsigned int *sqMask;
+  unsigned int *sqArray;
+  void *sqes;
+  size_t sqesSize;
+
+  void *cqRing;
+  size_t cqRingSize;
+  unsigned int *cqHead;
+  unsigned int *cqTail;
+  unsigned int *cqMask;
+  void *cqes;
+
+  void *bufRing;
+  size_t bufRingSize;
+  byte *bufs;
+  size_t bufSize;
+  unsigned short bufRingTail;
+
+  SOCKET recvSockId;
+  bool isRecvArmed;
+  bool isRecvSupported;
+  struct msghdr recvMsgHdr;
+} uEchoUring;
+
+/****************************************
+* Function
+****************************************/
+
+uEchoUring *uecho_uring_new(size_t entryCnt);
+void uecho_uring_delete(uEchoUring *ring);
+bool uecho_uring_isavailable(void);
+
+ssize_t uecho_uring_recvbatch(uEchoUring *ring, uEchoSocket *sock, uEchoDatagramPacket **dgmPkts, size_t dgmPktCnt, clock_t waitMiliTime);
+ssize_t uecho_uring_sendbatch(uEchoUring *ring, uEchoSocket *sock, uEchoDatagramPacket **dgmPkts, size_t dgmPktCnt);
+
+#ifdef  __cplusplus
+} /* extern C */
+#endif
+
+#endif /* _UECHO_NET_URING_H_ */
@@ -13,13 +13,12 @@
 #include <uecho/misc.h>
 
 /****************************************
-* uecho_node_new
+* uecho_node_alloc
 ****************************************/
 
-uEchoNode *uecho_node_new(void)
+static uEchoNode *uecho_node_alloc(void)
 {
   uEchoNode *node;
-  uEchoObject *obj;
 
   node = (uEchoNode *)malloc(sizeof(uEchoNode));
 
@@ -28,23 +27,56 @@ uEchoNode *uecho_node_new(void)
         
   uecho_list_node_init((uEchoList *)node);
   
-  node->mutex = uecho_mutex_new();
+  node->mutex = NULL;
+  node->server = NULL;
   node->classes = uecho_classlist_new();
   node->objects = uecho_objectlist_new();
+  node->objIndex = uecho_objectindex_new();
+  node->objListener = NULL;
+  node->objListenerData = NULL;
+  
+  node->address = NULL;
+  uecho_socket_address_clear(&node->sockAddr);
+  node->option = uEchoOptionNone;
+  uecho_node_setmessagelistener(node, NULL);
+  
+  return node;
+}
+
+/****************************************
+* uecho_node_new
+****************************************/
+
+uEchoNode *uecho_node_new(void)
+{
+  uEchoNode *node;
+  uEchoObject *obj;
+
+  node = uecho_node_alloc();
+  if (!node)
+    return NULL;
+  
+  node->mutex = uecho_mutex_new();
 
   node->server = uecho_server_new();
   uecho_server_setuserdata(node->server, node);
   uecho_server_setmessagelistener(node->server, uecho_node_servermessagelistener);
   
-  node->address = NULL;
-  uecho_node_setmessagelistener(node, NULL);
-  
   obj = uecho_nodeprofileclass_new();
   uecho_node_addobject(node, obj);
   
   return node;
 }
 
+/****************************************
+* uecho_node_remote_new
+****************************************/
+
+uEchoNode *uecho_node_remote_new(void)
+{
+  return uecho_node_alloc();
+}
+
 /****************************************
 * uecho_node_delete
 ****************************************/
@@ -59,8 +91,12 @@ bool uecho_node_delete(uEchoNode *node)
   uecho_mutex_delete(node->mutex);
   uecho_classlist_delete(node->classes);
   uecho_objectlist_delete(node->objects);
+  uecho_objectindex_delete(node->objIndex);
   uecho_server_delete(node->server);
 
+  if (node->address)
+    free(node->address);
+  
   free(node);
   
   return true;
@@ -100,7 +136,69 @@ void uecho_node_setoption(uEchoNode *node, uEchoOption value)
     return;
 
   node->option = value;
-  uecho_server_setoption(node->server, value);
+  
+  if (node->server)
+    uecho_server_setoption(node->server, value);
+}
+
+/****************************************
+ * uecho_node_enableeventloop
+ ****************************************/
+
+void uecho_node_enableeventloop(uEchoNode *node)
+{
+  if (!node)
+    return;
+  
+  uecho_node_setoption(node, (node->option | uEchoServerOptionEnableEventLoop));
+}
+
+/****************************************
+ * uecho_node_enableuring
+ ****************************************/
+
+void uecho_node_enableuring(uEchoNode *node)
+{
+  if (!node)
+    return;
+  
+  uecho_node_setoption(node, (node->option | uEchoServerOptionEnableUring));
+}
+
+/****************************************
+ * uecho_node_seteventloopworkercount
+ ****************************************/
+
+bool uecho_node_seteventloopworkercount(uEchoNode *node, size_t workerCnt)
+{
+  if (!node)
+    return false;
+  
+  return uecho_server_seteventloopworkercount(node->server, workerCnt);
+}
+
+/****************************************
+ * uecho_node_setrecvbuffer
+ ****************************************/
+
+bool uecho_node_setrecvbuffer(uEchoNode *node, size_t bufSize, size_t queueSize)
+{
+  if (!node)
+    return false;
+  
+  return uecho_server_setrecvbuffer(node->server, bufSize, queueSize);
+}
+
+/****************************************
+ * uecho_node_gettruncatedcount
+ ****************************************/
+
+size_t uecho_node_gettruncatedcount(uEchoNode *node)
+{
+  if (!node)
+    return 0;
+  
+  return uecho_server_gettruncatedcount(node->server);
 }
 
 /****************************************
@@ -148,6 +246,25 @@ void uecho_node_setaddress(uEchoNode *node, const char *addr)
   if (!node)
     return;
   uecho_strloc(addr, &node->address);
+  uecho_socket_address_setstring(&node->sockAddr, addr);
+}
+
+/****************************************
+ * uecho_node_setsocketaddress
+ ****************************************/
+
+void uecho_node_setsocketaddress(uEchoNode *node, const uEchoSocketAddress *sockAddr)
+{
+  char addr[UECHO_NET_SOCKET_ADDRSTRLEN];
+  
+  if (!node || !sockAddr)
+    return;
+  
+  if (!uecho_socket_address_tostring(sockAddr, addr, sizeof(addr)))
+    return;
+  
+  uecho_strloc(addr, &node->address);
+  uecho_socket_address_copy(&node->sockAddr, sockAddr);
 }
 
 /****************************************
@@ -168,9 +285,14 @@ const char *uecho_node_getaddress(uEchoNode *node)
 
 bool uecho_node_isaddress(uEchoNode *node, const char *addr)
 {
+  uEchoSocketAddress sockAddr;
+  
   if (!node)
     return false;
 
+  if (uecho_socket_address_setstring(&sockAddr, addr))
+    return uecho_node_issocketaddress(node, &sockAddr);
+  
   if (node->address) {
     if (uecho_streq(node->address, addr))
       return true;
@@ -182,6 +304,34 @@ bool uecho_node_isaddress(uEchoNode *node, const char *addr)
   return false;
 }
 
+/****************************************
+ * uecho_node_issocketaddress
+ ****************************************/
+
+bool uecho_node_issocketaddress(uEchoNode *node, const uEchoSocketAddress *sockAddr)
+{
+  char addr[UECHO_NET_SOCKET_ADDRSTRLEN];
+  
+  if (!node || !sockAddr)
+    return false;
+  
+  if (uecho_socket_address_equals(&node->sockAddr, sockAddr))
+    return true;
+  
+  // Only the running local nodes have bound addresses to check
+  
+  if (uecho_node_isremote(node))
+    return false;
+  
+  if ((uecho_udp_serverlist_size(node->server->udpServers) <= 0) && (uecho_mcast_serverlist_size(node->server->mcastServers) <= 0))
+    return false;
+  
+  if (!uecho_socket_address_tostring(sockAddr, addr, sizeof(addr)))
+    return false;
+  
+  return uecho_server_isboundaddress(node->server, addr);
+}
+
 /****************************************
  * uecho_node_setmanufacturercode
  ****************************************/
@@ -266,7 +416,10 @@ uEchoObject *uecho_node_getobjects(uEchoNode *node)
 
 uEchoObject *uecho_node_getobjectbycode(uEchoNode *node, uEchoObjectCode code)
 {
-  return uecho_objectlist_getbycode(node->objects, code);
+  if (!node)
+    return NULL;
+  
+  return uecho_objectindex_getbycode(node->objIndex, code);
 }
 
 /****************************************
@@ -316,11 +469,11 @@ bool uecho_node_setobject(uEchoNode *node, uEchoObjectCode code)
   if (!node)
     return false;
   
-  obj = uecho_objectlist_getbycode(node->objects, code);
+  obj = uecho_node_getobjectbycode(node, code);
   if (obj)
     return true;
   
-  obj = uecho_object_new();
+  obj = uecho_node_isremote(node) ? uecho_object_remote_new() : uecho_object_new();
   if (!obj)
     return false;
   
@@ -348,17 +501,78 @@ bool uecho_node_addobject(uEchoNode *node, uEchoObject *obj)
   if (!uecho_objectlist_add(node->objects, obj))
     return false;
 
+  uecho_objectindex_add(node->objIndex, obj);
   uecho_object_setparentnode(obj, node);
   
+  if (node->objListener)
+    node->objListener(node, obj, objCode, true);
+  
   clsCode = uecho_objectcode2classcode(objCode);
   uecho_classlist_set(node->classes, clsCode);
 
+  // The node profile of remote nodes is cached from their responses
+  
+  if (uecho_node_isremote(node))
+    return true;
+  
   if (!uecho_node_updatenodeprofileclass(node))
     return false;
   
   return true;
 }
 
+/****************************************
+ * uecho_node_updateobjectindex
+ ****************************************/
+
+bool uecho_node_updateobjectindex(uEchoNode *node, uEchoObject *obj, uEchoObjectCode oldCode)
+{
+  if (!node || !obj)
+    return false;
+  
+  uecho_objectindex_remove(node->objIndex, obj, oldCode);
+  if (!uecho_objectindex_add(node->objIndex, obj))
+    return false;
+  
+  if (node->objListener) {
+    node->objListener(node, obj, oldCode, false);
+    node->objListener(node, obj, uecho_object_getcode(obj), true);
+  }
+  
+  return true;
+}
+
+/****************************************
+ * uecho_node_removeobjectindex
+ ****************************************/
+
+bool uecho_node_removeobjectindex(uEchoNode *node, uEchoObject *obj)
+{
+  if (!node || !obj)
+    return false;
+  
+  if (!uecho_objectindex_remove(node->objIndex, obj, uecho_object_getcode(obj)))
+    return false;
+  
+  if (node->objListener)
+    node->objListener(node, obj, uecho_object_getcode(obj), false);
+  
+  return true;
+}
+
+/****************************************
+ * uecho_node_setobjectlistener
+ ****************************************/
+
+void uecho_node_setobjectlistener(uEchoNode *node, uEchoNodeObjectListener listener, void *userData)
+{
+  if (!node)
+    return;
+  
+  node->objListener = listener;
+  node->objListenerData = userData;
+}
+
 /****************************************
  * uecho_node_start
  ****************************************/
@@ -367,6 +581,9 @@ bool uecho_node_start(uEchoNode *node)
 {
   bool allActionsSucceeded = true;
   
+  if (!node || uecho_node_isremote(node))
+    return false;
+  
   allActionsSucceeded &= uecho_server_start(node->server);
 
   // 4.3.1 Basic Sequence for ECHONET Lite Node Startup
@@ -412,7 +629,7 @@ bool uecho_node_isrunning(uEchoNode *node)
 
 bool uecho_node_announcemessagebytes(uEchoNode *node, byte *msgBytes, size_t msgLen)
 {
-  return uecho_server_postannounce(node->server, msgBytes, msgLen);
+  return uecho_server_postannounce(node->server, msgBytes, msgLen, false);
 }
 
 /****************************************
@@ -421,7 +638,25 @@ bool uecho_node_announcemessagebytes(uEchoNode *node, byte *msgBytes, size_t msg
 
 bool uecho_node_sendmessagebytes(uEchoNode *node, const char *addr, byte *msg, size_t msgLen)
 {
-  return uecho_server_postresponse(node->server, addr, msg, msgLen);
+  return uecho_server_postresponse(node->server, addr, msg, msgLen, false);
+}
+
+/****************************************
+ * uecho_node_deferannouncemessagebytes
+ ****************************************/
+
+bool uecho_node_deferannouncemessagebytes(uEchoNode *node, byte *msgBytes, size_t msgLen)
+{
+  return uecho_server_postannounce(node->server, msgBytes, msgLen, true);
+}
+
+/****************************************
+ * uecho_node_defersendmessagebytes
+ ****************************************/
+
+bool uecho_node_defersendmessagebytes(uEchoNode *node, const char *addr, byte *msg, size_t msgLen)
+{
+  return uecho_server_postresponse(node->server, addr, msg, msgLen, true);
 }
 
 /****************************************
@@ -0,0 +1,256 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/node_internal.h>
+
+/****************************************
+* uecho_nodeindex_hash
+****************************************/
+
+static size_t uecho_nodeindex_hash(const uEchoSocketAddress *sockAddr)
+{
+  size_t hash, n;
+  
+  // FNV-1a
+  
+  hash = 2166136261U;
+  hash = (hash ^ (size_t)sockAddr->family) * 16777619U;
+  for (n=0; n<UECHO_NET_SOCKET_ADDRBYTESIZE; n++)
+    hash = (hash ^ sockAddr->addr[n]) * 16777619U;
+  
+  return hash;
+}
+
+/****************************************
+* uecho_nodeindex_getslot
+****************************************/
+
+static size_t uecho_nodeindex_getslot(uEchoNodeIndex *index, const uEchoSocketAddress *sockAddr)
+{
+  size_t mask, slot;
+  
+  // Returns the slot of the node with the address, or the empty slot where it should be stored
+  
+  mask = index->capacity - 1;
+  slot = uecho_nodeindex_hash(sockAddr) & mask;
+  while (index->nodes[slot]) {
+    if (uecho_socket_address_equals(uecho_node_getsocketaddress(index->nodes[slot]), sockAddr))
+      break;
+    slot = (slot + 1) & mask;
+  }
+  
+  return slot;
+}
+
+/****************************************
+* uecho_nodeindex_reserve
+****************************************/
+
+static bool uecho_nodeindex_reserve(uEchoNodeIndex *index, size_t nodeCnt)
+{
+  uEchoNode **oldNodes;
+  size_t oldCapacity, newCapacity, n;
+  
+  // Keep the load factor under 1/2 to keep the probe sequences short
+  
+  if ((nodeCnt * 2) < index->capacity)
+    return true;
+  
+  newCapacity = index->capacity;
+  while (newCapacity <= (nodeCnt * 2))
+    newCapacity *= 2;
+  
+  oldNodes = index->nodes;
+  oldCapacity = index->capacity;
+  
+  index->nodes = (uEchoNode **)calloc(newCapacity, sizeof(uEchoNode *));
+  if (!index->nodes) {
+    index->nodes = oldNodes;
+    return false;
+  }
+  index->capacity = newCapacity;
+  
+  for (n=0; n<oldCapacity; n++) {
+    if (!oldNodes[n])
+      continue;
+    index->nodes[uecho_nodeindex_getslot(index, uecho_node_getsocketaddress(oldNodes[n]))] = oldNodes[n];
+  }
+  
+  free(oldNodes);
+  
+  return true;
+}
+
+/****************************************
+* uecho_nodeindex_new
+****************************************/
+
+uEchoNodeIndex *uecho_nodeindex_new(void)
+{
+  uEchoNodeIndex *index;
+  
+  index = (uEchoNodeIndex *)malloc(sizeof(uEchoNodeIndex));
+  if (!index)
+    return NULL;
+  
+  index->mutex = uecho_mutex_new();
+  index->capacity = uEchoNodeIndexInitialCapacity;
+  index->size = 0;
+  index->nodes = (uEchoNode **)calloc(index->capacity, sizeof(uEchoNode *));
+  
+  if (!index->mutex || !index->nodes) {
+    uecho_nodeindex_delete(index);
+    return NULL;
+  }
+  
+  return index;
+}
+
+/****************************************
+* uecho_nodeindex_delete
+****************************************/
+
+void uecho_nodeindex_delete(uEchoNodeIndex *index)
+{
+  if (!index)
+    return;
+  
+  if (index->mutex)
+    uecho_mutex_delete(index->mutex);
+  if (index->nodes)
+    free(index->nodes);
+  
+  free(index);
+}
+
+/****************************************
+* uecho_nodeindex_clear
+****************************************/
+
+void uecho_nodeindex_clear(uEchoNodeIndex *index)
+{
+  if (!index)
+    return;
+  
+  uecho_mutex_lock(index->mutex);
+  memset(index->nodes, 0, sizeof(uEchoNode *) * index->capacity);
+  index->size = 0;
+  uecho_mutex_unlock(index->mutex);
+}
+
+/****************************************
+* uecho_nodeindex_add
+****************************************/
+
+bool uecho_nodeindex_add(uEchoNodeIndex *index, uEchoNode *node)
+{
+  size_t slot;
+  
+  if (!index || !node)
+    return false;
+  
+  if (!uecho_socket_address_isvalid(uecho_node_getsocketaddress(node)))
+    return false;
+  
+  uecho_mutex_lock(index->mutex);
+  
+  if (!uecho_nodeindex_reserve(index, (index->size + 1))) {
+    uecho_mutex_unlock(index->mutex);
+    return false;
+  }
+  
+  slot = uecho_nodeindex_getslot(index, uecho_node_getsocketaddress(node));
+  if (!index->nodes[slot])
+    index->size++;
+  index->nodes[slot] = node;
+  
+  uecho_mutex_unlock(index->mutex);
+  
+  return true;
+}
+
+/****************************************
+* uecho_nodeindex_remove
+****************************************/
+
+bool uecho_nodeindex_remove(uEchoNodeIndex *index, uEchoNode *node)
+{
+  size_t mask, slot, nextSlot, homeSlot;
+  
+  if (!index || !node)
+    return false;
+  
+  uecho_mutex_lock(index->mutex);
+  
+  slot = uecho_nodeindex_getslot(index, uecho_node_getsocketaddress(node));
+  if (index->nodes[slot] != node) {
+    uecho_mutex_unlock(index->mutex);
+    return false;
+  }
+  
+  // Shift the following entries back so that no probe sequence is broken by the removed slot
+  
+  mask = index->capacity - 1;
+  index->nodes[slot] = NULL;
+  nextSlot = (slot + 1) & mask;
+  while (index->nodes[nextSlot]) {
+    homeSlot = uecho_nodeindex_hash(uecho_node_getsocketaddress(index->nodes[nextSlot])) & mask;
+    if (((nextSlot - homeSlot) & mask) >= ((nextSlot - slot) & mask)) {
+      index->nodes[slot] = index->nodes[nextSlot];
+      index->nodes[nextSlot] = NULL;
+      slot = nextSlot;
+    }
+    nextSlot = (nextSlot + 1) & mask;
+  }
+  index->size--;
+  
+  uecho_mutex_unlock(index->mutex);
+  
+  return true;
+}
+
+/****************************************
+* uecho_nodeindex_getbysocketaddress
+****************************************/
+
+uEchoNode *uecho_nodeindex_getbysocketaddress(uEchoNodeIndex *index, const uEchoSocketAddress *sockAddr)
+{
+  uEchoNode *node;
+  
+  if (!index || !sockAddr)
+    return NULL;
+  
+  if (!uecho_socket_address_isvalid(sockAddr))
+    return NULL;
+  
+  uecho_mutex_lock(index->mutex);
+  node = index->nodes[uecho_nodeindex_getslot(index, sockAddr)];
+  uecho_mutex_unlock(index->mutex);
+  
+  return node;
+}
+
+/****************************************
+* uecho_nodeindex_size
+****************************************/
+
+size_t uecho_nodeindex_size(uEchoNodeIndex *index)
+{
+  size_t size;
+  
+  if (!index)
+    return 0;
+  
+  uecho_mutex_lock(index->mutex);
+  size = index->size;
+  uecho_mutex_unlock(index->mutex);
+  
+  return size;
+}
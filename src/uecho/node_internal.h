@@ -22,6 +22,14 @@
 extern "C" {
 #endif
 
+/****************************************
+ * Constant
+ ****************************************/
+
+enum {
+  uEchoNodeIndexInitialCapacity = 64,
+};
+
 /****************************************
  * Data Type
  ****************************************/
@@ -34,12 +42,25 @@ typedef struct _uEchoNode {
 
   uEchoClassList *classes;
   uEchoObjectList *objects;
+  uEchoObjectIndex *objIndex;
+  void (*objListener)(struct _uEchoNode *, uEchoObject *, uEchoObjectCode, bool); /* uEchoNodeObjectListener */
+  void *objListenerData;
   
   void (*msgListener)(struct _uEchoNode *, uEchoMessage *); /* uEchoNodeMessageListener */
   char *address;
+  uEchoSocketAddress sockAddr;
   uEchoOption option;
 } uEchoNode, uEchoNodeList;
 
+typedef void (*uEchoNodeObjectListener)(uEchoNode *, uEchoObject *, uEchoObjectCode, bool);
+
+typedef struct _uEchoNodeIndex {
+  uEchoMutex *mutex;
+  uEchoNode **nodes;
+  size_t size;
+  size_t capacity;
+} uEchoNodeIndex;
+
 /****************************************
  * Header
  ****************************************/
@@ -51,15 +72,30 @@ typedef struct _uEchoNode {
  ****************************************/
 
 #define uecho_node_remove(node) uecho_list_remove((uEchoList *)node)
+
+uEchoNode *uecho_node_remote_new(void);
+#define uecho_node_isremote(node) ((node->server) ? false : true)
     
 uEchoServer *uecho_node_getserver(uEchoNode *node);
 
+bool uecho_node_updateobjectindex(uEchoNode *node, uEchoObject *obj, uEchoObjectCode oldCode);
+bool uecho_node_removeobjectindex(uEchoNode *node, uEchoObject *obj);
+
+void uecho_node_setobjectlistener(uEchoNode *node, uEchoNodeObjectListener listener, void *userData);
+#define uecho_node_getobjectlistenerdata(node) (node->objListenerData)
+
 void uecho_node_setoption(uEchoNode *node, uEchoOption value);
+
+void uecho_node_setsocketaddress(uEchoNode *node, const uEchoSocketAddress *sockAddr);
+#define uecho_node_getsocketaddress(node) (&node->sockAddr)
+bool uecho_node_issocketaddress(uEchoNode *node, const uEchoSocketAddress *sockAddr);
 #define uecho_node_isoptionenabled(node, value) (node->option & value)
   
 void uecho_node_servermessagelistener(uEchoServer *server, uEchoMessage *msg);
 
 bool uecho_node_announceproperty(uEchoNode *node, uEchoProperty *prop);
+bool uecho_node_deferannouncemessagebytes(uEchoNode *node, byte *msgBytes, size_t msgLen);
+bool uecho_node_defersendmessagebytes(uEchoNode *node, const char *addr, byte *msg, size_t msgLen);
 bool uecho_node_announce(uEchoNode *node);
   
 /****************************************
@@ -76,11 +112,24 @@ uEchoNodeList *uecho_nodelist_new(void);
 void uecho_nodelist_delete(uEchoNodeList *nodes);
   
 uEchoNode *uecho_nodelist_getbyaddress(uEchoNodeList *nodes, const char *addr);
+uEchoNode *uecho_nodelist_getbysocketaddress(uEchoNodeList *nodes, const uEchoSocketAddress *sockAddr);
   
 #define uecho_nodelist_clear(nodes) uecho_list_clear((uEchoList *)nodes, (UECHO_LIST_DESTRUCTORFUNC)uecho_node_delete)
 #define uecho_nodelist_size(nodes) uecho_list_size((uEchoList *)nodes)
 #define uecho_nodelist_gets(nodes) (uEchoNode *)uecho_list_next((uEchoList *)nodes)
 #define uecho_nodelist_add(nodes,node) uecho_list_add((uEchoList *)nodes, (uEchoList *)node)
+
+/****************************************
+ * Function (Node Index)
+ ****************************************/
+
+uEchoNodeIndex *uecho_nodeindex_new(void);
+void uecho_nodeindex_delete(uEchoNodeIndex *index);
+void uecho_nodeindex_clear(uEchoNodeIndex *index);
+bool uecho_nodeindex_add(uEchoNodeIndex *index, uEchoNode *node);
+bool uecho_nodeindex_remove(uEchoNodeIndex *index, uEchoNode *node);
+uEchoNode *uecho_nodeindex_getbysocketaddress(uEchoNodeIndex *index, const uEchoSocketAddress *sockAddr);
+size_t uecho_nodeindex_size(uEchoNodeIndex *index);
   
 #ifdef  __cplusplus
 } /* extern C */
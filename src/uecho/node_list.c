@@ -60,3 +60,22 @@ uEchoNode *uecho_nodelist_getbyaddress(uEchoNodeList *nodes, const char *addr)
   
   return NULL;
 }
+
+/****************************************
+ * uecho_nodelist_getbysocketaddress
+ ****************************************/
+
+uEchoNode *uecho_nodelist_getbysocketaddress(uEchoNodeList *nodes, const uEchoSocketAddress *sockAddr)
+{
+  uEchoNode *node;
+  
+  if (!nodes || !sockAddr)
+    return NULL;
+  
+  for (node = uecho_nodelist_gets(nodes); node; node = uecho_node_next(node)) {
+    if (uecho_socket_address_equals(uecho_node_getsocketaddress(node), sockAddr))
+      return node;
+  }
+  
+  return NULL;
+}
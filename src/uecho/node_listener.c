@@ -8,10 +8,21 @@
  *
  ******************************************************************/
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include <uecho/node_internal.h>
+#include <uecho/misc.h>
 #include <uecho/core/server.h>
 #include <uecho/core/observer.h>
 
+/****************************************
+ * prototype
+ ****************************************/
+
+bool uecho_object_responseerrormessage(uEchoObject *obj, uEchoMessage *msg);
+
 /****************************************
  * uecho_object_notifyrequestproperty
  ****************************************/
@@ -51,43 +62,31 @@ bool uecho_message_isrequestesv(uEchoEsv esv)
 }
 
 /****************************************
- * uecho_object_responsemessage
+ * uecho_object_writeresponsemessage
  ****************************************/
 
-bool uecho_object_responsemessage(uEchoObject *obj, uEchoMessage *msg)
+size_t uecho_object_writeresponsemessage(uEchoObject *obj, uEchoMessage *msg, uEchoEsv resEsv, byte *buf, size_t bufLen)
 {
-  uEchoNode *parentNode;
-  uEchoProperty *msgProp, *nodeProp, *resProp;
+  uEchoProperty *msgProp, *nodeProp;
   uEchoPropertyCode msgPropCode;
-  int nodePropSize;
-  byte *nodePropData;
-  uEchoEsv msgEsv, resEsv;
+  size_t nodePropSize;
   int msgOpc, n;
-  uEchoMessage *resMsg;
-  byte *resMsgBytes;
-  size_t resMsgLen;
+  size_t offset, resOpc;
   
-  if (!obj || !msg)
-    return false;
+  if (bufLen < uEchoMessageMinLen)
+    return 0;
   
-  msgEsv = uecho_message_getesv(msg);
-  if (!uecho_message_requestesv2responseesv(msgEsv, &resEsv))
-    return false;
-
-  parentNode = uecho_object_getparentnode(obj);
-  if (!parentNode)
-    return false;
-  
-  // Create response message
+  buf[0] = uEchoEhd1;
+  buf[1] = uEchoEhd2;
+  memcpy((buf + 2), msg->TID, uEchoTIDSize);
+  uecho_integer2byte(uecho_message_getdestinationobjectcode(msg), (buf + 4), uEchoEOJSize);
+  uecho_integer2byte(uecho_message_getsourceobjectcode(msg), (buf + 7), uEchoEOJSize);
+  buf[10] = resEsv;
   
-  resMsg = uecho_message_new();
-  if (!resMsg)
-    return false;
+  // Copy the readable properties straight from the object
   
-  uecho_message_setesv(resMsg, resEsv);
-  uecho_message_settid(resMsg, uecho_message_gettid(msg));
-  uecho_message_setsourceobjectcode(resMsg, uecho_message_getdestinationobjectcode(msg));
-  uecho_message_setdestinationobjectcode(resMsg, uecho_message_getsourceobjectcode(msg));
+  offset = uEchoMessageMinLen;
+  resOpc = 0;
   
   msgOpc = uecho_message_getopc(msg);
   for (n=0; n<msgOpc; n++) {
@@ -103,30 +102,108 @@ bool uecho_object_responsemessage(uEchoObject *obj, uEchoMessage *msg)
     if (!uecho_property_isreadable(nodeProp))
       continue;
     
-    resProp = uecho_property_new();
-    if (!resProp)
-      continue;
+    // A response without some of the readable properties is not a valid response
     
     nodePropSize = uecho_property_getdatasize(nodeProp);
-    nodePropData = uecho_property_getdata(nodeProp);
-    uecho_property_setcode(resProp, msgPropCode);
-    uecho_property_setdata(resProp, nodePropData, nodePropSize);
+    if (bufLen < (offset + 2 + nodePropSize))
+      return 0;
     
-    uecho_message_addproperty(resMsg, resProp);
+    buf[offset++] = msgPropCode;
+    buf[offset++] = (byte)nodePropSize;
+    if (0 < nodePropSize) {
+      memcpy((buf + offset), uecho_property_getdata(nodeProp), nodePropSize);
+      offset += nodePropSize;
+    }
+    resOpc++;
+  }
+  
+  buf[11] = (byte)resOpc;
+  
+  return offset;
+}
+
+/****************************************
+ * uecho_object_getresponsemessagesize
+ ****************************************/
+
+static size_t uecho_object_getresponsemessagesize(uEchoObject *obj, uEchoMessage *msg)
+{
+  uEchoProperty *msgProp, *nodeProp;
+  int msgOpc, n;
+  size_t resMsgLen;
+  
+  resMsgLen = uEchoMessageMinLen;
+  
+  msgOpc = uecho_message_getopc(msg);
+  for (n=0; n<msgOpc; n++) {
+    msgProp = uecho_message_getproperty(msg, n);
+    if (!msgProp)
+      continue;
+    nodeProp = uecho_object_getproperty(obj, uecho_property_getcode(msgProp));
+    if (!nodeProp || !uecho_property_isreadable(nodeProp))
+      continue;
+    resMsgLen += 2 + uecho_property_getdatasize(nodeProp);
+  }
+  
+  return (resMsgLen < uEchoMessageFrameMaxLen) ? resMsgLen : uEchoMessageFrameMaxLen;
+}
+
+/****************************************
+ * uecho_object_responsemessage
+ ****************************************/
+
+bool uecho_object_responsemessage(uEchoObject *obj, uEchoMessage *msg)
+{
+  uEchoNode *parentNode;
+  uEchoEsv msgEsv, resEsv;
+  uEchoArena *arena;
+  byte *resMsgBytes;
+  size_t resMsgBufLen, resMsgLen;
+  
+  if (!obj || !msg)
+    return false;
+  
+  msgEsv = uecho_message_getesv(msg);
+  if (!uecho_message_requestesv2responseesv(msgEsv, &resEsv))
+    return false;
+
+  parentNode = uecho_object_getparentnode(obj);
+  if (!parentNode)
+    return false;
+  
+  // Serialize response message into the arena of the received datagram if any,
+  // otherwise into a buffer only for this response
+  
+  resMsgBufLen = uecho_object_getresponsemessagesize(obj, msg);
+  
+  arena = uecho_message_getarena(msg);
+  if (arena)
+    resMsgBytes = (byte *)uecho_arena_alloc(arena, resMsgBufLen);
+  else
+    resMsgBytes = (byte *)malloc(resMsgBufLen);
+  if (!resMsgBytes)
+    return false;
+  
+  // The requested properties don't fit in a frame, so answer with the error response
+  
+  resMsgLen = uecho_object_writeresponsemessage(obj, msg, resEsv, resMsgBytes, resMsgBufLen);
+  if (resMsgLen <= 0) {
+    if (!arena)
+      free(resMsgBytes);
+    return uecho_object_responseerrormessage(obj, msg);
   }
   
   // Send response message
   
-  resMsgBytes = uecho_message_getbytes(resMsg);
-  resMsgLen = uecho_message_size(resMsg);
   if (resEsv == uEchoEsvNotification) {
-    uecho_node_announcemessagebytes(parentNode, resMsgBytes, resMsgLen);
+    uecho_node_deferannouncemessagebytes(parentNode, resMsgBytes, resMsgLen);
   }
   else {
-    uecho_node_sendmessagebytes(parentNode, uecho_message_getsourceaddress(msg), resMsgBytes, resMsgLen);
+    uecho_node_defersendmessagebytes(parentNode, uecho_message_getsourceaddress(msg), resMsgBytes, resMsgLen);
   }
   
-  uecho_message_delete(resMsg);
+  if (!arena)
+    free(resMsgBytes);
 
   return true;
 }
@@ -139,7 +216,7 @@ bool uecho_object_responseerrormessage(uEchoObject *obj, uEchoMessage *msg)
 {
   uEchoNode *parentNode;
   uEchoEsv msgEsv, errEsv;
-  uEchoMessage *errMsg;
+  uEchoArena *arena;
   byte *errMsgBytes;
   size_t errMsgLen;
   
@@ -154,24 +231,29 @@ bool uecho_object_responseerrormessage(uEchoObject *obj, uEchoMessage *msg)
   if (!parentNode)
     return false;
   
-  // Create response error message
+  // Serialize the request as is, and swap the object codes and ESV of the frame
   
-  errMsg = uecho_message_copy(msg);
-  if (!errMsg)
+  errMsgLen = uecho_message_size(msg);
+  
+  arena = uecho_message_getarena(msg);
+  if (arena)
+    errMsgBytes = (byte *)uecho_arena_alloc(arena, errMsgLen);
+  else
+    errMsgBytes = (byte *)malloc(errMsgLen);
+  if (!errMsgBytes)
     return false;
   
-  uecho_message_setesv(errMsg, errEsv);
-  uecho_message_setsourceobjectcode(errMsg, uecho_message_getdestinationobjectcode(msg));
-  uecho_message_setdestinationobjectcode(errMsg, uecho_message_getsourceobjectcode(msg));
+  uecho_message_writebytes(msg, errMsgBytes, errMsgLen);
+  uecho_integer2byte(uecho_message_getdestinationobjectcode(msg), (errMsgBytes + 4), uEchoEOJSize);
+  uecho_integer2byte(uecho_message_getsourceobjectcode(msg), (errMsgBytes + 7), uEchoEOJSize);
+  errMsgBytes[10] = errEsv;
 
   // Send response message
   
-  errMsgBytes = uecho_message_getbytes(errMsg);
-  errMsgLen = uecho_message_size(errMsg);
-  
-  uecho_node_sendmessagebytes(parentNode, uecho_message_getsourceaddress(msg), errMsgBytes, errMsgLen);
+  uecho_node_defersendmessagebytes(parentNode, uecho_message_getsourceaddress(msg), errMsgBytes, errMsgLen);
   
-  uecho_message_delete(errMsg);
+  if (!arena)
+    free(errMsgBytes);
   
   return true;
 }
@@ -261,7 +343,7 @@ void uecho_object_handlemessage(uEchoObject *obj, uEchoMessage *msg)
 
 bool uecho_node_isselfobjectmessage(uEchoNode *node, uEchoMessage *msg)
 {
-  if (!uecho_node_isaddress(node, uecho_message_getsourceaddress(msg)))
+  if (!uecho_node_issocketaddress(node, uecho_message_getsourcesocketaddress(msg)))
     return false;
       
   if (uecho_message_getsourceobjectcode(msg) != uecho_message_getdestinationobjectcode(msg))
@@ -9,17 +9,17 @@
  ******************************************************************/
 
 #include <uecho/object_internal.h>
-#include <uecho/node.h>
+#include <uecho/node_internal.h>
 #include <uecho/profile.h>
 #include <uecho/misc.h>
 #include <uecho/core/observer.h>
 #include <uecho/util/timer.h>
 
 /****************************************
-* uecho_object_new
+* uecho_object_remote_new
 ****************************************/
 
-uEchoObject *uecho_object_new(void)
+uEchoObject *uecho_object_remote_new(void)
 {
   uEchoObject *obj;
 
@@ -37,21 +37,30 @@ uEchoObject *uecho_object_new(void)
   uecho_object_setinstancecode(obj, 0);
 
   obj->properties = uecho_propertylist_new();
+  memset(obj->propIndex, 0, sizeof(obj->propIndex));
 
   uecho_object_setmessagelistener(obj, NULL);
   obj->propListenerMgr = uecho_object_property_observer_manager_new();
   
-  // Property map caches
+  // Property maps
   
-  obj->annoPropMapSize = 0;
-  obj->annoPropMapBytes = NULL;
+  uecho_object_clearpropertymapcaches(obj);
+
+  return obj;
+}
+
+/****************************************
+* uecho_object_new
+****************************************/
+
+uEchoObject *uecho_object_new(void)
+{
+  uEchoObject *obj;
   
-  obj->setPropMapSize = 0;
-  obj->setPropMapBytes = NULL;
+  obj = uecho_object_remote_new();
+  if (!obj)
+    return NULL;
   
-  obj->getPropMapSize = 0;
-  obj->getPropMapBytes = NULL;
-
   // Mandatory Properties
   
   uecho_object_addmandatoryproperties(obj);
@@ -70,7 +79,8 @@ bool uecho_object_delete(uEchoObject *obj)
 
   uecho_list_remove((uEchoList *)obj);
   
-  uecho_object_clearpropertymapcaches(obj);
+  if (obj->parentNode)
+    uecho_node_removeobjectindex((uEchoNode *)obj->parentNode, obj);
   
   uecho_propertylist_delete(obj->properties);
   uecho_object_property_observer_manager_delete(obj->propListenerMgr);
@@ -115,18 +125,39 @@ uEchoNode *uecho_object_getparentnode(uEchoObject *obj)
   return (uEchoNode *)obj->parentNode;
 }
 
+/****************************************
+ * uecho_object_updateparentnodeindex
+ ****************************************/
+
+static void uecho_object_updateparentnodeindex(uEchoObject *obj, uEchoObjectCode oldCode)
+{
+  if (!obj->parentNode)
+    return;
+  
+  if (uecho_object_getcode(obj) == oldCode)
+    return;
+  
+  uecho_node_updateobjectindex((uEchoNode *)obj->parentNode, obj, oldCode);
+}
+
 /****************************************
  * uecho_object_setcode
  ****************************************/
 
 void uecho_object_setcode(uEchoObject *obj, uEchoObjectCode val)
 {
+  uEchoObjectCode oldCode;
+  
   if (!obj)
     return;
   
+  oldCode = uecho_object_getcode(obj);
+  
   obj->code[0] = (val & 0xFF0000) >> 16;
   obj->code[1] = (val & 0x00FF00) >>  8;
   obj->code[2] = (val & 0x0000FF);
+  
+  uecho_object_updateparentnodeindex(obj, oldCode);
 }
 
 /****************************************
@@ -163,10 +194,14 @@ bool uecho_object_iscode(uEchoObject *obj, uEchoObjectCode code)
 
 void uecho_object_setclassgroupcode(uEchoObject *obj, byte val)
 {
+  uEchoObjectCode oldCode;
+  
   if (!obj)
     return;
   
+  oldCode = uecho_object_getcode(obj);
   obj->code[0] = val;
+  uecho_object_updateparentnodeindex(obj, oldCode);
 }
   
 /****************************************
@@ -187,10 +222,14 @@ byte uecho_object_getclassgroupcode(uEchoObject *obj)
 
 void uecho_object_setclasscode(uEchoObject *obj, byte val)
 {
+  uEchoObjectCode oldCode;
+  
   if (!obj)
     return;
   
+  oldCode = uecho_object_getcode(obj);
   obj->code[1] = val;
+  uecho_object_updateparentnodeindex(obj, oldCode);
 }
       
 /****************************************
@@ -211,10 +250,14 @@ byte uecho_object_getclasscode(uEchoObject *obj)
 
 void uecho_object_setinstancecode(uEchoObject *obj, byte val)
 {
+  uEchoObjectCode oldCode;
+  
   if (!obj)
     return;
   
+  oldCode = uecho_object_getcode(obj);
   obj->code[2] = val;
+  uecho_object_updateparentnodeindex(obj, oldCode);
 }
           
 /****************************************
@@ -259,40 +302,47 @@ bool uecho_object_isprofile(uEchoObject *obj)
 
 bool uecho_object_setpropertymap(uEchoObject *obj, uEchoPropertyCode mapCode, uEchoPropertyCode *propCodes, size_t propsCodeSize)
 {
+  uEchoProperty *prop;
   byte propMapData[uEchoPropertyMapMaxLen + 1];
-  uEchoPropertyCode *propMap;
-  size_t n, propByteIdx;
+  byte *propMap;
+  size_t n, propCnt;
   
   if (!obj)
     return false;
   
-  propMapData[0] = (byte)propsCodeSize;
+  prop = uecho_object_addproperty(obj, mapCode);
+  if (!prop)
+    return false;
+  
+  uecho_property_setattribute(prop, uEchoPropertyAttrRead);
+  
   propMap = propMapData + 1;
   
-  // propsCodeSize <= uEchoPropertyMapMaxLen
+  // propsCodeSize < uEchoPropertyMapMaxLen : Property code list
   
-  if (propsCodeSize <= uEchoPropertyMapMaxLen) {
+  if (propsCodeSize <= uEchoObjectPropertyMapListMaxSize) {
+    propMapData[0] = (byte)propsCodeSize;
     memcpy(propMap, propCodes, propsCodeSize);
-    uecho_object_setproperty(obj, mapCode, uEchoPropertyAttrRead);
-    uecho_object_setpropertydata(obj, mapCode, propMapData, (propsCodeSize + 1));
-    return true;
+    return uecho_property_setdata(prop, propMapData, (propsCodeSize + 1));
   }
   
-  // uEchoPropertyMapMaxLen < propsCodeSize
+  // uEchoPropertyMapMaxLen <= propsCodeSize : Bitmap of the property codes
+  //   The low nibble of a code is the byte index and the high nibble is the bit index
   
+  memset(propMap, 0, uEchoPropertyMapMaxLen);
+  
+  propCnt = 0;
   for (n=0; n<propsCodeSize; n++) {
-    byte propCode;
+    uEchoPropertyCode propCode;
     propCode = propCodes[n];
     if ((propCode < uEchoPropertyCodeMin) || (uEchoPropertyCodeMax < propCode))
       continue;
-    propByteIdx = (propCode - uEchoPropertyCodeMin) & 0x0F;
-    propMap[propByteIdx] |= (((propCode - uEchoPropertyCodeMin) & 0xF0) >> 8) & 0x0F;
+    propMap[(propCode - uEchoPropertyCodeMin) & 0x0F] |= (byte)(1 << (((propCode - uEchoPropertyCodeMin) & 0xF0) >> 4));
+    propCnt++;
   }
+  propMapData[0] = (byte)propCnt;
   
-  uecho_object_setproperty(obj, mapCode, uEchoPropertyAttrRead);
-  uecho_object_setpropertydata(obj, mapCode, propMapData, (uEchoPropertyMapMaxLen + 1));
-  
-  return true;
+  return uecho_property_setdata(prop, propMapData, (uEchoPropertyMapMaxLen + 1));
 }
 
 /****************************************
@@ -306,17 +356,17 @@ bool uecho_object_setproperty(uEchoObject *obj, uEchoPropertyCode code, uEchoPro
   if (!obj)
     return false;
 
-  if (!uecho_propertylist_set(obj->properties, code, attr, NULL, 0))
-    return false;
-  
-  prop = uecho_object_getproperty(obj, code);
+  prop = uecho_object_addproperty(obj, code);
   if (!prop)
     return false;
   
+  uecho_property_setdata(prop, NULL, 0);
+  uecho_property_setattribute(prop, attr);
+  
   if (!uecho_property_setparentobject(prop, obj))
     return false;
   
-  return uecho_object_updatepropertymaps(obj);
+  return uecho_object_setpropertymapcode(obj, code, attr);
 }
 
 /****************************************
@@ -325,10 +375,43 @@ bool uecho_object_setproperty(uEchoObject *obj, uEchoPropertyCode code, uEchoPro
 
 bool uecho_object_setpropertydata(uEchoObject *obj, uEchoPropertyCode code, byte *data, size_t dataLen)
 {
+  uEchoProperty *prop;
+  
   if (!obj)
     return false;
 
-  return uecho_propertylist_setdata(obj->properties, code, data, dataLen);
+  prop = uecho_object_addproperty(obj, code);
+  if (!prop)
+    return false;
+  
+  uecho_property_setdata(prop, data, dataLen);
+  
+  return true;
+}
+
+/****************************************
+ * uecho_object_cachepropertydata
+ ****************************************/
+
+bool uecho_object_cachepropertydata(uEchoObject *obj, uEchoPropertyCode code, byte *data, size_t dataLen)
+{
+  uEchoProperty *prop;
+  
+  if (!obj)
+    return false;
+  
+  // The property maps of remote objects are learned from the devices, so they are not maintained here
+  
+  prop = obj->propIndex[code & 0xFF];
+  if (!prop) {
+    prop = uecho_object_addproperty(obj, code);
+    if (!prop)
+      return false;
+    uecho_property_setattribute(prop, uEchoPropertyAttrNone);
+    uecho_property_setparentobject(prop, obj);
+  }
+  
+  return uecho_property_setdata(prop, data, dataLen);
 }
 
 /****************************************
@@ -337,10 +420,16 @@ bool uecho_object_setpropertydata(uEchoObject *obj, uEchoPropertyCode code, byte
 
 bool uecho_object_setpropertyintegerdata(uEchoObject *obj, uEchoPropertyCode code, int data, size_t dataLen)
 {
+  uEchoProperty *prop;
+  
   if (!obj)
     return false;
 
-  return uecho_propertylist_setintegerdata(obj->properties, code, data, dataLen);
+  prop = uecho_object_addproperty(obj, code);
+  if (!prop)
+    return false;
+  
+  return uecho_property_setintegerdata(prop, data, dataLen);
 }
 
 /****************************************
@@ -349,10 +438,16 @@ bool uecho_object_setpropertyintegerdata(uEchoObject *obj, uEchoPropertyCode cod
 
 bool uecho_object_setpropertybytedata(uEchoObject *obj, uEchoPropertyCode code, byte data)
 {
+  uEchoProperty *prop;
+  
   if (!obj)
     return false;
   
-  return uecho_propertylist_setbytedata(obj->properties, code, data);
+  prop = uecho_object_addproperty(obj, code);
+  if (!prop)
+    return false;
+  
+  return uecho_property_setbytedata(prop, data);
 }
 
 /****************************************
@@ -361,10 +456,18 @@ bool uecho_object_setpropertybytedata(uEchoObject *obj, uEchoPropertyCode code,
 
 bool uecho_object_setpropertyattribute(uEchoObject *obj, uEchoPropertyCode code, uEchoPropertyAttr attr)
 {
+  uEchoProperty *prop;
+  
   if (!obj)
     return false;
 
-  return uecho_propertylist_setattribute(obj->properties, code, attr);
+  prop = uecho_object_addproperty(obj, code);
+  if (!prop)
+    return false;
+  
+  uecho_property_setattribute(prop, attr);
+  
+  return uecho_object_setpropertymapcode(obj, code, attr);
 }
 
 /****************************************
@@ -400,7 +503,36 @@ uEchoProperty *uecho_object_getproperty(uEchoObject *obj, uEchoPropertyCode code
   if (!obj)
     return NULL;
 
-  return uecho_propertylist_findbycode(obj->properties, code);
+  return obj->propIndex[code & 0xFF];
+}
+
+/****************************************
+ * uecho_object_addproperty
+ ****************************************/
+
+uEchoProperty *uecho_object_addproperty(uEchoObject *obj, uEchoPropertyCode code)
+{
+  uEchoProperty *prop;
+  
+  if (!obj)
+    return NULL;
+  
+  // The EPC is a single byte, so the index has a slot for every property code
+  
+  prop = obj->propIndex[code & 0xFF];
+  if (prop)
+    return prop;
+  
+  prop = uecho_property_new();
+  if (!prop)
+    return NULL;
+  
+  uecho_property_setcode(prop, code);
+  uecho_property_setparentobject(prop, obj);
+  uecho_propertylist_add(obj->properties, prop);
+  obj->propIndex[code & 0xFF] = prop;
+  
+  return prop;
 }
 
 /****************************************
@@ -444,6 +576,7 @@ void uecho_object_clearproperties(uEchoObject *obj)
     return;
   
   uecho_propertylist_clear(obj->properties);
+  memset(obj->propIndex, 0, sizeof(obj->propIndex));
   uecho_object_clearpropertymapcaches(obj);
 }
 
@@ -453,10 +586,16 @@ void uecho_object_clearproperties(uEchoObject *obj)
 
 int uecho_object_getpropertydatasize(uEchoObject *obj, uEchoPropertyCode code)
 {
+  uEchoProperty *prop;
+  
   if (!obj)
     return 0;
   
-  return uecho_propertylist_getdatasize(obj->properties, code);
+  prop = uecho_object_getproperty(obj, code);
+  if (!prop)
+    return 0;
+  
+  return uecho_property_getdatasize(prop);
 }
 
 /****************************************
@@ -465,10 +604,16 @@ int uecho_object_getpropertydatasize(uEchoObject *obj, uEchoPropertyCode code)
 
 byte *uecho_object_getpropertydata(uEchoObject *obj, uEchoPropertyCode code)
 {
+  uEchoProperty *prop;
+  
   if (!obj)
     return NULL;
   
-  return uecho_propertylist_getdata(obj->properties, code);
+  prop = uecho_object_getproperty(obj, code);
+  if (!prop)
+    return NULL;
+  
+  return uecho_property_getdata(prop);
 }
 
 /****************************************
@@ -477,10 +622,16 @@ byte *uecho_object_getpropertydata(uEchoObject *obj, uEchoPropertyCode code)
 
 bool uecho_object_getpropertyintegerdata(uEchoObject *obj, uEchoPropertyCode code, size_t dataLen, int *data)
 {
+  uEchoProperty *prop;
+  
   if (!obj)
     return false;
 
-  return uecho_propertylist_getintegerdata(obj->properties, code, dataLen, data);
+  prop = uecho_object_getproperty(obj, code);
+  if (!prop)
+    return false;
+  
+  return uecho_property_getintegerdata(prop, dataLen, data);
 }
 
 /****************************************
@@ -489,10 +640,16 @@ bool uecho_object_getpropertyintegerdata(uEchoObject *obj, uEchoPropertyCode cod
 
 bool uecho_object_getpropertybytedata(uEchoObject *obj, uEchoPropertyCode code, byte *data)
 {
+  uEchoProperty *prop;
+  
   if (!obj)
     return false;
   
-  return uecho_propertylist_getbytedata(obj->properties, code, data);
+  prop = uecho_object_getproperty(obj, code);
+  if (!prop)
+    return false;
+  
+  return uecho_property_getbytedata(prop, data);
 }
 
 /****************************************
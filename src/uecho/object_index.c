@@ -0,0 +1,253 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/object_internal.h>
+
+/****************************************
+* uecho_objectindex_hash
+****************************************/
+
+static size_t uecho_objectindex_hash(uEchoObjectCode code)
+{
+  size_t hash;
+  
+  // Mix the class code bytes so that instances of the same class are spread
+  
+  hash = (size_t)(code & 0xFFFFFF);
+  hash ^= hash >> 13;
+  hash *= 0x5BD1E995U;
+  hash ^= hash >> 15;
+  
+  return hash;
+}
+
+/****************************************
+* uecho_objectindex_getslot
+****************************************/
+
+static size_t uecho_objectindex_getslot(uEchoObjectIndex *index, uEchoObjectCode code)
+{
+  size_t mask, slot;
+  
+  // Returns the slot of the object with the code, or the empty slot where it should be stored
+  
+  mask = index->capacity - 1;
+  slot = uecho_objectindex_hash(code) & mask;
+  while (index->objs[slot]) {
+    if (uecho_object_getcode(index->objs[slot]) == code)
+      break;
+    slot = (slot + 1) & mask;
+  }
+  
+  return slot;
+}
+
+/****************************************
+* uecho_objectindex_reserve
+****************************************/
+
+static bool uecho_objectindex_reserve(uEchoObjectIndex *index, size_t objCnt)
+{
+  uEchoObject **oldObjs;
+  size_t oldCapacity, newCapacity, n;
+  
+  if ((objCnt * 2) < index->capacity)
+    return true;
+  
+  newCapacity = index->capacity;
+  while (newCapacity <= (objCnt * 2))
+    newCapacity *= 2;
+  
+  oldObjs = index->objs;
+  oldCapacity = index->capacity;
+  
+  index->objs = (uEchoObject **)calloc(newCapacity, sizeof(uEchoObject *));
+  if (!index->objs) {
+    index->objs = oldObjs;
+    return false;
+  }
+  index->capacity = newCapacity;
+  
+  for (n=0; n<oldCapacity; n++) {
+    if (!oldObjs[n])
+      continue;
+    index->objs[uecho_objectindex_getslot(index, uecho_object_getcode(oldObjs[n]))] = oldObjs[n];
+  }
+  
+  free(oldObjs);
+  
+  return true;
+}
+
+/****************************************
+* uecho_objectindex_new
+****************************************/
+
+uEchoObjectIndex *uecho_objectindex_new(void)
+{
+  uEchoObjectIndex *index;
+  
+  index = (uEchoObjectIndex *)malloc(sizeof(uEchoObjectIndex));
+  if (!index)
+    return NULL;
+  
+  index->mutex = uecho_mutex_new();
+  index->capacity = uEchoObjectIndexInitialCapacity;
+  index->size = 0;
+  index->objs = (uEchoObject **)calloc(index->capacity, sizeof(uEchoObject *));
+  
+  if (!index->mutex || !index->objs) {
+    uecho_objectindex_delete(index);
+    return NULL;
+  }
+  
+  return index;
+}
+
+/****************************************
+* uecho_objectindex_delete
+****************************************/
+
+void uecho_objectindex_delete(uEchoObjectIndex *index)
+{
+  if (!index)
+    return;
+  
+  if (index->mutex)
+    uecho_mutex_delete(index->mutex);
+  if (index->objs)
+    free(index->objs);
+  
+  free(index);
+}
+
+/****************************************
+* uecho_objectindex_clear
+****************************************/
+
+void uecho_objectindex_clear(uEchoObjectIndex *index)
+{
+  if (!index)
+    return;
+  
+  uecho_mutex_lock(index->mutex);
+  memset(index->objs, 0, sizeof(uEchoObject *) * index->capacity);
+  index->size = 0;
+  uecho_mutex_unlock(index->mutex);
+}
+
+/****************************************
+* uecho_objectindex_add
+****************************************/
+
+bool uecho_objectindex_add(uEchoObjectIndex *index, uEchoObject *obj)
+{
+  size_t slot;
+  
+  if (!index || !obj)
+    return false;
+  
+  uecho_mutex_lock(index->mutex);
+  
+  if (!uecho_objectindex_reserve(index, (index->size + 1))) {
+    uecho_mutex_unlock(index->mutex);
+    return false;
+  }
+  
+  slot = uecho_objectindex_getslot(index, uecho_object_getcode(obj));
+  if (!index->objs[slot])
+    index->size++;
+  index->objs[slot] = obj;
+  
+  uecho_mutex_unlock(index->mutex);
+  
+  return true;
+}
+
+/****************************************
+* uecho_objectindex_remove
+****************************************/
+
+bool uecho_objectindex_remove(uEchoObjectIndex *index, uEchoObject *obj, uEchoObjectCode code)
+{
+  size_t mask, slot, nextSlot, homeSlot;
+  
+  if (!index || !obj)
+    return false;
+  
+  uecho_mutex_lock(index->mutex);
+  
+  // The object is looked up by the code it was indexed with, which may differ from its current code
+  
+  mask = index->capacity - 1;
+  slot = uecho_objectindex_hash(code) & mask;
+  while (index->objs[slot] && (index->objs[slot] != obj))
+    slot = (slot + 1) & mask;
+  
+  if (!index->objs[slot]) {
+    uecho_mutex_unlock(index->mutex);
+    return false;
+  }
+  
+  // Shift the following entries back so that no probe sequence is broken by the removed slot
+  
+  index->objs[slot] = NULL;
+  nextSlot = (slot + 1) & mask;
+  while (index->objs[nextSlot]) {
+    homeSlot = uecho_objectindex_hash(uecho_object_getcode(index->objs[nextSlot])) & mask;
+    if (((nextSlot - homeSlot) & mask) >= ((nextSlot - slot) & mask)) {
+      index->objs[slot] = index->objs[nextSlot];
+      index->objs[nextSlot] = NULL;
+      slot = nextSlot;
+    }
+    nextSlot = (nextSlot + 1) & mask;
+  }
+  index->size--;
+  
+  uecho_mutex_unlock(index->mutex);
+  
+  return true;
+}
+
+/****************************************
+* uecho_objectindex_getbycode
+****************************************/
+
+uEchoObject *uecho_objectindex_getbycode(uEchoObjectIndex *index, uEchoObjectCode code)
+{
+  uEchoObject *obj;
+  
+  if (!index)
+    return NULL;
+  
+  uecho_mutex_lock(index->mutex);
+  obj = index->objs[uecho_objectindex_getslot(index, code)];
+  uecho_mutex_unlock(index->mutex);
+  
+  return obj;
+}
+
+/****************************************
+* uecho_objectindex_size
+****************************************/
+
+size_t uecho_objectindex_size(uEchoObjectIndex *index)
+{
+  size_t size;
+  
+  if (!index)
+    return 0;
+  
+  uecho_mutex_lock(index->mutex);
+  size = index->size;
+  uecho_mutex_unlock(index->mutex);
+  
+  return size;
+}
@@ -22,28 +22,41 @@
 extern "C" {
 #endif
   
+/****************************************
+ * Constant
+ ****************************************/
+
+enum {
+  uEchoObjectPropertyIndexSize = 256,
+  uEchoObjectIndexInitialCapacity = 16,
+  uEchoObjectMultiIndexInitialObjectSize = 4,
+  uEchoObjectPropertyMapSetSize = (uEchoObjectPropertyIndexSize / 8),
+  uEchoObjectPropertyMapListMaxSize = 15,
+};
+
 /****************************************
  * Data Type
  ****************************************/
 
+typedef struct {
+  byte codes[uEchoObjectPropertyMapSetSize];
+  size_t codeCnt;
+} uEchoPropertyMapSet;
+
 typedef struct _uEchoObject {
   UECHO_LIST_STRUCT_MEMBERS
 
   byte code[3];
   uEchoPropertyList *properties;
+  uEchoProperty *propIndex[uEchoObjectPropertyIndexSize];
 
   void *parentNode;
   
-  // Property map caches
+  // Property maps
 
-  size_t annoPropMapSize;
-  byte *annoPropMapBytes;
-  
-  size_t setPropMapSize;
-  byte *setPropMapBytes;
-
-  size_t getPropMapSize;
-  byte *getPropMapBytes;
+  uEchoPropertyMapSet annoPropMap;
+  uEchoPropertyMapSet setPropMap;
+  uEchoPropertyMapSet getPropMap;
 
   // Listener
   
@@ -51,6 +64,28 @@ typedef struct _uEchoObject {
   void *propListenerMgr;
 } uEchoObject, uEchoObjectList;
 
+typedef struct _uEchoObjectIndex {
+  uEchoMutex *mutex;
+  uEchoObject **objs;
+  size_t size;
+  size_t capacity;
+} uEchoObjectIndex;
+
+typedef struct {
+  bool isUsed;
+  int key;
+  uEchoObject **objs;
+  size_t objCnt;
+  size_t objMemSize;
+} uEchoObjectMultiIndexEntry;
+
+typedef struct _uEchoObjectMultiIndex {
+  uEchoMutex *mutex;
+  uEchoObjectMultiIndexEntry *entries;
+  size_t size;
+  size_t capacity;
+} uEchoObjectMultiIndex;
+
 /****************************************
  * Header
  ****************************************/
@@ -63,6 +98,8 @@ typedef struct _uEchoObject {
 
 #define uecho_object_remove(obj) uecho_list_remove((uEchoList *)obj)
 
+uEchoObject *uecho_object_remote_new(void);
+
 uEchoObjectMessageListener uecho_object_getmessagelistener(uEchoObject *obj);
 bool uecho_object_hasmessagelistener(uEchoObject *obj);
   
@@ -70,10 +107,17 @@ uEchoPropertyRequestListener uecho_object_getpropertyrequestlistener(uEchoObject
 bool uecho_object_haspropertyrequestlistener(uEchoObject *obj, uEchoEsv esv, uEchoPropertyCode code);
   
 bool uecho_object_addmandatoryproperties(uEchoObject *obj);
+bool uecho_object_setpropertymap(uEchoObject *obj, uEchoPropertyCode mapCode, uEchoPropertyCode *propCodes, size_t propsCodeSize);
+bool uecho_object_setpropertymapcode(uEchoObject *obj, uEchoPropertyCode code, uEchoPropertyAttr attr);
 bool uecho_object_updatepropertymaps(uEchoObject *obj);
 void uecho_object_clearpropertymapcaches(uEchoObject *obj);
+#define uecho_object_ispropertymapcode(code) ((code == uEchoObjectAnnoPropertyMap) || (code == uEchoObjectSetPropertyMap) || (code == uEchoObjectGetPropertyMap))
 
 uEchoProperty *uecho_object_getpropertywait(uEchoObject *obj, uEchoPropertyCode code, clock_t waitMiliTime);
+uEchoProperty *uecho_object_addproperty(uEchoObject *obj, uEchoPropertyCode code);
+bool uecho_object_cachepropertydata(uEchoObject *obj, uEchoPropertyCode code, byte *data, size_t dataLen);
+
+size_t uecho_object_writeresponsemessage(uEchoObject *obj, uEchoMessage *msg, uEchoEsv resEsv, byte *buf, size_t bufLen);
 
 /****************************************
  * Function (Object List)
@@ -89,6 +133,30 @@ uEchoObject *uecho_objectlist_getbycode(uEchoObjectList *props, uEchoObjectCode
 #define uecho_objectlist_size(objs) uecho_list_size((uEchoList *)objs)
 #define uecho_objectlist_gets(objs) (uEchoObject *)uecho_list_next((uEchoList *)objs)
 #define uecho_objectlist_add(objs,obj) uecho_list_add((uEchoList *)objs, (uEchoList *)obj)
+
+/****************************************
+ * Function (Object Index)
+ ****************************************/
+
+uEchoObjectIndex *uecho_objectindex_new(void);
+void uecho_objectindex_delete(uEchoObjectIndex *index);
+void uecho_objectindex_clear(uEchoObjectIndex *index);
+bool uecho_objectindex_add(uEchoObjectIndex *index, uEchoObject *obj);
+bool uecho_objectindex_remove(uEchoObjectIndex *index, uEchoObject *obj, uEchoObjectCode code);
+uEchoObject *uecho_objectindex_getbycode(uEchoObjectIndex *index, uEchoObjectCode code);
+size_t uecho_objectindex_size(uEchoObjectIndex *index);
+
+/****************************************
+ * Function (Object Multi Index)
+ ****************************************/
+
+uEchoObjectMultiIndex *uecho_objectmultiindex_new(void);
+void uecho_objectmultiindex_delete(uEchoObjectMultiIndex *index);
+void uecho_objectmultiindex_clear(uEchoObjectMultiIndex *index);
+bool uecho_objectmultiindex_add(uEchoObjectMultiIndex *index, int key, uEchoObject *obj);
+bool uecho_objectmultiindex_remove(uEchoObjectMultiIndex *index, int key, uEchoObject *obj);
+size_t uecho_objectmultiindex_getobjects(uEchoObjectMultiIndex *index, int key, uEchoObject **objs, size_t maxObjCnt);
+uEchoObject *uecho_objectmultiindex_getobject(uEchoObjectMultiIndex *index, int key);
   
 #ifdef  __cplusplus
 } /* extern C */
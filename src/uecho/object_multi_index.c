@@ -0,0 +1,268 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/object_internal.h>
+
+/****************************************
+* uecho_objectmultiindex_hash
+****************************************/
+
+static size_t uecho_objectmultiindex_hash(int key)
+{
+  size_t hash;
+  
+  hash = (size_t)(key & 0xFFFFFF);
+  hash ^= hash >> 13;
+  hash *= 0x5BD1E995U;
+  hash ^= hash >> 15;
+  
+  return hash;
+}
+
+/****************************************
+* uecho_objectmultiindex_getentry
+****************************************/
+
+static uEchoObjectMultiIndexEntry *uecho_objectmultiindex_getentry(uEchoObjectMultiIndex *index, int key)
+{
+  size_t mask, slot;
+  
+  // Returns the entry of the key, or the unused entry where it should be stored
+  
+  mask = index->capacity - 1;
+  slot = uecho_objectmultiindex_hash(key) & mask;
+  while (index->entries[slot].isUsed) {
+    if (index->entries[slot].key == key)
+      break;
+    slot = (slot + 1) & mask;
+  }
+  
+  return &index->entries[slot];
+}
+
+/****************************************
+* uecho_objectmultiindex_reserve
+****************************************/
+
+static bool uecho_objectmultiindex_reserve(uEchoObjectMultiIndex *index, size_t keyCnt)
+{
+  uEchoObjectMultiIndexEntry *oldEntries;
+  size_t oldCapacity, newCapacity, n;
+  
+  if ((keyCnt * 2) < index->capacity)
+    return true;
+  
+  newCapacity = index->capacity;
+  while (newCapacity <= (keyCnt * 2))
+    newCapacity *= 2;
+  
+  oldEntries = index->entries;
+  oldCapacity = index->capacity;
+  
+  index->entries = (uEchoObjectMultiIndexEntry *)calloc(newCapacity, sizeof(uEchoObjectMultiIndexEntry));
+  if (!index->entries) {
+    index->entries = oldEntries;
+    return false;
+  }
+  index->capacity = newCapacity;
+  
+  for (n=0; n<oldCapacity; n++) {
+    if (!oldEntries[n].isUsed)
+      continue;
+    *uecho_objectmultiindex_getentry(index, oldEntries[n].key) = oldEntries[n];
+  }
+  
+  free(oldEntries);
+  
+  return true;
+}
+
+/****************************************
+* uecho_objectmultiindex_new
+****************************************/
+
+uEchoObjectMultiIndex *uecho_objectmultiindex_new(void)
+{
+  uEchoObjectMultiIndex *index;
+  
+  index = (uEchoObjectMultiIndex *)malloc(sizeof(uEchoObjectMultiIndex));
+  if (!index)
+    return NULL;
+  
+  index->mutex = uecho_mutex_new();
+  index->capacity = uEchoObjectIndexInitialCapacity;
+  index->size = 0;
+  index->entries = (uEchoObjectMultiIndexEntry *)calloc(index->capacity, sizeof(uEchoObjectMultiIndexEntry));
+  
+  if (!index->mutex || !index->entries) {
+    uecho_objectmultiindex_delete(index);
+    return NULL;
+  }
+  
+  return index;
+}
+
+/****************************************
+* uecho_objectmultiindex_delete
+****************************************/
+
+void uecho_objectmultiindex_delete(uEchoObjectMultiIndex *index)
+{
+  if (!index)
+    return;
+  
+  if (index->entries) {
+    uecho_objectmultiindex_clear(index);
+    free(index->entries);
+  }
+  
+  if (index->mutex)
+    uecho_mutex_delete(index->mutex);
+  
+  free(index);
+}
+
+/****************************************
+* uecho_objectmultiindex_clear
+****************************************/
+
+void uecho_objectmultiindex_clear(uEchoObjectMultiIndex *index)
+{
+  size_t n;
+  
+  if (!index)
+    return;
+  
+  uecho_mutex_lock(index->mutex);
+  
+  for (n=0; n<index->capacity; n++) {
+    if (index->entries[n].objs)
+      free(index->entries[n].objs);
+  }
+  memset(index->entries, 0, sizeof(uEchoObjectMultiIndexEntry) * index->capacity);
+  index->size = 0;
+  
+  uecho_mutex_unlock(index->mutex);
+}
+
+/****************************************
+* uecho_objectmultiindex_add
+****************************************/
+
+bool uecho_objectmultiindex_add(uEchoObjectMultiIndex *index, int key, uEchoObject *obj)
+{
+  uEchoObjectMultiIndexEntry *entry;
+  uEchoObject **objs;
+  size_t objMemSize;
+  
+  if (!index || !obj)
+    return false;
+  
+  uecho_mutex_lock(index->mutex);
+  
+  // Keys are never removed, an entry without objects is kept for the next object with the key
+  
+  if (!uecho_objectmultiindex_reserve(index, (index->size + 1))) {
+    uecho_mutex_unlock(index->mutex);
+    return false;
+  }
+  
+  entry = uecho_objectmultiindex_getentry(index, key);
+  if (!entry->isUsed) {
+    entry->isUsed = true;
+    entry->key = key;
+    index->size++;
+  }
+  
+  if (entry->objMemSize <= entry->objCnt) {
+    objMemSize = (0 < entry->objMemSize) ? (entry->objMemSize * 2) : uEchoObjectMultiIndexInitialObjectSize;
+    objs = (uEchoObject **)realloc(entry->objs, sizeof(uEchoObject *) * objMemSize);
+    if (!objs) {
+      uecho_mutex_unlock(index->mutex);
+      return false;
+    }
+    entry->objs = objs;
+    entry->objMemSize = objMemSize;
+  }
+  
+  entry->objs[entry->objCnt++] = obj;
+  
+  uecho_mutex_unlock(index->mutex);
+  
+  return true;
+}
+
+/****************************************
+* uecho_objectmultiindex_remove
+****************************************/
+
+bool uecho_objectmultiindex_remove(uEchoObjectMultiIndex *index, int key, uEchoObject *obj)
+{
+  uEchoObjectMultiIndexEntry *entry;
+  size_t n;
+  
+  if (!index || !obj)
+    return false;
+  
+  uecho_mutex_lock(index->mutex);
+  
+  entry = uecho_objectmultiindex_getentry(index, key);
+  for (n=0; n<entry->objCnt; n++) {
+    if (entry->objs[n] != obj)
+      continue;
+    // Keep the discovery order of the remaining objects
+    memmove(&entry->objs[n], &entry->objs[n + 1], sizeof(uEchoObject *) * (entry->objCnt - n - 1));
+    entry->objCnt--;
+    uecho_mutex_unlock(index->mutex);
+    return true;
+  }
+  
+  uecho_mutex_unlock(index->mutex);
+  
+  return false;
+}
+
+/****************************************
+* uecho_objectmultiindex_getobjects
+****************************************/
+
+size_t uecho_objectmultiindex_getobjects(uEchoObjectMultiIndex *index, int key, uEchoObject **objs, size_t maxObjCnt)
+{
+  uEchoObjectMultiIndexEntry *entry;
+  size_t objCnt;
+  
+  if (!index)
+    return 0;
+  
+  uecho_mutex_lock(index->mutex);
+  
+  entry = uecho_objectmultiindex_getentry(index, key);
+  objCnt = entry->objCnt;
+  if (objs && (0 < maxObjCnt))
+    memcpy(objs, entry->objs, sizeof(uEchoObject *) * ((objCnt < maxObjCnt) ? objCnt : maxObjCnt));
+  
+  uecho_mutex_unlock(index->mutex);
+  
+  return objCnt;
+}
+
+/****************************************
+* uecho_objectmultiindex_getobject
+****************************************/
+
+uEchoObject *uecho_objectmultiindex_getobject(uEchoObjectMultiIndex *index, int key)
+{
+  uEchoObject *obj;
+  
+  if (uecho_objectmultiindex_getobjects(index, key, &obj, 1) <= 0)
+    return NULL;
+  
+  return obj;
+}
@@ -0,0 +1,209 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/controller_internal.h>
+#include <uecho/util/strings.h>
+#include <uecho/util/timer.h>
+
+/****************************************
+* uecho_postrequest_new
+****************************************/
+
+uEchoPostRequest *uecho_postrequest_new(void)
+{
+  uEchoPostRequest *req;
+
+  req = (uEchoPostRequest *)malloc(sizeof(uEchoPostRequest));
+
+  if (!req)
+    return NULL;
+
+  uecho_list_node_init((uEchoList *)req);
+
+  req->tid = 0;
+  req->esv = 0;
+  req->dstAddr = NULL;
+  uecho_socket_address_clear(&req->dstSockAddr);
+  req->dstObjCode = uEchoObjectCodeUnknown;
+  req->resMsg = NULL;
+  req->isResponseReceived = false;
+  req->resListener = NULL;
+  req->userData = NULL;
+  req->expireTime = 0;
+  req->cond = uecho_cond_new();
+
+  if (!req->cond) {
+    free(req);
+    return NULL;
+  }
+
+  return req;
+}
+
+/****************************************
+* uecho_postrequest_delete
+****************************************/
+
+bool uecho_postrequest_delete(uEchoPostRequest *req)
+{
+  if (!req)
+    return false;
+
+  uecho_postrequest_remove(req);
+
+  if (req->dstAddr) {
+    free(req->dstAddr);
+  }
+
+  uecho_cond_delete(req->cond);
+
+  free(req);
+
+  return true;
+}
+
+/****************************************
+ * uecho_postrequest_setdestination
+ ****************************************/
+
+bool uecho_postrequest_setdestination(uEchoPostRequest *req, const char *addr, uEchoObjectCode objCode)
+{
+  if (!req)
+    return false;
+
+  uecho_strloc(addr, &req->dstAddr);
+  uecho_socket_address_setstring(&req->dstSockAddr, addr);
+  req->dstObjCode = objCode;
+
+  return true;
+}
+
+/****************************************
+ * uecho_postrequest_isresponsemessage
+ ****************************************/
+
+bool uecho_postrequest_isresponsemessage(uEchoPostRequest *req, uEchoMessage *msg)
+{
+  uEchoEsv msgEsv, resEsv, errEsv;
+  
+  if (!req || !msg)
+    return false;
+
+  if (uecho_message_gettid(msg) != req->tid)
+    return false;
+
+  // Only the response or error response to the request ESV completes the request,
+  // not a request or notification from the same node with a colliding TID
+
+  msgEsv = uecho_message_getesv(msg);
+  if (!(uecho_message_requestesv2responseesv(req->esv, &resEsv) && (msgEsv == resEsv))) {
+    if (!(uecho_message_requestesv2errorresponseesv(req->esv, &errEsv) && (msgEsv == errEsv)))
+      return false;
+  }
+
+  if (uecho_socket_address_isvalid(&req->dstSockAddr)) {
+    if (!uecho_socket_address_equals(&req->dstSockAddr, uecho_message_getsourcesocketaddress(msg)))
+      return false;
+  }
+  else if (req->dstAddr && !uecho_message_issourceaddress(msg, req->dstAddr))
+    return false;
+
+  // The instance code of the response may differ when the request is sent to all instances
+
+  if ((uecho_message_getsourceobjectcode(msg) & 0xFFFF00) != (req->dstObjCode & 0xFFFF00))
+    return false;
+
+  return true;
+}
+
+/****************************************
+ * uecho_postrequest_setresponse
+ ****************************************/
+
+bool uecho_postrequest_setresponse(uEchoPostRequest *req, uEchoMessage *msg)
+{
+  if (!req || !msg)
+    return false;
+
+  if (req->resMsg) {
+    if (!uecho_message_set(req->resMsg, msg))
+      return false;
+  }
+
+  req->isResponseReceived = true;
+
+  uecho_cond_signal(req->cond);
+
+  return true;
+}
+
+/****************************************
+ * uecho_postrequest_waitresponse
+ ****************************************/
+
+bool uecho_postrequest_waitresponse(uEchoPostRequest *req, uEchoMutex *mutex, clock_t mtime)
+{
+  uEchoMiliTime deadline, now;
+
+  if (!req || !mutex)
+    return false;
+
+  // The mutex must be locked, and it is released while waiting.
+  // Spurious or unrelated wakeups wait only for the rest of the time until the deadline.
+
+  deadline = uecho_getcurrentsystemmilitime() + mtime;
+  while (!uecho_postrequest_isresponsereceived(req)) {
+    now = uecho_getcurrentsystemmilitime();
+    if (deadline <= now)
+      break;
+    if (!uecho_cond_timedwait(req->cond, mutex, (clock_t)(deadline - now)))
+      break;
+  }
+
+  return uecho_postrequest_isresponsereceived(req);
+}
+
+/****************************************
+ * uecho_postrequest_setresponselistener
+ ****************************************/
+
+void uecho_postrequest_setresponselistener(uEchoPostRequest *req, uEchoControllerPostResponseListener listener, void *userData)
+{
+  if (!req)
+    return;
+
+  req->resListener = listener;
+  req->userData = userData;
+}
+
+/****************************************
+ * uecho_postrequest_notifyresponse
+ ****************************************/
+
+bool uecho_postrequest_notifyresponse(uEchoPostRequest *req, uEchoController *ctrl, uEchoMessage *msg)
+{
+  uEchoControllerPostResult result;
+  uEchoEsv esv;
+
+  if (!req || !req->resListener)
+    return false;
+
+  // No message means that no response was received until the expire time
+
+  result = uEchoControllerPostResultTimeout;
+  if (msg) {
+    esv = uecho_message_getesv(msg);
+    result = ((esv & 0xF0) == 0x50) ? uEchoControllerPostResultErrorResponse : uEchoControllerPostResultResponse;
+  }
+
+  req->resListener(ctrl, result, msg, req->userData);
+
+  return true;
+}
@@ -0,0 +1,61 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/controller_internal.h>
+
+/****************************************
+* uecho_postrequestlist_new
+****************************************/
+
+uEchoPostRequestList *uecho_postrequestlist_new(void)
+{
+  uEchoPostRequestList *reqs;
+
+  reqs = (uEchoPostRequestList *)malloc(sizeof(uEchoPostRequestList));
+  if (!reqs)
+    return NULL;
+
+  uecho_list_header_init((uEchoList *)reqs);
+
+  return reqs;
+}
+
+/****************************************
+* uecho_postrequestlist_delete
+****************************************/
+
+void uecho_postrequestlist_delete(uEchoPostRequestList *reqs)
+{
+  if (!reqs)
+    return;
+
+  uecho_postrequestlist_clear(reqs);
+
+  free(reqs);
+}
+
+/****************************************
+ * uecho_postrequestlist_getbyresponsemessage
+ ****************************************/
+
+uEchoPostRequest *uecho_postrequestlist_getbyresponsemessage(uEchoPostRequestList *reqs, uEchoMessage *msg)
+{
+  uEchoPostRequest *req;
+
+  if (!reqs || !msg)
+    return NULL;
+
+  for (req = uecho_postrequestlist_gets(reqs); req; req = uecho_postrequest_next(req)) {
+    if (uecho_postrequest_isresponsemessage(req, msg))
+      return req;
+  }
+
+  return NULL;
+}
@@ -13,6 +13,24 @@
 #include <uecho/property_internal.h>
 #include <uecho/node_internal.h>
 #include <uecho/misc.h>
+#include <uecho/util/pool.h>
+
+/****************************************
+* uecho_property_init
+****************************************/
+
+static void uecho_property_init(uEchoProperty *prop, uEchoArena *arena)
+{
+  uecho_list_node_init((uEchoList *)prop);
+  
+  prop->data = NULL;
+  prop->dataSize = 0;
+  prop->isDataView = false;
+  prop->arena = arena;
+  
+  uecho_property_setparentobject(prop, NULL);
+  uecho_property_setattribute(prop, uEchoPropertyAttrReadWrite);
+}
 
 /****************************************
 * uecho_property_new
@@ -22,18 +40,34 @@ uEchoProperty *uecho_property_new(void)
 {
   uEchoProperty *prop;
 
-  prop = (uEchoProperty *)malloc(sizeof(uEchoProperty));
+  prop = (uEchoProperty *)uecho_pool_alloc(uEchoPoolProperty, sizeof(uEchoProperty));
     
   if (!prop)
     return NULL;
 
-  uecho_list_node_init((uEchoList *)prop);
+  uecho_property_init(prop, NULL);
   
-  prop->data = NULL;
-  prop->dataSize = 0;
+  return prop;
+}
+
+/****************************************
+* uecho_property_arena_new
+****************************************/
+
+uEchoProperty *uecho_property_arena_new(uEchoArena *arena)
+{
+  uEchoProperty *prop;
   
-  uecho_property_setparentobject(prop, NULL);
-  uecho_property_setattribute(prop, uEchoPropertyAttrReadWrite);
+  if (!arena)
+    return uecho_property_new();
+  
+  // The property and its data are released all together when the arena is reset
+  
+  prop = (uEchoProperty *)uecho_arena_alloc(arena, sizeof(uEchoProperty));
+  if (!prop)
+    return NULL;
+  
+  uecho_property_init(prop, arena);
   
   return prop;
 }
@@ -50,7 +84,8 @@ bool uecho_property_delete(uEchoProperty *prop)
   uecho_property_cleardata(prop);
   uecho_property_remove(prop);
 
-  free(prop);
+  if (!prop->arena)
+    uecho_pool_free(uEchoPoolProperty, prop);
   
   return true;
 }
@@ -95,7 +130,19 @@ bool uecho_property_setcount(uEchoProperty *prop, size_t count)
   if (count == 0)
     return true;
   
-  prop->data = (byte *)calloc(1, count);
+  // Small data are stored in the property itself without allocation
+  
+  if (count <= uEchoPropertyInlineDataSize) {
+    memset(prop->inlineData, 0, count);
+    prop->data = prop->inlineData;
+    prop->dataSize = count;
+    return true;
+  }
+  
+  if (prop->arena)
+    prop->data = (byte *)uecho_arena_calloc(prop->arena, count);
+  else
+    prop->data = (byte *)calloc(1, count);
   if (!prop->data)
     return false;
   
@@ -111,6 +158,7 @@ bool uecho_property_setcount(uEchoProperty *prop, size_t count)
 bool uecho_property_addcount(uEchoProperty *prop, size_t count)
 {
   size_t newDataSize;
+  byte *newData;
   
   if (!prop)
     return false;
@@ -119,10 +167,30 @@ bool uecho_property_addcount(uEchoProperty *prop, size_t count)
     return true;
   
   newDataSize = prop->dataSize + count;
-  prop->data = (byte *)realloc(prop->data, newDataSize);
-  if (!prop->data)
-    return false;
   
+  if (prop->isDataView || !prop->data || uecho_property_isinlinedata(prop) || prop->arena) {
+    if (newDataSize <= uEchoPropertyInlineDataSize) {
+      newData = prop->inlineData;
+    }
+    else {
+      if (prop->arena)
+        newData = (byte *)uecho_arena_alloc(prop->arena, newDataSize);
+      else
+        newData = (byte *)malloc(newDataSize);
+      if (!newData)
+        return false;
+    }
+    if ((0 < prop->dataSize) && (newData != prop->data))
+      memmove(newData, prop->data, prop->dataSize);
+    prop->isDataView = false;
+  }
+  else {
+    newData = (byte *)realloc(prop->data, newDataSize);
+    if (!newData)
+      return false;
+  }
+  
+  prop->data = newData;
   prop->dataSize = newDataSize;
   
   return true;
@@ -154,6 +222,29 @@ bool uecho_property_setdata(uEchoProperty *prop, const byte *data, size_t count)
   return true;
 }
 
+/****************************************
+ * uecho_property_setdataview
+ ****************************************/
+
+bool uecho_property_setdataview(uEchoProperty *prop, const byte *data, size_t count)
+{
+  if (!prop)
+    return false;
+  
+  uecho_property_cleardata(prop);
+  
+  if (count == 0)
+    return true;
+  
+  // The data is not copied and must remain valid while the property refers it.
+  
+  prop->data = (byte *)data;
+  prop->dataSize = count;
+  prop->isDataView = true;
+  
+  return true;
+}
+
 /****************************************
  * uecho_property_adddata
  ****************************************/
@@ -199,12 +290,20 @@ bool uecho_property_addbytedata(uEchoProperty *prop, const byte data)
 
 bool uecho_property_setintegerdata(uEchoProperty *prop, int data, size_t dataSize)
 {
+  byte inlineIntByte[uEchoPropertyInlineDataSize];
   bool isSuccess;
   byte *intByte;
   
   if (!prop)
     return false;
 
+  // Small integers are encoded on the stack, and larger ones in a temporary buffer as before
+  
+  if (dataSize <= sizeof(inlineIntByte)) {
+    uecho_integer2byte(data, inlineIntByte, dataSize);
+    return uecho_property_setdata(prop, inlineIntByte, dataSize);
+  }
+  
   intByte = (byte *)malloc(dataSize);
   if (!intByte)
     return true;
@@ -275,6 +374,12 @@ bool uecho_property_cleardata(uEchoProperty *prop)
 
   prop->dataSize= 0;
   
+  if (prop->isDataView || uecho_property_isinlinedata(prop) || prop->arena) {
+    prop->data = NULL;
+    prop->isDataView = false;
+    return true;
+  }
+  
   if (prop->data) {
     free(prop->data);
     prop->data = NULL;
@@ -298,6 +403,14 @@ uEchoProperty *uecho_property_next(uEchoProperty *prop)
 
 void uecho_property_remove(uEchoProperty *prop)
 {
+  uEchoObject *obj;
+  
+  // Clear the index slot of the parent object not to leave it pointing at a released property
+  
+  obj = (uEchoObject *)prop->parentObj;
+  if (obj && (obj->propIndex[prop->code & 0xFF] == prop))
+    obj->propIndex[prop->code & 0xFF] = NULL;
+  
   uecho_list_remove((uEchoList *)prop);
 }
 
@@ -307,6 +420,17 @@ void uecho_property_remove(uEchoProperty *prop)
 
 void uecho_property_setcode(uEchoProperty *prop, uEchoPropertyCode val)
 {
+  uEchoObject *obj;
+  
+  // Move the index slot of the parent object to the new code
+  
+  obj = (uEchoObject *)prop->parentObj;
+  if (obj && (obj->propIndex[prop->code & 0xFF] == prop)) {
+    obj->propIndex[prop->code & 0xFF] = NULL;
+    if (!obj->propIndex[val & 0xFF])
+      obj->propIndex[val & 0xFF] = prop;
+  }
+  
   prop->code = val;
 }
       
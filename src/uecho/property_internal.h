@@ -12,6 +12,7 @@
 #define _UECHO_PROPERTY_INTERNAL_H_
 
 #include <stdbool.h>
+#include <uecho/util/arena.h>
 #include <uecho/util/list.h>
 #include <uecho/util/mutex.h>
 
@@ -19,6 +20,14 @@
 extern "C" {
 #endif
   
+/****************************************
+ * Constant
+ ****************************************/
+
+enum {
+  uEchoPropertyInlineDataSize = 8,
+};
+
 /****************************************
  * Data Type
  ****************************************/
@@ -32,6 +41,9 @@ extern "C" {
 typedef struct {
   UECHO_LIST_STRUCT_MEMBERS
   UECHO_PROPERTY_DATA_STRUCT_MEMBERS
+  bool isDataView;
+  byte inlineData[uEchoPropertyInlineDataSize];
+  uEchoArena *arena;
   void *parentObj;
 } uEchoProperty, uEchoPropertyList;
 
@@ -49,9 +61,16 @@ typedef struct {
  * Function (Property)
  ****************************************/
 
+uEchoProperty *uecho_property_arena_new(uEchoArena *arena);
+#define uecho_property_getarena(prop) (prop->arena)
+
 bool uecho_property_setcount(uEchoProperty *prop, size_t count);
 bool uecho_property_addcount(uEchoProperty *prop, size_t count);
 
+bool uecho_property_setdataview(uEchoProperty *prop, const byte *data, size_t count);
+#define uecho_property_isdataview(prop) (prop->isDataView)
+#define uecho_property_isinlinedata(prop) (prop->data == prop->inlineData)
+
 bool uecho_property_announce(uEchoProperty *prop);
 
 /****************************************
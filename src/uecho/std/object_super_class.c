@@ -19,8 +19,6 @@
 
 bool uecho_object_addmandatoryproperties(uEchoObject *obj)
 {
-  byte zeroPropMap[] = {0};
-  
   if (!obj)
     return false;
   
@@ -32,15 +30,10 @@ bool uecho_object_addmandatoryproperties(uEchoObject *obj)
   // Property map properties
   
   uecho_object_setproperty(obj, uEchoObjectGetPropertyMap, uEchoPropertyAttrRead);
-  uecho_object_setpropertydata(obj, uEchoObjectGetPropertyMap, zeroPropMap, sizeof(zeroPropMap));
-
   uecho_object_setproperty(obj, uEchoObjectSetPropertyMap, uEchoPropertyAttrRead);
-  uecho_object_setpropertydata(obj, uEchoObjectSetPropertyMap, zeroPropMap, sizeof(zeroPropMap));
-
   uecho_object_setproperty(obj, uEchoObjectAnnoPropertyMap, uEchoPropertyAttrRead);
-  uecho_object_setpropertydata(obj, uEchoObjectAnnoPropertyMap, zeroPropMap, sizeof(zeroPropMap));
   
-  return true;
+  return uecho_object_updatepropertymaps(obj);
 }
 
 /****************************************
@@ -65,56 +58,121 @@ uEchoManufacturerCode uecho_object_getmanufacturercode(uEchoObject *obj)
 }
 
 /****************************************
- * uecho_object_updatepropertymaps
+ * uecho_propertymapset_setcode
  ****************************************/
 
-bool uecho_object_updatepropertymaps(uEchoObject *obj)
+static bool uecho_propertymapset_setcode(uEchoPropertyMapSet *mapSet, uEchoPropertyCode code, bool flag)
 {
-  uEchoProperty *prop;
+  size_t byteIdx;
+  byte bitMask;
   
-  if (!obj)
+  byteIdx = (code & 0xFF) / 8;
+  bitMask = (byte)(1 << ((code & 0xFF) % 8));
+  
+  if (((mapSet->codes[byteIdx] & bitMask) ? true : false) == flag)
     return false;
   
-  uecho_object_clearpropertymapcaches(obj);
+  if (flag) {
+    mapSet->codes[byteIdx] |= bitMask;
+    mapSet->codeCnt++;
+  }
+  else {
+    mapSet->codes[byteIdx] &= ~bitMask;
+    mapSet->codeCnt--;
+  }
   
-  // Update property map caches
+  return true;
+}
+
+/****************************************
+ * uecho_propertymapset_getcodes
+ ****************************************/
+
+static size_t uecho_propertymapset_getcodes(uEchoPropertyMapSet *mapSet, uEchoPropertyCode *propCodes)
+{
+  size_t byteIdx, bitIdx, codeCnt;
   
-  for (prop = uecho_object_getproperties(obj); prop; prop = uecho_property_next(prop)) {
-    // Get property map
-    if (uecho_property_isreadable(prop)) {
-      obj->getPropMapSize++;
-      obj->getPropMapBytes = realloc(obj->getPropMapBytes, obj->getPropMapSize);
-      if (obj->getPropMapBytes) {
-        obj->getPropMapBytes[obj->getPropMapSize-1] = uecho_property_getcode(prop);
-      }
-    }
-    
-    // Set property map
-    if (uecho_property_iswritable(prop)) {
-      obj->setPropMapSize++;
-      obj->setPropMapBytes = realloc(obj->setPropMapBytes, obj->setPropMapSize);
-      if (obj->setPropMapBytes) {
-        obj->setPropMapBytes[obj->setPropMapSize-1] = uecho_property_getcode(prop);
-      }
-    }
-    
-    // Announcement status changes property map
-    if (uecho_property_isannouncement(prop)) {
-      obj->annoPropMapSize++;
-      obj->annoPropMapBytes = realloc(obj->annoPropMapBytes, obj->annoPropMapSize);
-      if (obj->annoPropMapBytes) {
-        obj->annoPropMapBytes[obj->annoPropMapSize-1] = uecho_property_getcode(prop);
-      }
+  codeCnt = 0;
+  for (byteIdx=0; byteIdx<uEchoObjectPropertyMapSetSize; byteIdx++) {
+    if (!mapSet->codes[byteIdx])
+      continue;
+    for (bitIdx=0; bitIdx<8; bitIdx++) {
+      if (mapSet->codes[byteIdx] & (1 << bitIdx))
+        propCodes[codeCnt++] = (uEchoPropertyCode)((byteIdx * 8) + bitIdx);
     }
   }
   
+  return codeCnt;
+}
+
+/****************************************
+ * uecho_object_serializepropertymap
+ ****************************************/
+
+static bool uecho_object_serializepropertymap(uEchoObject *obj, uEchoPropertyCode mapCode, uEchoPropertyMapSet *mapSet)
+{
+  uEchoPropertyCode propCodes[uEchoObjectPropertyIndexSize];
+  size_t propCodeCnt;
+  
+  propCodeCnt = uecho_propertymapset_getcodes(mapSet, propCodes);
+  
+  return uecho_object_setpropertymap(obj, mapCode, propCodes, propCodeCnt);
+}
+
+/****************************************
+ * uecho_object_setpropertymapcode
+ ****************************************/
+
+bool uecho_object_setpropertymapcode(uEchoObject *obj, uEchoPropertyCode code, uEchoPropertyAttr attr)
+{
+  bool allActionsSucceeded = true;
+  
+  if (!obj)
+    return false;
+  
+  // Only the changed maps are serialized, and only here, so reading the map properties never modifies them.
+  // The map properties which are not added yet are serialized by uecho_object_updatepropertymaps().
+  
+  if (uecho_propertymapset_setcode(&obj->getPropMap, code, (attr & uEchoPropertyAttrRead) ? true : false)) {
+    if (obj->propIndex[uEchoProfileGetPropertyMap & 0xFF])
+      allActionsSucceeded &= uecho_object_serializepropertymap(obj, uEchoProfileGetPropertyMap, &obj->getPropMap);
+  }
+  if (uecho_propertymapset_setcode(&obj->setPropMap, code, (attr & uEchoPropertyAttrWrite) ? true : false)) {
+    if (obj->propIndex[uEchoProfileSetPropertyMap & 0xFF])
+      allActionsSucceeded &= uecho_object_serializepropertymap(obj, uEchoProfileSetPropertyMap, &obj->setPropMap);
+  }
+  if (uecho_propertymapset_setcode(&obj->annoPropMap, code, (attr & uEchoPropertyAttrAnno) ? true : false)) {
+    if (obj->propIndex[uEchoProfileAnnoPropertyMap & 0xFF])
+      allActionsSucceeded &= uecho_object_serializepropertymap(obj, uEchoProfileAnnoPropertyMap, &obj->annoPropMap);
+  }
+  
+  return allActionsSucceeded;
+}
+
+/****************************************
+ * uecho_object_updatepropertymaps
+ ****************************************/
+
+bool uecho_object_updatepropertymaps(uEchoObject *obj)
+{
+  bool allActionsSucceeded = true;
+  
+  if (!obj)
+    return false;
+  
+  // The property map properties are readable themselves
+  
+  uecho_object_setpropertymapcode(obj, uEchoProfileGetPropertyMap, uEchoPropertyAttrRead);
+  uecho_object_setpropertymapcode(obj, uEchoProfileSetPropertyMap, uEchoPropertyAttrRead);
+  uecho_object_setpropertymapcode(obj, uEchoProfileAnnoPropertyMap, uEchoPropertyAttrRead);
+  
   // Update property map properties
   
-  uecho_propertylist_set(obj->properties, uEchoProfileGetPropertyMap, uEchoPropertyAttrRead, obj->getPropMapBytes, obj->getPropMapSize);
-  uecho_propertylist_set(obj->properties, uEchoProfileSetPropertyMap, uEchoPropertyAttrRead, obj->setPropMapBytes, obj->setPropMapSize);
-  uecho_propertylist_set(obj->properties, uEchoProfileAnnoPropertyMap, uEchoPropertyAttrRead, obj->annoPropMapBytes, obj->annoPropMapSize);
+  allActionsSucceeded &= uecho_object_serializepropertymap(obj, uEchoProfileGetPropertyMap, &obj->getPropMap);
+  allActionsSucceeded &= uecho_object_serializepropertymap(obj, uEchoProfileSetPropertyMap, &obj->setPropMap);
+  allActionsSucceeded &= uecho_object_serializepropertymap(obj, uEchoProfileAnnoPropertyMap, &obj->annoPropMap);
   
-  return true;
+  return allActionsSucceeded;
 }
 
 /****************************************
@@ -125,22 +183,8 @@ void uecho_object_clearpropertymapcaches(uEchoObject *obj)
 {
   if (!obj)
     return;
-    
-  if (obj->annoPropMapBytes) {
-    free(obj->annoPropMapBytes);
-    obj->annoPropMapBytes = NULL;
-  }
-  obj->annoPropMapSize = 0;
   
-  if (obj->setPropMapBytes) {
-    free(obj->setPropMapBytes);
-    obj->setPropMapBytes = NULL;
-  }
-  obj->setPropMapSize = 0;
-  
-  if (obj->getPropMapBytes) {
-    free(obj->getPropMapBytes);
-    obj->getPropMapBytes = NULL;
-  }
-  obj->getPropMapSize = 0;
+  memset(&obj->annoPropMap, 0, sizeof(obj->annoPropMap));
+  memset(&obj->setPropMap, 0, sizeof(obj->setPropMap));
+  memset(&obj->getPropMap, 0, sizeof(obj->getPropMap));
 }
@@ -0,0 +1,135 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/util/arena.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************
+ * Define
+ ****************************************/
+
+#define uecho_arena_alignsize(size) (((size) + (uEchoArenaAlignment - 1)) & ~((size_t)uEchoArenaAlignment - 1))
+
+/****************************************
+ * uecho_arena_new
+ ****************************************/
+
+uEchoArena *uecho_arena_new(size_t size)
+{
+  uEchoArena *arena;
+
+  arena = (uEchoArena *)malloc(sizeof(uEchoArena));
+  if (!arena)
+    return NULL;
+
+  arena->size = uecho_arena_alignsize(size);
+  arena->buf = (byte *)malloc(arena->size);
+  if (!arena->buf) {
+    free(arena);
+    return NULL;
+  }
+
+  arena->offset = 0;
+  arena->peakSize = 0;
+  arena->overflowBlocks = NULL;
+  arena->overflowCnt = 0;
+
+  return arena;
+}
+
+/****************************************
+ * uecho_arena_delete
+ ****************************************/
+
+void uecho_arena_delete(uEchoArena *arena)
+{
+  if (!arena)
+    return;
+
+  uecho_arena_reset(arena);
+
+  free(arena->buf);
+  free(arena);
+}
+
+/****************************************
+ * uecho_arena_alloc
+ ****************************************/
+
+void *uecho_arena_alloc(uEchoArena *arena, size_t size)
+{
+  uEchoArenaBlock *block;
+  size_t allocSize;
+  void *mem;
+
+  if (!arena)
+    return NULL;
+
+  allocSize = uecho_arena_alignsize(size);
+
+  if (allocSize <= (arena->size - arena->offset)) {
+    mem = arena->buf + arena->offset;
+    arena->offset += allocSize;
+    if (arena->peakSize < arena->offset)
+      arena->peakSize = arena->offset;
+    return mem;
+  }
+
+  // Requests beyond the buffer are served from the heap until the next reset
+
+  block = (uEchoArenaBlock *)malloc(uecho_arena_alignsize(sizeof(uEchoArenaBlock)) + allocSize);
+  if (!block)
+    return NULL;
+
+  block->next = arena->overflowBlocks;
+  arena->overflowBlocks = block;
+  arena->overflowCnt++;
+
+  return (byte *)block + uecho_arena_alignsize(sizeof(uEchoArenaBlock));
+}
+
+/****************************************
+ * uecho_arena_calloc
+ ****************************************/
+
+void *uecho_arena_calloc(uEchoArena *arena, size_t size)
+{
+  void *mem;
+
+  mem = uecho_arena_alloc(arena, size);
+  if (!mem)
+    return NULL;
+
+  memset(mem, 0, size);
+
+  return mem;
+}
+
+/****************************************
+ * uecho_arena_reset
+ ****************************************/
+
+void uecho_arena_reset(uEchoArena *arena)
+{
+  uEchoArenaBlock *block, *nextBlock;
+
+  if (!arena)
+    return;
+
+  for (block = arena->overflowBlocks; block; block = nextBlock) {
+    nextBlock = block->next;
+    free(block);
+  }
+  arena->overflowBlocks = NULL;
+
+  arena->offset = 0;
+}
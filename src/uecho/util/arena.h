@@ -0,0 +1,65 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#ifndef _UECHO_UTIL_ARENA_H_
+#define _UECHO_UTIL_ARENA_H_
+
+#include <uecho/typedef.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/****************************************
+ * Constant
+ ****************************************/
+
+enum {
+  uEchoArenaAlignment = 16,
+};
+
+/****************************************
+ * Data Type
+ ****************************************/
+
+typedef struct _uEchoArenaBlock {
+  struct _uEchoArenaBlock *next;
+} uEchoArenaBlock;
+
+typedef struct _uEchoArena {
+  byte *buf;
+  size_t size;
+  size_t offset;
+  size_t peakSize;
+  uEchoArenaBlock *overflowBlocks;
+  size_t overflowCnt;
+} uEchoArena;
+
+/****************************************
+ * Function
+ ****************************************/
+
+uEchoArena *uecho_arena_new(size_t size);
+void uecho_arena_delete(uEchoArena *arena);
+
+void *uecho_arena_alloc(uEchoArena *arena, size_t size);
+void *uecho_arena_calloc(uEchoArena *arena, size_t size);
+void uecho_arena_reset(uEchoArena *arena);
+
+#define uecho_arena_getsize(arena) ((arena)->size)
+#define uecho_arena_getusedsize(arena) ((arena)->offset)
+#define uecho_arena_getpeaksize(arena) ((arena)->peakSize)
+#define uecho_arena_getoverflowcount(arena) ((arena)->overflowCnt)
+
+#ifdef  __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
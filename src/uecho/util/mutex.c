@@ -8,10 +8,22 @@
  *
  ******************************************************************/
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include <uecho/util/mutex.h>
 
 #include <errno.h>
 
+#if !defined(WIN32)
+#include <sys/time.h>
+#endif
+
+#if defined(HAVE_CLOCK_MONOTONIC) && defined(HAVE_PTHREAD_CONDATTR_SETCLOCK)
+#define UECHO_COND_USE_MONOTONIC_CLOCK 1
+#endif
+
 /****************************************
 * uecho_mutex_new
 ****************************************/
@@ -87,3 +99,132 @@ bool uecho_mutex_unlock(uEchoMutex *mutex)
 #endif
   return true;
 }
+
+/****************************************
+* uecho_cond_new
+****************************************/
+
+uEchoCond *uecho_cond_new(void)
+{
+  uEchoCond *cond;
+#if defined(UECHO_COND_USE_MONOTONIC_CLOCK)
+  pthread_condattr_t condAttr;
+#endif
+
+  cond = (uEchoCond *)malloc(sizeof(uEchoCond));
+
+  if (!cond)
+    return NULL;
+
+#if defined(WIN32)
+  cond->condID = CreateEvent(NULL, false, false, NULL);
+#elif defined(UECHO_COND_USE_MONOTONIC_CLOCK)
+  // Time out against the monotonic clock so that wall clock changes don't shorten or extend the waits
+  pthread_condattr_init(&condAttr);
+  pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+  pthread_cond_init(&cond->condID, &condAttr);
+  pthread_condattr_destroy(&condAttr);
+#else
+  pthread_cond_init(&cond->condID, NULL);
+#endif
+
+  return cond;
+}
+
+/****************************************
+* uecho_cond_delete
+****************************************/
+
+bool uecho_cond_delete(uEchoCond *cond)
+{
+  if (!cond)
+    return false;
+
+#if defined(WIN32)
+  CloseHandle(cond->condID);
+#else
+  pthread_cond_destroy(&cond->condID);
+#endif
+  free(cond);
+
+  return true;
+}
+
+/****************************************
+* uecho_cond_wait
+****************************************/
+
+bool uecho_cond_wait(uEchoCond *cond, uEchoMutex *mutex)
+{
+  if (!cond || !mutex)
+    return false;
+
+#if defined(WIN32)
+  SignalObjectAndWait(mutex->mutexID, cond->condID, INFINITE, false);
+  WaitForSingleObject(mutex->mutexID, INFINITE);
+#else
+  pthread_cond_wait(&cond->condID, &mutex->mutexID);
+#endif
+
+  return true;
+}
+
+/****************************************
+* uecho_cond_timedwait
+****************************************/
+
+bool uecho_cond_timedwait(uEchoCond *cond, uEchoMutex *mutex, clock_t mtime)
+{
+#if defined(WIN32)
+  DWORD waitResult;
+#else
+#if !defined(UECHO_COND_USE_MONOTONIC_CLOCK)
+  struct timeval now;
+#endif
+  struct timespec timeout;
+  int waitResult;
+#endif
+
+  if (!cond || !mutex)
+    return false;
+
+#if defined(WIN32)
+  waitResult = SignalObjectAndWait(mutex->mutexID, cond->condID, (DWORD)mtime, false);
+  WaitForSingleObject(mutex->mutexID, INFINITE);
+  return (waitResult == WAIT_OBJECT_0) ? true : false;
+#else
+#if defined(UECHO_COND_USE_MONOTONIC_CLOCK)
+  clock_gettime(CLOCK_MONOTONIC, &timeout);
+  timeout.tv_sec += (mtime / 1000);
+  timeout.tv_nsec += ((mtime % 1000) * 1000000);
+#else
+  gettimeofday(&now, NULL);
+  timeout.tv_sec = now.tv_sec + (mtime / 1000);
+  timeout.tv_nsec = (now.tv_usec * 1000) + ((mtime % 1000) * 1000000);
+#endif
+  if (1000000000 <= timeout.tv_nsec) {
+    timeout.tv_sec++;
+    timeout.tv_nsec -= 1000000000;
+  }
+  waitResult = pthread_cond_timedwait(&cond->condID, &mutex->mutexID, &timeout);
+  return (waitResult == 0) ? true : false;
+#endif
+}
+
+/****************************************
+* uecho_cond_signal
+****************************************/
+
+bool uecho_cond_signal(uEchoCond *cond)
+{
+  if (!cond)
+    return false;
+
+#if defined(WIN32)
+  SetEvent(cond->condID);
+#else
+  pthread_cond_signal(&cond->condID);
+#endif
+
+  return true;
+}
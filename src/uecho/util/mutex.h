@@ -12,6 +12,7 @@
 #define _UECHO_UTIL_MUTEX_H_
 
 #include <uecho/typedef.h>
+#include <time.h>
 
 #if defined(WIN32)
 #include <winsock2.h>
@@ -35,6 +36,14 @@ typedef struct _uEchoMutex {
 #endif
 } uEchoMutex;
 
+typedef struct _uEchoCond {
+#if defined(WIN32)
+  HANDLE  condID;
+#else
+  pthread_cond_t condID;
+#endif
+} uEchoCond;
+
 /****************************************
  * Functions
  ****************************************/
@@ -45,6 +54,13 @@ bool uecho_mutex_delete(uEchoMutex *mutex);
 bool uecho_mutex_lock(uEchoMutex *mutex);
 bool uecho_mutex_unlock(uEchoMutex *mutex);
 
+uEchoCond *uecho_cond_new(void);
+bool uecho_cond_delete(uEchoCond *cond);
+
+bool uecho_cond_wait(uEchoCond *cond, uEchoMutex *mutex);
+bool uecho_cond_timedwait(uEchoCond *cond, uEchoMutex *mutex, clock_t mtime);
+bool uecho_cond_signal(uEchoCond *cond);
+
 #ifdef  __cplusplus
 
 } /* extern "C" */
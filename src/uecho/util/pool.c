@@ -0,0 +1,249 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <uecho/util/pool.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(WIN32)
+#include <pthread.h>
+#endif
+
+/****************************************
+ * Static
+ ****************************************/
+
+static size_t uecho_pool_maxitemcnts[uEchoPoolTypeCount] = {
+  uEchoPoolMessageDefaultMaxItemCount,
+  uEchoPoolPropertyDefaultMaxItemCount,
+  uEchoPoolDatagramPacketDefaultMaxItemCount,
+};
+
+#if !defined(WIN32)
+static pthread_key_t uecho_pool_threadkey;
+static pthread_once_t uecho_pool_threadkeyonce = PTHREAD_ONCE_INIT;
+static bool uecho_pool_isthreadkeycreated = false;
+#endif
+
+/****************************************
+ * uecho_pool_clearitems
+ ****************************************/
+
+static void uecho_pool_clearitems(uEchoPool *pool)
+{
+  size_t n;
+
+  for (n=0; n<pool->itemCnt; n++) {
+    free(pool->items[n]);
+  }
+  pool->stats.freeCnt += pool->itemCnt;
+  pool->itemCnt = 0;
+}
+
+#if !defined(WIN32)
+
+/****************************************
+ * uecho_pool_deletethreadpools
+ ****************************************/
+
+static void uecho_pool_deletethreadpools(void *data)
+{
+  uEchoPool *pools;
+  size_t n;
+
+  pools = (uEchoPool *)data;
+  if (!pools)
+    return;
+
+  for (n=0; n<uEchoPoolTypeCount; n++) {
+    uecho_pool_clearitems(&pools[n]);
+    if (pools[n].items)
+      free(pools[n].items);
+  }
+
+  free(pools);
+}
+
+/****************************************
+ * uecho_pool_createthreadkey
+ ****************************************/
+
+static void uecho_pool_createthreadkey(void)
+{
+  uecho_pool_isthreadkeycreated = (pthread_key_create(&uecho_pool_threadkey, uecho_pool_deletethreadpools) == 0) ? true : false;
+}
+
+#endif
+
+/****************************************
+ * uecho_pool_getthreadpool
+ ****************************************/
+
+static uEchoPool *uecho_pool_getthreadpool(uEchoPoolType type)
+{
+#if defined(WIN32)
+  return NULL;
+#else
+  uEchoPool *pools;
+
+  if ((type < 0) || (uEchoPoolTypeCount <= type))
+    return NULL;
+
+  pthread_once(&uecho_pool_threadkeyonce, uecho_pool_createthreadkey);
+  if (!uecho_pool_isthreadkeycreated)
+    return NULL;
+
+  // Each thread has its own pools, so they are used without any locks
+
+  pools = (uEchoPool *)pthread_getspecific(uecho_pool_threadkey);
+  if (!pools) {
+    pools = (uEchoPool *)calloc(uEchoPoolTypeCount, sizeof(uEchoPool));
+    if (!pools)
+      return NULL;
+    if (pthread_setspecific(uecho_pool_threadkey, pools) != 0) {
+      free(pools);
+      return NULL;
+    }
+  }
+
+  return &pools[type];
+#endif
+}
+
+/****************************************
+ * uecho_pool_alloc
+ ****************************************/
+
+void *uecho_pool_alloc(uEchoPoolType type, size_t itemSize)
+{
+  uEchoPool *pool;
+
+  pool = uecho_pool_getthreadpool(type);
+  if (!pool)
+    return malloc(itemSize);
+
+  if (0 < pool->itemCnt) {
+    pool->itemCnt--;
+    pool->stats.reuseCnt++;
+    return pool->items[pool->itemCnt];
+  }
+
+  pool->stats.allocCnt++;
+
+  return malloc(itemSize);
+}
+
+/****************************************
+ * uecho_pool_free
+ ****************************************/
+
+void uecho_pool_free(uEchoPoolType type, void *item)
+{
+  uEchoPool *pool;
+  void **items;
+  size_t maxItemCnt;
+
+  if (!item)
+    return;
+
+  pool = uecho_pool_getthreadpool(type);
+  if (!pool) {
+    free(item);
+    return;
+  }
+
+  maxItemCnt = uecho_pool_maxitemcnts[type];
+  if (maxItemCnt <= pool->itemCnt) {
+    free(item);
+    pool->stats.freeCnt++;
+    return;
+  }
+
+  if (pool->itemMemSize <= pool->itemCnt) {
+    items = (void **)realloc(pool->items, sizeof(void *) * maxItemCnt);
+    if (!items) {
+      free(item);
+      pool->stats.freeCnt++;
+      return;
+    }
+    pool->items = items;
+    pool->itemMemSize = maxItemCnt;
+  }
+
+  pool->items[pool->itemCnt++] = item;
+  pool->stats.releaseCnt++;
+}
+
+/****************************************
+ * uecho_pool_setmaxitemcount
+ ****************************************/
+
+bool uecho_pool_setmaxitemcount(uEchoPoolType type, size_t maxItemCnt)
+{
+  if ((type < 0) || (uEchoPoolTypeCount <= type))
+    return false;
+
+  uecho_pool_maxitemcnts[type] = maxItemCnt;
+
+  return true;
+}
+
+/****************************************
+ * uecho_pool_getmaxitemcount
+ ****************************************/
+
+size_t uecho_pool_getmaxitemcount(uEchoPoolType type)
+{
+  if ((type < 0) || (uEchoPoolTypeCount <= type))
+    return 0;
+
+  return uecho_pool_maxitemcnts[type];
+}
+
+/****************************************
+ * uecho_pool_getstats
+ ****************************************/
+
+bool uecho_pool_getstats(uEchoPoolType type, uEchoPoolStats *stats)
+{
+  uEchoPool *pool;
+
+  if (!stats)
+    return false;
+
+  memset(stats, 0, sizeof(uEchoPoolStats));
+
+  pool = uecho_pool_getthreadpool(type);
+  if (!pool)
+    return false;
+
+  memcpy(stats, &pool->stats, sizeof(uEchoPoolStats));
+  stats->itemCnt = pool->itemCnt;
+
+  return true;
+}
+
+/****************************************
+ * uecho_pool_clear
+ ****************************************/
+
+void uecho_pool_clear(void)
+{
+  uEchoPool *pool;
+  int n;
+
+  for (n=0; n<uEchoPoolTypeCount; n++) {
+    pool = uecho_pool_getthreadpool((uEchoPoolType)n);
+    if (!pool)
+      continue;
+    uecho_pool_clearitems(pool);
+  }
+}
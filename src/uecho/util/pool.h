@@ -0,0 +1,73 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#ifndef _UECHO_UTIL_POOL_H_
+#define _UECHO_UTIL_POOL_H_
+
+#include <uecho/typedef.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/****************************************
+ * Constant
+ ****************************************/
+
+typedef enum {
+  uEchoPoolMessage = 0,
+  uEchoPoolProperty,
+  uEchoPoolDatagramPacket,
+  uEchoPoolTypeCount,
+} uEchoPoolType;
+
+enum {
+  uEchoPoolMessageDefaultMaxItemCount = 16,
+  uEchoPoolPropertyDefaultMaxItemCount = 256,
+  uEchoPoolDatagramPacketDefaultMaxItemCount = 32,
+};
+
+/****************************************
+ * Data Type
+ ****************************************/
+
+typedef struct _uEchoPoolStats {
+  size_t allocCnt;
+  size_t reuseCnt;
+  size_t releaseCnt;
+  size_t freeCnt;
+  size_t itemCnt;
+} uEchoPoolStats;
+
+typedef struct _uEchoPool {
+  void **items;
+  size_t itemCnt;
+  size_t itemMemSize;
+  uEchoPoolStats stats;
+} uEchoPool;
+
+/****************************************
+ * Function
+ ****************************************/
+
+void *uecho_pool_alloc(uEchoPoolType type, size_t itemSize);
+void uecho_pool_free(uEchoPoolType type, void *item);
+
+bool uecho_pool_setmaxitemcount(uEchoPoolType type, size_t maxItemCnt);
+size_t uecho_pool_getmaxitemcount(uEchoPoolType type);
+
+bool uecho_pool_getstats(uEchoPoolType type, uEchoPoolStats *stats);
+void uecho_pool_clear(void);
+
+#ifdef  __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
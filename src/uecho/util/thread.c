@@ -8,8 +8,17 @@
  *
  ******************************************************************/
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #if !defined (WIN32)
 #include <signal.h>
+#include <unistd.h>
 #endif
 
 #include <uecho/util/thread.h>
@@ -145,21 +154,48 @@ bool uecho_thread_stop(uEchoThread *thread)
   if (!thread)
     return false;
   
-  if (thread->runnableFlag == true) {
-    thread->runnableFlag = false;
+  if (uecho_thread_signalstop(thread)) {
+    uecho_thread_waitstop();
+  }
+
+  return true;
+}
+
+/****************************************
+* uecho_thread_signalstop
+****************************************/
+
+bool uecho_thread_signalstop(uEchoThread *thread)
+{
+  if (!thread)
+    return false;
+  
+  if (thread->runnableFlag != true)
+    return false;
+  
+  thread->runnableFlag = false;
 #if defined(WIN32)
-    TerminateThread(thread->hThread, 0);
-    WaitForSingleObject(thread->hThread, INFINITE);
+  TerminateThread(thread->hThread, 0);
+  WaitForSingleObject(thread->hThread, INFINITE);
 #else
-    pthread_kill(thread->pThread, 0);
-		/* Now we wait one second for thread termination instead of using pthread_join */
-		uecho_sleep(UECHO_THREAD_MIN_SLEEP);
+  pthread_kill(thread->pThread, 0);
 #endif
-  }
 
   return true;
 }
 
+/****************************************
+* uecho_thread_waitstop
+****************************************/
+
+void uecho_thread_waitstop(void)
+{
+#if !defined(WIN32)
+  /* Now we wait one second for thread termination instead of using pthread_join */
+  uecho_sleep(UECHO_THREAD_MIN_SLEEP);
+#endif
+}
+
 /****************************************
 * uecho_thread_restart
 ****************************************/
@@ -198,6 +234,68 @@ bool uecho_thread_isrunning(uEchoThread *thread)
   return thread->runnableFlag;
 }
 
+/****************************************
+ * uecho_thread_iscurrent
+ ****************************************/
+
+bool uecho_thread_iscurrent(uEchoThread *thread)
+{
+  if (!thread)
+    return false;
+  
+  if (!thread->runnableFlag)
+    return false;
+  
+#if defined(WIN32)
+  return (GetCurrentThreadId() == thread->threadID) ? true : false;
+#else
+  return pthread_equal(pthread_self(), thread->pThread) ? true : false;
+#endif
+}
+
+/****************************************
+ * uecho_thread_setcpuaffinity
+ ****************************************/
+
+bool uecho_thread_setcpuaffinity(uEchoThread *thread, int cpuNo)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP)
+  cpu_set_t cpuSet;
+  
+  if (!thread || !thread->runnableFlag)
+    return false;
+  
+  if ((cpuNo < 0) || (CPU_SETSIZE <= cpuNo))
+    return false;
+  
+  CPU_ZERO(&cpuSet);
+  CPU_SET(cpuNo, &cpuSet);
+  
+  return (pthread_setaffinity_np(thread->pThread, sizeof(cpuSet), &cpuSet) == 0) ? true : false;
+#else
+  return false;
+#endif
+}
+
+/****************************************
+ * uecho_thread_getcpucount
+ ****************************************/
+
+size_t uecho_thread_getcpucount(void)
+{
+#if defined(WIN32)
+  SYSTEM_INFO sysInfo;
+  GetSystemInfo(&sysInfo);
+  return (size_t)sysInfo.dwNumberOfProcessors;
+#else
+  long cpuCnt;
+  
+  cpuCnt = sysconf(_SC_NPROCESSORS_ONLN);
+  
+  return (0 < cpuCnt) ? (size_t)cpuCnt : 1;
+#endif
+}
+
 /****************************************
 * uecho_thread_setaction
 ****************************************/
@@ -63,9 +63,14 @@ bool uecho_thread_delete(uEchoThread *thread);
 
 bool uecho_thread_start(uEchoThread *thread);
 bool uecho_thread_stop(uEchoThread *thread);
+bool uecho_thread_signalstop(uEchoThread *thread);
+void uecho_thread_waitstop(void);
 bool uecho_thread_restart(uEchoThread *thread);
 bool uecho_thread_isrunnable(uEchoThread *thread);
 bool uecho_thread_isrunning(uEchoThread *thread);
+bool uecho_thread_iscurrent(uEchoThread *thread);
+bool uecho_thread_setcpuaffinity(uEchoThread *thread, int cpuNo);
+size_t uecho_thread_getcpucount(void);
   
 void uecho_thread_setaction(uEchoThread *thread, uEchoThreadFunc actionFunc);
 void uecho_thread_setuserdata(uEchoThread *thread, void *data);
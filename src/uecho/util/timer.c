@@ -8,6 +8,10 @@
  *
  ******************************************************************/
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include <uecho/util/timer.h>
 
 #include <limits.h>
@@ -18,6 +22,7 @@
 #else
 #include <unistd.h>
 #include <time.h>
+#include <sys/time.h>
 #endif
 
 /****************************************
@@ -56,6 +61,29 @@ clock_t uecho_getcurrentsystemtime(void)
   return (size_t)(time((time_t *)NULL));
 }
 
+/****************************************
+* uecho_getcurrentsystemmilitime
+****************************************/
+
+uEchoMiliTime uecho_getcurrentsystemmilitime(void)
+{
+#if defined(WIN32)
+  return (uEchoMiliTime)GetTickCount64();
+#elif defined(HAVE_CLOCK_MONOTONIC)
+  struct timespec now;
+  
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  
+  return ((uEchoMiliTime)now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+#else
+  struct timeval now;
+  
+  gettimeofday(&now, NULL);
+  
+  return ((uEchoMiliTime)now.tv_sec * 1000) + (now.tv_usec / 1000);
+#endif
+}
+
 /****************************************
 * uecho_random
 ****************************************/
@@ -0,0 +1,111 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <string.h>
+
+#include <uecho/util/arena.h>
+#include <uecho/message_internal.h>
+
+BOOST_AUTO_TEST_CASE(ArenaAlloc)
+{
+  const size_t arenaSize = 128;
+  
+  uEchoArena *arena = uecho_arena_new(arenaSize);
+  BOOST_CHECK(arena);
+  BOOST_CHECK_EQUAL(uecho_arena_getsize(arena), arenaSize);
+  BOOST_CHECK_EQUAL(uecho_arena_getusedsize(arena), 0);
+  
+  // Allocations are aligned and bumped inside the buffer
+  
+  byte *mem1 = (byte *)uecho_arena_alloc(arena, 3);
+  byte *mem2 = (byte *)uecho_arena_calloc(arena, 20);
+  BOOST_CHECK(mem1);
+  BOOST_CHECK(mem2);
+  BOOST_CHECK_EQUAL(((size_t)mem2 % uEchoArenaAlignment), 0);
+  BOOST_CHECK_EQUAL((mem2 - mem1), uEchoArenaAlignment);
+  BOOST_CHECK_EQUAL(uecho_arena_getusedsize(arena), (3 * uEchoArenaAlignment));
+  for (size_t n=0; n<20; n++)
+    BOOST_CHECK_EQUAL(mem2[n], 0);
+  
+  // Requests beyond the buffer overflow to the heap
+  
+  byte *mem3 = (byte *)uecho_arena_alloc(arena, arenaSize);
+  BOOST_CHECK(mem3);
+  memset(mem3, 0xFF, arenaSize);
+  BOOST_CHECK_EQUAL(uecho_arena_getoverflowcount(arena), 1);
+  BOOST_CHECK_EQUAL(uecho_arena_getusedsize(arena), (3 * uEchoArenaAlignment));
+  
+  // Reset rewinds the buffer
+  
+  uecho_arena_reset(arena);
+  BOOST_CHECK_EQUAL(uecho_arena_getusedsize(arena), 0);
+  BOOST_CHECK_EQUAL(uecho_arena_getpeaksize(arena), (3 * uEchoArenaAlignment));
+  BOOST_CHECK_EQUAL(uecho_arena_alloc(arena, 3), mem1);
+  
+  uecho_arena_delete(arena);
+}
+
+BOOST_AUTO_TEST_CASE(ArenaMessage)
+{
+  byte msgBytes[] = {uEchoEhd1, uEchoEhd2, 0x00, 0x01, 0x05, 0xFF, 0x01, 0x0E, 0xF0, 0x01, uEchoEsvReadRequest, 2, 0x80, 0x00, 0x81, 0x00};
+  byte propData[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A};
+  
+  uEchoArena *arena = uecho_arena_new(4096);
+  BOOST_CHECK(arena);
+  
+  // Parse and edit a message whose memory all comes from the arena
+  
+  uEchoMessage *msg = uecho_message_arena_new(arena);
+  BOOST_CHECK(msg);
+  BOOST_CHECK_EQUAL(uecho_message_getarena(msg), arena);
+  BOOST_CHECK(uecho_message_parse(msg, msgBytes, sizeof(msgBytes)));
+  BOOST_CHECK_EQUAL(uecho_message_getopc(msg), 2);
+  BOOST_CHECK_EQUAL(uecho_property_getarena(uecho_message_getproperty(msg, 0)), arena);
+  
+  BOOST_CHECK(uecho_message_setproperty(msg, 0x82, sizeof(propData), propData));
+  BOOST_CHECK_EQUAL(uecho_message_getopc(msg), 3);
+  uEchoProperty *prop = uecho_message_getpropertybycode(msg, 0x82);
+  BOOST_CHECK(prop);
+  BOOST_CHECK_EQUAL(uecho_property_getdatasize(prop), sizeof(propData));
+  BOOST_CHECK_EQUAL(memcmp(uecho_property_getdata(prop), propData, sizeof(propData)), 0);
+  
+  byte *bytes = uecho_message_getbytes(msg);
+  BOOST_CHECK(bytes);
+  BOOST_CHECK_EQUAL(memcmp(bytes, msgBytes, 11), 0);
+  BOOST_CHECK_EQUAL(bytes[11], 3);
+  
+  uEchoMessage *copyMsg = uecho_message_copy(msg);
+  BOOST_CHECK(copyMsg);
+  BOOST_CHECK(!uecho_message_getarena(copyMsg));
+  BOOST_CHECK(uecho_message_equals(msg, copyMsg));
+  
+  BOOST_CHECK(0 < uecho_arena_getusedsize(arena));
+  BOOST_CHECK_EQUAL(uecho_arena_getoverflowcount(arena), 0);
+  
+  BOOST_CHECK(uecho_message_delete(msg));
+  uecho_arena_reset(arena);
+  BOOST_CHECK_EQUAL(uecho_arena_getusedsize(arena), 0);
+  
+  // The copy is independent from the arena
+  
+  BOOST_CHECK_EQUAL(uecho_message_getopc(copyMsg), 3);
+  BOOST_CHECK(uecho_message_delete(copyMsg));
+  
+  // Without any arena the message is allocated normally
+  
+  msg = uecho_message_arena_new(NULL);
+  BOOST_CHECK(msg);
+  BOOST_CHECK(!uecho_message_getarena(msg));
+  BOOST_CHECK(uecho_message_delete(msg));
+  
+  uecho_arena_delete(arena);
+}
@@ -11,7 +11,9 @@
 #include <boost/test/unit_test.hpp>
 
 #include <uecho/controller_internal.h>
+#include <uecho/misc.h>
 #include <uecho/util/timer.h>
+#include <uecho/net/interface.h>
 
 #include "TestDevice.h"
 
@@ -80,6 +82,44 @@ BOOST_AUTO_TEST_CASE(ControllerUdpOption)
   uecho_controller_delete(ctrl);
 }
 
+BOOST_AUTO_TEST_CASE(ControllerUdpWorkers)
+{
+  uEchoController *ctrl = uecho_controller_new();
+  
+  BOOST_CHECK(!uecho_controller_setudpworkercount(ctrl, 0));
+  BOOST_CHECK(uecho_controller_setudpworkercount(ctrl, 2));
+  BOOST_CHECK_EQUAL(uecho_server_getudpworkercount(ctrl->node->server), 2);
+  
+  BOOST_CHECK(uecho_controller_start(ctrl));
+  BOOST_CHECK(uecho_controller_isrunning(ctrl));
+  BOOST_CHECK(uecho_controller_stop(ctrl));
+  
+  uecho_controller_delete(ctrl);
+}
+
+BOOST_AUTO_TEST_CASE(ControllerRecvBuffer)
+{
+  uEchoController *ctrl = uecho_controller_new();
+  
+  BOOST_CHECK(!uecho_controller_setrecvbuffer(ctrl, 0, 0));
+  BOOST_CHECK(!uecho_controller_setrecvbuffer(ctrl, (UECHO_NET_SOCKET_DGRAM_RECV_MAXBUFSIZE + 1), 0));
+  BOOST_CHECK(uecho_controller_setrecvbuffer(ctrl, 1500, 262144));
+  BOOST_CHECK_EQUAL(uecho_server_getrecvbuffersize(ctrl->node->server), 1500);
+  
+  BOOST_CHECK(uecho_controller_start(ctrl));
+  BOOST_CHECK(uecho_controller_isrunning(ctrl));
+  
+  uEchoUdpServer *udpServer = uecho_udp_serverlist_gets(ctrl->node->server->udpServers);
+  if (udpServer) {
+    BOOST_CHECK_EQUAL(uecho_socket_getrecvbuffersize(uecho_udp_getsocket(udpServer)), 1500);
+  }
+  BOOST_CHECK_EQUAL(uecho_controller_gettruncatedcount(ctrl), 0);
+  
+  BOOST_CHECK(uecho_controller_stop(ctrl));
+  
+  uecho_controller_delete(ctrl);
+}
+
 BOOST_AUTO_TEST_CASE(ControllerSearchAll)
 {
   // Create Controller (Disable UDP Server)
@@ -111,3 +151,213 @@ BOOST_AUTO_TEST_CASE(ControllerSearchAll)
   BOOST_CHECK(uecho_node_stop(node));
   uecho_node_delete(node);
 }
+
+BOOST_AUTO_TEST_CASE(ControllerPostRequestTable)
+{
+  uEchoController *ctrl = uecho_controller_new();
+  
+  // Register requests to the same object with different TIDs
+  
+  const char *dstAddr = "192.168.0.1";
+  const int reqCnt = uEchoControllerPostRequestTableSize * 2;
+  uEchoPostRequest *reqs[reqCnt];
+  uEchoMessage *resMsgs[reqCnt];
+  
+  for (int n=0; n<reqCnt; n++) {
+    reqs[n] = uecho_postrequest_new();
+    resMsgs[n] = uecho_message_new();
+    uecho_postrequest_settid(reqs[n], uecho_controller_getnexttid(ctrl));
+    uecho_postrequest_setesv(reqs[n], uEchoEsvReadRequest);
+    uecho_postrequest_setdestination(reqs[n], dstAddr, UECHO_TEST_OBJECTCODE);
+    uecho_postrequest_setresponsemessage(reqs[n], resMsgs[n]);
+    BOOST_CHECK(uecho_controller_addpostrequest(ctrl, reqs[n]));
+  }
+  
+  // Responses are delivered to their own requests
+  
+  uEchoMessage *msg = uecho_message_new();
+  uecho_message_setesv(msg, uEchoEsvReadResponse);
+  uecho_message_setsourceobjectcode(msg, UECHO_TEST_OBJECTCODE);
+  
+  for (int n=(reqCnt-1); 0<=n; n--) {
+    uecho_message_settid(msg, uecho_postrequest_gettid(reqs[n]));
+    uecho_message_setsourceaddress(msg, "192.168.0.2");
+    BOOST_CHECK(!uecho_controller_handlepostresponse(ctrl, msg));
+    uecho_message_setsourceaddress(msg, dstAddr);
+    uecho_message_setesv(msg, uEchoEsvReadRequest);
+    BOOST_CHECK(!uecho_controller_handlepostresponse(ctrl, msg));
+    uecho_message_setesv(msg, uEchoEsvNotification);
+    BOOST_CHECK(!uecho_controller_handlepostresponse(ctrl, msg));
+    uecho_message_setesv(msg, uEchoEsvReadResponse);
+    BOOST_CHECK(uecho_controller_handlepostresponse(ctrl, msg));
+    BOOST_CHECK(uecho_postrequest_isresponsereceived(reqs[n]));
+    BOOST_CHECK_EQUAL(uecho_message_gettid(resMsgs[n]), uecho_postrequest_gettid(reqs[n]));
+    if (0 < n) {
+      BOOST_CHECK(!uecho_postrequest_isresponsereceived(reqs[n-1]));
+    }
+  }
+  
+  // Waiting returns as soon as the response is received
+  
+  uEchoPostRequest *waitReq = uecho_postrequest_new();
+  uecho_postrequest_settid(waitReq, uecho_controller_getnexttid(ctrl));
+  BOOST_CHECK(uecho_mutex_lock(ctrl->mutex));
+  BOOST_CHECK(!uecho_postrequest_waitresponse(waitReq, ctrl->mutex, 10));
+  BOOST_CHECK(uecho_postrequest_setresponse(waitReq, msg));
+  BOOST_CHECK(uecho_postrequest_waitresponse(waitReq, ctrl->mutex, UECHO_TEST_RESPONSE_WAIT_MAX_MTIME));
+  BOOST_CHECK(uecho_mutex_unlock(ctrl->mutex));
+  uecho_postrequest_delete(waitReq);
+  
+  for (int n=0; n<reqCnt; n++) {
+    BOOST_CHECK(uecho_controller_removepostrequest(ctrl, reqs[n]));
+    uecho_postrequest_delete(reqs[n]);
+    uecho_message_delete(resMsgs[n]);
+  }
+  
+  // Responses without requests are ignored
+  
+  BOOST_CHECK(!uecho_controller_handlepostresponse(ctrl, msg));
+  
+  uecho_message_delete(msg);
+  uecho_controller_delete(ctrl);
+}
+
+typedef struct {
+  int resultCnt;
+  uEchoControllerPostResult result;
+  uEchoEsv esv;
+} uEchoTestPostResult;
+
+static void uecho_test_postresponselistener(uEchoController *ctrl, uEchoControllerPostResult result, uEchoMessage *msg, void *userData)
+{
+  uEchoTestPostResult *postResult = (uEchoTestPostResult *)userData;
+  postResult->resultCnt++;
+  postResult->result = result;
+  postResult->esv = msg ? uecho_message_getesv(msg) : 0;
+}
+
+BOOST_AUTO_TEST_CASE(ControllerPostMessageAsync)
+{
+  uEchoController *ctrl = uecho_controller_new();
+  uEchoTestPostResult postResult;
+  
+  // Error response
+  
+  uEchoPostRequest *req = uecho_postrequest_new();
+  uecho_postrequest_settid(req, uecho_controller_getnexttid(ctrl));
+  uecho_postrequest_setesv(req, uEchoEsvReadRequest);
+  uecho_postrequest_setdestination(req, "192.168.0.1", UECHO_TEST_OBJECTCODE);
+  uecho_postrequest_setresponselistener(req, uecho_test_postresponselistener, &postResult);
+  BOOST_CHECK(uecho_controller_addpostrequest(ctrl, req));
+  
+  uEchoMessage *msg = uecho_message_new();
+  uecho_message_settid(msg, uecho_postrequest_gettid(req));
+  uecho_message_setsourceaddress(msg, "192.168.0.1");
+  uecho_message_setsourceobjectcode(msg, UECHO_TEST_OBJECTCODE);
+  uecho_message_setesv(msg, uEchoEsvReadRequestError);
+  
+  memset(&postResult, 0, sizeof(postResult));
+  BOOST_CHECK(uecho_controller_handlepostresponse(ctrl, msg));
+  BOOST_CHECK_EQUAL(postResult.resultCnt, 1);
+  BOOST_CHECK_EQUAL(postResult.result, uEchoControllerPostResultErrorResponse);
+  BOOST_CHECK_EQUAL(postResult.esv, uEchoEsvReadRequestError);
+  
+  // The request is released after the notification
+  
+  BOOST_CHECK(!uecho_controller_handlepostresponse(ctrl, msg));
+  BOOST_CHECK_EQUAL(postResult.resultCnt, 1);
+  
+  uecho_message_delete(msg);
+  
+  // Timeout
+  
+  BOOST_CHECK(uecho_controller_start(ctrl));
+  uecho_controller_setpostwaitemilitime(ctrl, 100);
+  
+  uEchoNode *node = uecho_node_new();
+  uecho_node_setaddress(node, UECHO_NET_IPV4_LOOPBACK);
+  uecho_controller_addnode(ctrl, node);
+  BOOST_CHECK(uecho_node_setobject(node, UECHO_TEST_OBJECTCODE));
+  uEchoObject *obj = uecho_node_getobjectbycode(node, UECHO_TEST_OBJECTCODE);
+  BOOST_CHECK(obj);
+  
+  uEchoMessage *reqMsg = uecho_message_new();
+  uecho_message_setesv(reqMsg, uEchoEsvReadRequest);
+  uecho_message_setproperty(reqMsg, UECHO_TEST_PROPERTY_SWITCHCODE, 0, NULL);
+  
+  memset(&postResult, 0, sizeof(postResult));
+  BOOST_CHECK(uecho_controller_postmessageasync(ctrl, obj, reqMsg, uecho_test_postresponselistener, &postResult));
+  for (int n=0; n<UECHO_TEST_RESPONSE_WAIT_RETLY_CNT; n++) {
+    if (0 < postResult.resultCnt)
+      break;
+    uecho_sleep(UECHO_TEST_RESPONSE_WAIT_MAX_MTIME / UECHO_TEST_RESPONSE_WAIT_RETLY_CNT);
+  }
+  BOOST_CHECK_EQUAL(postResult.resultCnt, 1);
+  BOOST_CHECK_EQUAL(postResult.result, uEchoControllerPostResultTimeout);
+  
+  // Pending requests time out when the controller is deleted
+  
+  uecho_controller_setpostwaitemilitime(ctrl, (UECHO_TEST_RESPONSE_WAIT_MAX_MTIME * 10));
+  
+  memset(&postResult, 0, sizeof(postResult));
+  BOOST_CHECK(uecho_controller_postmessageasync(ctrl, obj, reqMsg, uecho_test_postresponselistener, &postResult));
+  BOOST_CHECK_EQUAL(postResult.resultCnt, 0);
+  
+  uecho_message_delete(reqMsg);
+  
+  BOOST_CHECK(uecho_controller_stop(ctrl));
+  uecho_controller_delete(ctrl);
+  
+  BOOST_CHECK_EQUAL(postResult.resultCnt, 1);
+  BOOST_CHECK_EQUAL(postResult.result, uEchoControllerPostResultTimeout);
+}
+
+BOOST_AUTO_TEST_CASE(ControllerObjectIndex)
+{
+  const int nodeCnt = 10;
+  const uEchoClassCode aircon = 0x0130;
+  const uEchoClassCode light = 0x0290;
+  uEchoObject *objs[nodeCnt * 2];
+  char addr[UECHO_NET_SOCKET_ADDRSTRLEN];
+  
+  uEchoController *ctrl = uecho_controller_new();
+  
+  // Objects added before and after the node is added to the controller are both indexed
+  
+  for (int n=0; n<nodeCnt; n++) {
+    uEchoNode *node = uecho_node_new();
+    snprintf(addr, sizeof(addr), "192.168.0.%d", (n + 1));
+    uecho_node_setaddress(node, addr);
+    BOOST_CHECK(uecho_node_setobject(node, ((aircon << 8) | 0x01)));
+    BOOST_CHECK(uecho_controller_addnode(ctrl, node));
+    BOOST_CHECK(uecho_node_setobject(node, ((aircon << 8) | 0x02)));
+    if ((n % 2) == 0)
+      BOOST_CHECK(uecho_node_setobject(node, ((light << 8) | 0x01)));
+  }
+  
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectsbycode(ctrl, ((aircon << 8) | 0x01), objs, (nodeCnt * 2)), nodeCnt);
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectsbycode(ctrl, ((aircon << 8) | 0x02), objs, (nodeCnt * 2)), nodeCnt);
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectsbyclasscode(ctrl, aircon, objs, (nodeCnt * 2)), (nodeCnt * 2));
+  for (int n=0; n<(nodeCnt * 2); n++) {
+    BOOST_CHECK_EQUAL(uecho_objectcode2classcode(uecho_object_getcode(objs[n])), aircon);
+  }
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectsbyclasscode(ctrl, light, NULL, 0), (nodeCnt / 2));
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectsbyclasscode(ctrl, 0x0260, NULL, 0), 0);
+  
+  uEchoObject *obj = uecho_controller_getobjectbycode(ctrl, ((light << 8) | 0x01));
+  BOOST_CHECK(obj);
+  BOOST_CHECK_EQUAL(uecho_node_getaddress(uecho_object_getparentnode(obj)), "192.168.0.1");
+  
+  // Deleted objects and changed codes are reflected
+  
+  uecho_object_delete(obj);
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectsbyclasscode(ctrl, light, NULL, 0), ((nodeCnt / 2) - 1));
+  
+  obj = uecho_controller_getobjectbycode(ctrl, ((aircon << 8) | 0x02));
+  uecho_object_setinstancecode(obj, 0x03);
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectsbycode(ctrl, ((aircon << 8) | 0x02), NULL, 0), (nodeCnt - 1));
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectbycode(ctrl, ((aircon << 8) | 0x03)), obj);
+  BOOST_CHECK_EQUAL(uecho_controller_getobjectsbyclasscode(ctrl, aircon, NULL, 0), (nodeCnt * 2));
+  
+  uecho_controller_delete(ctrl);
+}
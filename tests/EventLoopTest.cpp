@@ -0,0 +1,176 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <boost/test/unit_test.hpp>
+
+#include <uecho/const.h>
+#include <uecho/controller_internal.h>
+#include <uecho/core/event_loop.h>
+#include <uecho/net/interface.h>
+#include <uecho/util/timer.h>
+
+#include "TestDevice.h"
+
+#if defined(HAVE_EPOLL)
+
+static int uecho_test_eventloop_recvcnt = 0;
+
+static void uecho_test_eventloop_handler(uEchoEventLoopWorker *worker, void *userData)
+{
+  uEchoSocket *sock = (uEchoSocket *)userData;
+  uEchoDatagramPacket **dgmPkts = uecho_event_loop_worker_getpackets(worker);
+  
+  ssize_t dgmPktCnt = uecho_socket_recvbatch(sock, dgmPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE);
+  if (0 < dgmPktCnt)
+    uecho_test_eventloop_recvcnt += (int)dgmPktCnt;
+}
+
+BOOST_AUTO_TEST_CASE(EventLoopSockets)
+{
+  uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
+  
+  if (uecho_net_gethostinterfaces(netIfList) <= 0) {
+    uecho_net_interfacelist_delete(netIfList);
+    return;
+  }
+  
+  uEchoNetworkInterface *netIf = uecho_net_interfacelist_gets(netIfList);
+  const char *bindAddr = uecho_net_interface_getaddress(netIf);
+  const int recvPorts[] = {uEchoUdpPort + 10004, uEchoUdpPort + 10005};
+  const int recvSockCnt = sizeof(recvPorts) / sizeof(recvPorts[0]);
+  
+  uEchoEventLoop *loop = uecho_event_loop_new(2);
+  BOOST_CHECK(loop);
+  BOOST_CHECK_EQUAL(uecho_event_loop_getworkercount(loop), 2);
+  BOOST_CHECK(uecho_event_loop_start(loop));
+  BOOST_CHECK(uecho_event_loop_isrunning(loop));
+  
+  // Two sockets are serviced by the same loop
+  
+  uEchoSocket *recvSocks[recvSockCnt];
+  uEchoEventSource *sources[recvSockCnt];
+  for (int n=0; n<recvSockCnt; n++) {
+    recvSocks[n] = uecho_socket_dgram_new();
+    BOOST_CHECK(uecho_socket_bind(recvSocks[n], recvPorts[n], bindAddr, true, true));
+    sources[n] = uecho_event_loop_addsocket(loop, recvSocks[n], uecho_test_eventloop_handler, recvSocks[n]);
+    BOOST_CHECK(sources[n]);
+  }
+  BOOST_CHECK_EQUAL(uecho_event_loop_getsourcecount(loop), recvSockCnt);
+  
+  uecho_test_eventloop_recvcnt = 0;
+  
+  byte data[] = {0x10, 0x81, 0x00, 0x01};
+  uEchoSocket *sendSock = uecho_socket_dgram_new();
+  for (int n=0; n<recvSockCnt; n++) {
+    BOOST_CHECK_EQUAL(uecho_socket_sendto(sendSock, bindAddr, recvPorts[n], data, sizeof(data)), sizeof(data));
+  }
+  
+  for (int n=0; (n<UECHO_TEST_RESPONSE_WAIT_MAX_MTIME) && (uecho_test_eventloop_recvcnt < recvSockCnt); n+=10) {
+    uecho_sleep(10);
+  }
+  BOOST_CHECK_EQUAL(uecho_test_eventloop_recvcnt, recvSockCnt);
+  
+  for (int n=0; n<recvSockCnt; n++) {
+    BOOST_CHECK(uecho_event_loop_removesource(loop, sources[n]));
+    uecho_socket_delete(recvSocks[n]);
+  }
+  BOOST_CHECK_EQUAL(uecho_event_loop_getsourcecount(loop), 0);
+  
+  uecho_socket_delete(sendSock);
+  
+  BOOST_CHECK(uecho_event_loop_delete(loop));
+  
+  uecho_net_interfacelist_delete(netIfList);
+}
+
+BOOST_AUTO_TEST_CASE(EventLoopShared)
+{
+  uEchoEventLoop *loop = uecho_event_loop_acquire(0);
+  BOOST_CHECK(loop);
+  BOOST_CHECK_EQUAL(uecho_event_loop_acquire(0), loop);
+  BOOST_CHECK(uecho_event_loop_isrunning(loop));
+  
+  uecho_event_loop_release(loop);
+  uecho_event_loop_release(loop);
+  
+  BOOST_CHECK(!uecho_event_loop_setdefaultworkercount(0));
+  BOOST_CHECK(uecho_event_loop_setdefaultworkercount(uEchoEventLoopDefaultWorkerCount));
+}
+
+BOOST_AUTO_TEST_CASE(EventLoopWorkerCount)
+{
+  const size_t workerCnt = 3;
+  
+  uEchoController *ctrl = uecho_controller_new();
+  uecho_controller_disableudpserver(ctrl);
+  uecho_controller_enableeventloop(ctrl);
+  BOOST_CHECK(!uecho_controller_seteventloopworkercount(ctrl, 0));
+  BOOST_CHECK(!uecho_controller_seteventloopworkercount(ctrl, (uEchoEventLoopMaxWorkerCount + 1)));
+  BOOST_CHECK(uecho_controller_seteventloopworkercount(ctrl, workerCnt));
+  BOOST_CHECK(uecho_controller_start(ctrl));
+  
+  // The shared loop is created with the count of the first server using it
+  
+  uEchoEventLoop *loop = uecho_server_geteventloop(ctrl->node->server);
+  BOOST_CHECK(loop);
+  BOOST_CHECK_EQUAL(uecho_event_loop_getworkercount(loop), workerCnt);
+  BOOST_CHECK(uecho_event_loop_isrunning(loop));
+  
+  uEchoNode *node = uecho_test_createtestnode();
+  uecho_node_enableeventloop(node);
+  BOOST_CHECK(uecho_node_seteventloopworkercount(node, 1));
+  BOOST_CHECK(uecho_node_start(node));
+  BOOST_CHECK_EQUAL(uecho_server_geteventloop(node->server), loop);
+  BOOST_CHECK_EQUAL(uecho_event_loop_getworkercount(loop), workerCnt);
+  
+  BOOST_CHECK(uecho_node_stop(node));
+  uecho_node_delete(node);
+  
+  BOOST_CHECK(uecho_controller_stop(ctrl));
+  uecho_controller_delete(ctrl);
+}
+
+BOOST_AUTO_TEST_CASE(EventLoopControllerSearch)
+{
+  // Run both the controller and the device node on the shared event loop
+  
+  uEchoController *ctrl = uecho_controller_new();
+  uecho_controller_disableudpserver(ctrl);
+  uecho_controller_enableeventloop(ctrl);
+  BOOST_CHECK(uecho_controller_iseventloopenabled(ctrl));
+  BOOST_CHECK(uecho_controller_start(ctrl));
+  BOOST_CHECK(uecho_controller_isrunning(ctrl));
+  
+  uEchoNode *node = uecho_test_createtestnode();
+  uecho_node_enableeventloop(node);
+  BOOST_CHECK(uecho_node_start(node));
+  
+  uEchoEventLoop *loop = uecho_server_geteventloop(ctrl->node->server);
+  BOOST_CHECK(loop);
+  BOOST_CHECK_EQUAL(uecho_server_geteventloop(node->server), loop);
+  
+  BOOST_CHECK(uecho_controller_searchallobjectswithesv(ctrl, uEchoEsvNotificationRequest));
+  
+  uEchoObject *foundObj = uecho_controller_getobjectbycodewithwait(ctrl, UECHO_TEST_OBJECTCODE, UECHO_TEST_RESPONSE_WAIT_MAX_MTIME);
+  BOOST_CHECK(foundObj);
+  
+  BOOST_CHECK(uecho_controller_stop(ctrl));
+  uecho_controller_delete(ctrl);
+  
+  BOOST_CHECK(uecho_node_stop(node));
+  BOOST_CHECK(!uecho_server_geteventloop(node->server));
+  uecho_node_delete(node);
+}
+
+#endif
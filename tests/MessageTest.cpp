@@ -117,6 +117,70 @@ BOOST_AUTO_TEST_CASE(MessageRequest)
   
   uecho_message_delete(msg);
 }
+
+BOOST_AUTO_TEST_CASE(MessageRequestView)
+{
+  uEchoMessage *msg = uecho_message_new();
+  
+  byte msgBytes[] = {
+    uEchoEhd1,
+    uEchoEhd2,
+    0x00, 0x00,
+    0xA0, 0xB0, 0xC0,
+    0xD0, 0xE0, 0xF0,
+    uEchoEsvReadRequest,
+    3,
+    1, 1, 'a',
+    2, 2, 'b', 'c',
+    3, 3, 'c', 'd', 'e',
+  };
+  
+  BOOST_CHECK(uecho_message_parseview(msg, msgBytes, sizeof(msgBytes)));
+  
+  BOOST_CHECK_EQUAL(uecho_message_gettid(msg), 0);
+  BOOST_CHECK_EQUAL(uecho_message_getsourceobjectcode(msg), 0xA0B0C0);
+  BOOST_CHECK_EQUAL(uecho_message_getdestinationobjectcode(msg), 0xD0E0F0);
+  BOOST_CHECK_EQUAL(uecho_message_getesv(msg), uEchoEsvReadRequest);
+  BOOST_CHECK_EQUAL(uecho_message_getopc(msg), 3);
+  
+  uEchoProperty *firstProp = uecho_message_getproperty(msg, 0);
+  BOOST_CHECK_EQUAL(uecho_property_getdata(firstProp), (msgBytes + 14));
+  
+  for (int n=1; n<=uecho_message_getopc(msg); n++) {
+    uEchoProperty *prop = uecho_message_getproperty(msg, (n-1));
+    BOOST_CHECK(prop);
+    BOOST_CHECK(uecho_property_isdataview(prop));
+    BOOST_CHECK_EQUAL(uecho_property_getcode(prop), n);
+    BOOST_CHECK_EQUAL(uecho_property_getdatasize(prop), n);
+    byte *data = uecho_property_getdata(prop);
+    BOOST_CHECK(data);
+    for (int i=0; i<uecho_property_getdatasize(prop); i++) {
+      BOOST_CHECK_EQUAL(data[i], 'a' + (n-1) + i);
+    }
+  }
+  
+  // Reparse reuses the former properties
+  
+  msgBytes[11] = 1;
+  BOOST_CHECK(uecho_message_parseview(msg, msgBytes, (uEchoMessageMinLen + 3)));
+  BOOST_CHECK_EQUAL(uecho_message_getopc(msg), 1);
+  BOOST_CHECK_EQUAL(uecho_message_getproperty(msg, 0), firstProp);
+  
+  // Copied messages own their property data
+  
+  uEchoMessage *copyMsg = uecho_message_copy(msg);
+  uEchoProperty *copyProp = uecho_message_getproperty(copyMsg, 0);
+  BOOST_CHECK(!uecho_property_isdataview(copyProp));
+  BOOST_CHECK(uecho_property_getdata(copyProp) != uecho_property_getdata(firstProp));
+  BOOST_CHECK(uecho_message_equals(msg, copyMsg));
+  uecho_message_delete(copyMsg);
+  
+  BOOST_CHECK(uecho_message_addproperty(msg, uecho_property_new()));
+  BOOST_CHECK_EQUAL(uecho_message_getopc(msg), 2);
+  
+  uecho_message_delete(msg);
+}
+
 BOOST_AUTO_TEST_CASE(MessageEsvType)
 {
   uEchoMessage *msg = uecho_message_new();
@@ -221,3 +285,105 @@ BOOST_AUTO_TEST_CASE(MessageSearch)
   
   uecho_message_delete(msg);
 }
+
+BOOST_AUTO_TEST_CASE(MessageSourceSocketAddress)
+{
+  const char *TEST_ADDR = "192.168.0.1";
+  
+  uEchoSocketAddress sockAddr;
+  BOOST_CHECK(uecho_socket_address_setstring(&sockAddr, TEST_ADDR));
+  BOOST_CHECK(uecho_socket_address_isvalid(&sockAddr));
+  
+  char addr[UECHO_NET_SOCKET_ADDRSTRLEN];
+  BOOST_CHECK(uecho_socket_address_tostring(&sockAddr, addr, sizeof(addr)));
+  BOOST_CHECK_EQUAL(addr, TEST_ADDR);
+  
+  uEchoSocketAddress otherSockAddr;
+  BOOST_CHECK(uecho_socket_address_setstring(&otherSockAddr, "192.168.0.2"));
+  BOOST_CHECK(!uecho_socket_address_equals(&sockAddr, &otherSockAddr));
+  BOOST_CHECK(!uecho_socket_address_setstring(&otherSockAddr, "not-an-address"));
+  BOOST_CHECK(!uecho_socket_address_isvalid(&otherSockAddr));
+  
+  // The source address string is formatted on demand
+  
+  uEchoMessage *msg = uecho_message_new();
+  BOOST_CHECK(!uecho_message_getsourceaddress(msg));
+  
+  uecho_message_setsourcesocketaddress(msg, &sockAddr);
+  BOOST_CHECK(uecho_socket_address_equals(uecho_message_getsourcesocketaddress(msg), &sockAddr));
+  BOOST_CHECK(uecho_message_issourceaddress(msg, TEST_ADDR));
+  BOOST_CHECK(!uecho_message_issourceaddress(msg, "192.168.0.2"));
+  BOOST_CHECK_EQUAL(uecho_message_getsourceaddress(msg), TEST_ADDR);
+  
+  uEchoMessage *copyMsg = uecho_message_copy(msg);
+  BOOST_CHECK(uecho_socket_address_equals(uecho_message_getsourcesocketaddress(copyMsg), &sockAddr));
+  uecho_message_delete(copyMsg);
+  
+  uecho_message_setsourceaddress(msg, "192.168.0.2");
+  BOOST_CHECK(uecho_socket_address_setstring(&otherSockAddr, "192.168.0.2"));
+  BOOST_CHECK(uecho_socket_address_equals(uecho_message_getsourcesocketaddress(msg), &otherSockAddr));
+  BOOST_CHECK_EQUAL(uecho_message_getsourceaddress(msg), "192.168.0.2");
+  
+  uecho_message_delete(msg);
+}
+
+BOOST_AUTO_TEST_CASE(MessageWriteBytes)
+{
+  byte propData[] = {0x30, 0x31, 0x32};
+  
+  uEchoMessage *msg = uecho_message_new();
+  uecho_message_settid(msg, 0x1234);
+  uecho_message_setesv(msg, uEchoEsvReadResponse);
+  uecho_message_setsourceobjectcode(msg, 0x0EF001);
+  uecho_message_setdestinationobjectcode(msg, 0x05FF01);
+  for (int n=0; n<3; n++) {
+    uEchoProperty *prop = uecho_property_new();
+    uecho_property_setcode(prop, (0x80 + n));
+    uecho_property_setdata(prop, propData, n);
+    BOOST_CHECK(uecho_message_addproperty(msg, prop));
+  }
+  
+  size_t msgLen = uecho_message_size(msg);
+  BOOST_CHECK_EQUAL(msgLen, (size_t)(uEchoMessageMinLen + (2 * 3) + (0 + 1 + 2)));
+  
+  // Caller buffer
+  
+  byte msgBytes[128];
+  BOOST_CHECK_EQUAL(uecho_message_writebytes(msg, msgBytes, (msgLen - 1)), 0);
+  BOOST_CHECK_EQUAL(uecho_message_writebytes(msg, msgBytes, sizeof(msgBytes)), msgLen);
+  BOOST_CHECK(memcmp(msgBytes, uecho_message_getbytes(msg), msgLen) == 0);
+  BOOST_CHECK_EQUAL(msgBytes[uEchoMessageMinLen], 0x80);
+  BOOST_CHECK_EQUAL(msgBytes[uEchoMessageMinLen + 1], 0);
+  
+  // Scatter/gather vectors
+  
+  byte hdrBuf[64];
+  struct iovec iovs[16];
+  size_t iovCnt = uecho_message_getiovecs(msg, hdrBuf, sizeof(hdrBuf), iovs, 16);
+  BOOST_CHECK_EQUAL(iovCnt, 4);
+  BOOST_CHECK(iovCnt <= uecho_message_getiovecmaxcount(msg));
+  BOOST_CHECK_EQUAL(iovs[0].iov_len, (size_t)(uEchoMessageMinLen + 2 + 2));
+  BOOST_CHECK_EQUAL(iovs[1].iov_base, uecho_property_getdata(uecho_message_getproperty(msg, 1)));
+  
+  byte iovBytes[128];
+  size_t iovBytesLen = 0;
+  for (size_t n=0; n<iovCnt; n++) {
+    memcpy((iovBytes + iovBytesLen), iovs[n].iov_base, iovs[n].iov_len);
+    iovBytesLen += iovs[n].iov_len;
+  }
+  BOOST_CHECK_EQUAL(iovBytesLen, msgLen);
+  BOOST_CHECK(memcmp(iovBytes, msgBytes, msgLen) == 0);
+  
+  BOOST_CHECK_EQUAL(uecho_message_getiovecs(msg, hdrBuf, (uecho_message_getiovecheadersize(msg) - 1), iovs, 16), 0);
+  BOOST_CHECK_EQUAL(uecho_message_getiovecs(msg, hdrBuf, sizeof(hdrBuf), iovs, 2), 0);
+  
+  // Comparison
+  
+  uEchoMessage *copyMsg = uecho_message_copy(msg);
+  BOOST_CHECK(uecho_message_equals(msg, copyMsg));
+  uecho_property_setdata(uecho_message_getproperty(copyMsg, 2), propData, 1);
+  BOOST_CHECK(!uecho_message_equals(msg, copyMsg));
+  uecho_message_delete(copyMsg);
+  
+  uecho_message_delete(msg);
+}
@@ -11,6 +11,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include <uecho/util/mutex.h>
+#include <uecho/util/thread.h>
+#include <uecho/util/timer.h>
 
 BOOST_AUTO_TEST_CASE(MutexText)
 {
@@ -19,3 +21,40 @@ BOOST_AUTO_TEST_CASE(MutexText)
   BOOST_CHECK_EQUAL(uecho_mutex_unlock(mutex), true);
   uecho_mutex_delete(mutex);
 }
+
+static void uecho_test_condsignalaction(uEchoThread *thread)
+{
+  uEchoCond *cond = (uEchoCond *)uecho_thread_getuserdata(thread);
+  uecho_sleep(100);
+  uecho_cond_signal(cond);
+}
+
+BOOST_AUTO_TEST_CASE(CondText)
+{
+  uEchoMutex *mutex = uecho_mutex_new();
+  uEchoCond *cond = uecho_cond_new();
+  BOOST_CHECK(cond);
+  
+  // Timeout without any signal
+  
+  BOOST_CHECK(uecho_mutex_lock(mutex));
+  BOOST_CHECK_EQUAL(uecho_cond_timedwait(cond, mutex, 100), false);
+  BOOST_CHECK(uecho_mutex_unlock(mutex));
+  
+  // Wakeup by a signal from other thread
+  
+  uEchoThread *thread = uecho_thread_new();
+  uecho_thread_setaction(thread, uecho_test_condsignalaction);
+  uecho_thread_setuserdata(thread, cond);
+  
+  BOOST_CHECK(uecho_mutex_lock(mutex));
+  BOOST_CHECK(uecho_thread_start(thread));
+  BOOST_CHECK_EQUAL(uecho_cond_timedwait(cond, mutex, 5000), true);
+  BOOST_CHECK(uecho_mutex_unlock(mutex));
+  
+  uecho_thread_stop(thread);
+  uecho_thread_delete(thread);
+  
+  uecho_cond_delete(cond);
+  uecho_mutex_delete(mutex);
+}
@@ -28,3 +28,62 @@ BOOST_AUTO_TEST_CASE(NodeListAdd)
   
   uecho_nodelist_delete(nodes);
 }
+
+BOOST_AUTO_TEST_CASE(NodeIndexAddress)
+{
+  const int nodeCnt = 300;
+  char addr[UECHO_NET_SOCKET_ADDRSTRLEN];
+  
+  uEchoNodeList *nodes = uecho_nodelist_new();
+  uEchoNodeIndex *index = uecho_nodeindex_new();
+  
+  for (int n=0; n<nodeCnt; n++) {
+    uEchoNode *node = uecho_node_new();
+    snprintf(addr, sizeof(addr), "192.168.%d.%d", (n / 256), (n % 256));
+    uecho_node_setaddress(node, addr);
+    BOOST_CHECK(uecho_nodelist_add(nodes, node));
+    BOOST_CHECK(uecho_nodeindex_add(index, node));
+  }
+  BOOST_CHECK_EQUAL(uecho_nodeindex_size(index), nodeCnt);
+  
+  // Nodes without an address are not indexed
+  
+  uEchoNode *noAddrNode = uecho_node_new();
+  BOOST_CHECK(!uecho_nodeindex_add(index, noAddrNode));
+  uecho_node_delete(noAddrNode);
+  
+  for (uEchoNode *node = uecho_nodelist_gets(nodes); node; node = uecho_node_next(node)) {
+    BOOST_CHECK_EQUAL(uecho_nodeindex_getbysocketaddress(index, uecho_node_getsocketaddress(node)), node);
+  }
+  
+  uEchoSocketAddress sockAddr;
+  BOOST_CHECK(uecho_socket_address_setstring(&sockAddr, "10.0.0.1"));
+  BOOST_CHECK(!uecho_nodeindex_getbysocketaddress(index, &sockAddr));
+  
+  // Remove every other node and check that the others are still found
+  
+  int removedCnt = 0;
+  bool isRemoved = false;
+  for (uEchoNode *node = uecho_nodelist_gets(nodes); node; node = uecho_node_next(node)) {
+    if (isRemoved) {
+      BOOST_CHECK(uecho_nodeindex_remove(index, node));
+      BOOST_CHECK(!uecho_nodeindex_getbysocketaddress(index, uecho_node_getsocketaddress(node)));
+      removedCnt++;
+    }
+    isRemoved = !isRemoved;
+  }
+  BOOST_CHECK_EQUAL(uecho_nodeindex_size(index), (nodeCnt - removedCnt));
+  
+  isRemoved = false;
+  for (uEchoNode *node = uecho_nodelist_gets(nodes); node; node = uecho_node_next(node)) {
+    if (!isRemoved)
+      BOOST_CHECK_EQUAL(uecho_nodeindex_getbysocketaddress(index, uecho_node_getsocketaddress(node)), node);
+    isRemoved = !isRemoved;
+  }
+  
+  uecho_nodeindex_clear(index);
+  BOOST_CHECK_EQUAL(uecho_nodeindex_size(index), 0);
+  
+  uecho_nodeindex_delete(index);
+  uecho_nodelist_delete(nodes);
+}
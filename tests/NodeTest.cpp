@@ -9,7 +9,7 @@
  ******************************************************************/
 
 #include <boost/test/unit_test.hpp>
-#include <uecho/node.h>
+#include <uecho/node_internal.h>
 #include <uecho/profile.h>
 
 BOOST_AUTO_TEST_CASE(NodeDefault)
@@ -118,3 +118,120 @@ BOOST_AUTO_TEST_CASE(NodeProfileClass)
   
   uecho_node_delete(node);
 }
+
+BOOST_AUTO_TEST_CASE(NodeObjectIndex)
+{
+  const int objCnt = 100;
+  const uEchoObjectCode baseCode = 0x001100;
+  
+  uEchoNode *node = uecho_node_new();
+  BOOST_CHECK(node);
+  
+  for (int n=1; n<=objCnt; n++) {
+    BOOST_CHECK(uecho_node_setobject(node, (baseCode + n)));
+  }
+  BOOST_CHECK_EQUAL(uecho_node_getobjectcount(node), (objCnt + 1));
+  
+  for (int n=1; n<=objCnt; n++) {
+    uEchoObject *obj = uecho_node_getobjectbycode(node, (baseCode + n));
+    BOOST_CHECK(obj);
+    BOOST_CHECK_EQUAL(uecho_object_getcode(obj), (baseCode + n));
+  }
+  BOOST_CHECK(!uecho_node_getobjectbycode(node, (baseCode + objCnt + 1)));
+  
+  // Changing the code of an added object updates the index
+  
+  uEchoObject *obj = uecho_node_getobjectbycode(node, (baseCode + 1));
+  uecho_object_setinstancecode(obj, 0xF0);
+  BOOST_CHECK(!uecho_node_getobjectbycode(node, (baseCode + 1)));
+  BOOST_CHECK_EQUAL(uecho_node_getobjectbycode(node, (baseCode + 0xF0)), obj);
+  
+  // Deleting an added object removes it from the index
+  
+  uecho_object_delete(obj);
+  BOOST_CHECK(!uecho_node_getobjectbycode(node, (baseCode + 0xF0)));
+  BOOST_CHECK_EQUAL(uecho_node_getobjectcount(node), objCnt);
+  BOOST_CHECK(uecho_node_getobjectbycode(node, (baseCode + 2)));
+  
+  uecho_node_clear(node);
+  BOOST_CHECK(!uecho_node_getobjectbycode(node, (baseCode + 2)));
+  
+  uecho_node_delete(node);
+}
+
+BOOST_AUTO_TEST_CASE(NodeRemote)
+{
+  const char *TEST_ADDR = "192.168.0.1";
+  const uEchoObjectCode TEST_OBJCODE = 0x001101;
+  byte TEST_PROPDATA[] = {0x30};
+
+  uEchoNode *node = uecho_node_remote_new();
+  BOOST_CHECK(node);
+  BOOST_CHECK(uecho_node_isremote(node));
+  BOOST_CHECK(!uecho_node_getserver(node));
+  BOOST_CHECK_EQUAL(uecho_node_getobjectcount(node), 0);
+  
+  uecho_node_setaddress(node, TEST_ADDR);
+  BOOST_CHECK(uecho_node_isaddress(node, TEST_ADDR));
+  BOOST_CHECK(!uecho_node_isaddress(node, "192.168.0.2"));
+  
+  // Remote objects have only the cached properties
+  
+  BOOST_CHECK(uecho_node_setobject(node, TEST_OBJCODE));
+  BOOST_CHECK(uecho_node_setobject(node, uEchoNodeProfileObject));
+  BOOST_CHECK_EQUAL(uecho_node_getobjectcount(node), 2);
+  
+  uEchoObject *obj = uecho_node_getobjectbycode(node, TEST_OBJCODE);
+  BOOST_CHECK(obj);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertycount(obj), 0);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertycount(uecho_node_getobjectbycode(node, uEchoNodeProfileObject)), 0);
+  
+  BOOST_CHECK(uecho_object_setproperty(obj, 0x80, uEchoPropertyAttrNone));
+  BOOST_CHECK(uecho_object_setpropertydata(obj, 0x80, TEST_PROPDATA, sizeof(TEST_PROPDATA)));
+  BOOST_CHECK(uecho_object_hasproperty(obj, 0x80));
+  
+  BOOST_CHECK(!uecho_node_start(node));
+  BOOST_CHECK(!uecho_node_isrunning(node));
+  
+  uecho_node_delete(node);
+  
+  node = uecho_node_new();
+  BOOST_CHECK(!uecho_node_isremote(node));
+  uecho_node_delete(node);
+}
+
+BOOST_AUTO_TEST_CASE(NodeRemotePropertyCache)
+{
+  const uEchoObjectCode TEST_OBJCODE = 0x001101;
+  byte propData[] = {0x30, 0x31};
+  byte propMapData[] = {0x02, 0x80, 0x9F};
+  
+  uEchoNode *node = uecho_node_remote_new();
+  BOOST_CHECK(uecho_node_setobject(node, TEST_OBJCODE));
+  uEchoObject *obj = uecho_node_getobjectbycode(node, TEST_OBJCODE);
+  BOOST_CHECK(obj);
+  
+  // Cached properties do not generate local property maps
+  
+  for (int n=0; n<32; n++) {
+    BOOST_CHECK(uecho_object_cachepropertydata(obj, (0xE0 + n), propData, sizeof(propData)));
+  }
+  BOOST_CHECK_EQUAL(uecho_object_getpropertycount(obj), 32);
+  BOOST_CHECK(!uecho_object_hasproperty(obj, uEchoProfileGetPropertyMap));
+  
+  // Updating a cached property keeps the property
+  
+  uEchoProperty *prop = uecho_object_getproperty(obj, 0xE0);
+  BOOST_CHECK(uecho_object_cachepropertydata(obj, 0xE0, propData, 1));
+  BOOST_CHECK_EQUAL(uecho_object_getproperty(obj, 0xE0), prop);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydatasize(obj, 0xE0), 1);
+  BOOST_CHECK_EQUAL(uecho_property_getattribute(prop), uEchoPropertyAttrNone);
+  
+  // Property maps of remote objects are the values learned from the devices
+  
+  BOOST_CHECK(uecho_object_cachepropertydata(obj, uEchoProfileGetPropertyMap, propMapData, sizeof(propMapData)));
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydatasize(obj, uEchoProfileGetPropertyMap), sizeof(propMapData));
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydata(obj, uEchoProfileGetPropertyMap)[2], 0x9F);
+  
+  uecho_node_delete(node);
+}
@@ -10,8 +10,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <uecho/object_internal.h>
 #include <uecho/node.h>
-#include <uecho/object.h>
 #include <uecho/profile.h>
 
 BOOST_AUTO_TEST_CASE(ObjectNew)
@@ -100,6 +100,74 @@ BOOST_AUTO_TEST_CASE(ObjectSetProperty)
   uecho_object_delete(obj);
 }
 
+BOOST_AUTO_TEST_CASE(ObjectPropertyIndex)
+{
+  uEchoObject *obj = uecho_object_new();
+  
+  uecho_object_clearproperties(obj);
+  BOOST_CHECK(!uecho_object_getproperty(obj, uEchoPropertyCodeMin));
+  
+  // Reading a missing property does not add it
+  
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydatasize(obj, uEchoPropertyCodeMin), 0);
+  BOOST_CHECK(!uecho_object_getpropertydata(obj, uEchoPropertyCodeMin));
+  BOOST_CHECK_EQUAL(uecho_object_getpropertycount(obj), 0);
+  
+  BOOST_CHECK(uecho_object_setpropertybytedata(obj, uEchoPropertyCodeMin, 0x30));
+  uEchoProperty *prop = uecho_object_getproperty(obj, uEchoPropertyCodeMin);
+  BOOST_CHECK(prop);
+  BOOST_CHECK(uecho_object_hasproperty(obj, uEchoPropertyCodeMin));
+  
+  // Setting the same code again updates the indexed property
+  
+  BOOST_CHECK(uecho_object_setpropertybytedata(obj, uEchoPropertyCodeMin, 0x31));
+  BOOST_CHECK_EQUAL(uecho_object_getproperty(obj, uEchoPropertyCodeMin), prop);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertycount(obj), 1);
+  
+  byte data;
+  BOOST_CHECK(uecho_object_getpropertybytedata(obj, uEchoPropertyCodeMin, &data));
+  BOOST_CHECK_EQUAL(data, 0x31);
+  
+  uecho_object_clearproperties(obj);
+  BOOST_CHECK(!uecho_object_getproperty(obj, uEchoPropertyCodeMin));
+  BOOST_CHECK(!uecho_object_hasproperty(obj, uEchoPropertyCodeMin));
+  
+  uecho_object_delete(obj);
+}
+
+BOOST_AUTO_TEST_CASE(ObjectPropertyIndexDeleteAndRecode)
+{
+  uEchoObject *obj = uecho_object_new();
+  
+  // Deleting a property clears its index slot, and the released property is not found by its old code
+  
+  BOOST_CHECK(uecho_object_setpropertybytedata(obj, 0xB0, 0x30));
+  BOOST_CHECK(uecho_property_delete(uecho_object_getproperty(obj, 0xB0)));
+  BOOST_CHECK(!uecho_object_getproperty(obj, 0xB0));
+  
+  uEchoProperty *other = uecho_property_new();
+  uecho_property_setcode(other, 0x80);
+  BOOST_CHECK(!uecho_object_getproperty(obj, 0xB0));
+  uecho_property_delete(other);
+  
+  // Changing the code moves the index slot
+  
+  BOOST_CHECK(uecho_object_setpropertybytedata(obj, 0xB1, 0x31));
+  uEchoProperty *prop = uecho_object_getproperty(obj, 0xB1);
+  BOOST_CHECK(prop);
+  uecho_property_setcode(prop, 0xB2);
+  BOOST_CHECK(!uecho_object_getproperty(obj, 0xB1));
+  BOOST_CHECK_EQUAL(uecho_object_getproperty(obj, 0xB2), prop);
+  
+  // Removing a property from the object clears its slot too
+  
+  uecho_property_remove(prop);
+  BOOST_CHECK(!uecho_object_getproperty(obj, 0xB2));
+  uecho_property_delete(prop);
+  
+  uecho_object_delete(obj);
+}
+
 BOOST_AUTO_TEST_CASE(ObjectMandatoryProperties)
 {
   uEchoObject *obj = uecho_object_new();
@@ -113,3 +181,120 @@ BOOST_AUTO_TEST_CASE(ObjectMandatoryProperties)
   
   uecho_object_delete(obj);
 }
+
+BOOST_AUTO_TEST_CASE(ObjectPropertyMaps)
+{
+  uEchoObject *obj = uecho_object_new();
+  
+  // Property code list (Manufacturer code and property maps)
+  
+  BOOST_CHECK(uecho_object_setproperty(obj, 0x80, uEchoPropertyAttrReadWrite));
+  
+  byte *propMap = uecho_object_getpropertydata(obj, uEchoProfileGetPropertyMap);
+  BOOST_CHECK(propMap);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydatasize(obj, uEchoProfileGetPropertyMap), 6);
+  BOOST_CHECK_EQUAL(propMap[0], 5);
+  BOOST_CHECK_EQUAL(propMap[1], 0x80);
+  
+  propMap = uecho_object_getpropertydata(obj, uEchoProfileSetPropertyMap);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydatasize(obj, uEchoProfileSetPropertyMap), 2);
+  BOOST_CHECK_EQUAL(propMap[0], 1);
+  BOOST_CHECK_EQUAL(propMap[1], 0x80);
+  
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydatasize(obj, uEchoProfileAnnoPropertyMap), 1);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydata(obj, uEchoProfileAnnoPropertyMap)[0], 0);
+  
+  // Bitmap (16 or more properties)
+  
+  for (int n=0; n<16; n++) {
+    BOOST_CHECK(uecho_object_setproperty(obj, (0xE0 + n), uEchoPropertyAttrRead));
+  }
+  
+  propMap = uecho_object_getpropertydata(obj, uEchoProfileGetPropertyMap);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydatasize(obj, uEchoProfileGetPropertyMap), (uEchoPropertyMapMaxLen + 1));
+  BOOST_CHECK_EQUAL(propMap[0], 21);
+  BOOST_CHECK_EQUAL(propMap[1 + 0x00], 0x41); /* 0x80, 0xE0 */
+  BOOST_CHECK_EQUAL(propMap[1 + 0x0A], 0x41); /* 0x8A, 0xEA */
+  BOOST_CHECK_EQUAL(propMap[1 + 0x0D], 0x42); /* 0x9D, 0xED */
+  BOOST_CHECK_EQUAL(propMap[1 + 0x0F], 0x42); /* 0x9F, 0xEF */
+  
+  // Changing the attribute updates the maps
+  
+  BOOST_CHECK(uecho_object_setpropertyattribute(obj, 0x80, uEchoPropertyAttrNone));
+  propMap = uecho_object_getpropertydata(obj, uEchoProfileGetPropertyMap);
+  BOOST_CHECK_EQUAL(propMap[0], 20);
+  BOOST_CHECK_EQUAL(propMap[1 + 0x00], 0x40);
+  BOOST_CHECK_EQUAL(uecho_object_getpropertydata(obj, uEchoProfileSetPropertyMap)[0], 0);
+  
+  // The maps are serialized when they change, so the receive threads only read them
+  
+  propMap = uecho_object_getpropertydata(obj, uEchoProfileGetPropertyMap);
+  BOOST_CHECK(propMap == uecho_object_getpropertydata(obj, uEchoProfileGetPropertyMap));
+  
+  uecho_object_delete(obj);
+}
+
+BOOST_AUTO_TEST_CASE(ObjectWriteResponseMessage)
+{
+  uEchoObject *obj = uecho_object_new();
+  uecho_object_setcode(obj, 0x001101);
+  
+  byte readData[] = {0x12, 0x34};
+  byte writeData[] = {0x56};
+  byte smallData[] = {0x78};
+  
+  BOOST_CHECK(uecho_object_setproperty(obj, 0xE0, uEchoPropertyAttrRead));
+  BOOST_CHECK(uecho_object_setpropertydata(obj, 0xE0, readData, sizeof(readData)));
+  BOOST_CHECK(uecho_object_setproperty(obj, 0xE1, uEchoPropertyAttrWrite));
+  BOOST_CHECK(uecho_object_setpropertydata(obj, 0xE1, writeData, sizeof(writeData)));
+  BOOST_CHECK(uecho_object_setproperty(obj, 0xE2, uEchoPropertyAttrRead));
+  BOOST_CHECK(uecho_object_setpropertydata(obj, 0xE2, smallData, sizeof(smallData)));
+  
+  // Get request (0xE1 is unreadable and 0xE3 is missing)
+  
+  uEchoMessage *reqMsg = uecho_message_new();
+  BOOST_CHECK(uecho_message_settid(reqMsg, 0x1234));
+  BOOST_CHECK(uecho_message_setsourceobjectcode(reqMsg, 0x05FF01));
+  BOOST_CHECK(uecho_message_setdestinationobjectcode(reqMsg, 0x001101));
+  BOOST_CHECK(uecho_message_setesv(reqMsg, uEchoEsvReadRequest));
+  BOOST_CHECK(uecho_message_setproperty(reqMsg, 0xE0, 0, NULL));
+  BOOST_CHECK(uecho_message_setproperty(reqMsg, 0xE1, 0, NULL));
+  BOOST_CHECK(uecho_message_setproperty(reqMsg, 0xE3, 0, NULL));
+  BOOST_CHECK(uecho_message_setproperty(reqMsg, 0xE2, 0, NULL));
+  
+  byte buf[uEchoMessageFrameMaxLen];
+  size_t resLen = uecho_object_writeresponsemessage(obj, reqMsg, uEchoEsvReadResponse, buf, sizeof(buf));
+  BOOST_CHECK_EQUAL(resLen, (size_t)(uEchoMessageMinLen + (2 + 2) + (2 + 1)));
+  
+  uEchoMessage *resMsg = uecho_message_new();
+  BOOST_CHECK(uecho_message_parse(resMsg, buf, resLen));
+  BOOST_CHECK_EQUAL(uecho_message_getehd1(resMsg), uEchoEhd1);
+  BOOST_CHECK_EQUAL(uecho_message_getehd2(resMsg), uEchoEhd2);
+  BOOST_CHECK_EQUAL(uecho_message_gettid(resMsg), 0x1234);
+  BOOST_CHECK_EQUAL(uecho_message_getsourceobjectcode(resMsg), 0x001101);
+  BOOST_CHECK_EQUAL(uecho_message_getdestinationobjectcode(resMsg), 0x05FF01);
+  BOOST_CHECK_EQUAL(uecho_message_getesv(resMsg), uEchoEsvReadResponse);
+  BOOST_CHECK_EQUAL(uecho_message_getopc(resMsg), 2);
+  
+  uEchoProperty *resProp = uecho_message_getproperty(resMsg, 0);
+  BOOST_CHECK_EQUAL(uecho_property_getcode(resProp), 0xE0);
+  BOOST_CHECK_EQUAL(uecho_property_getdatasize(resProp), sizeof(readData));
+  BOOST_CHECK_EQUAL(uecho_property_getdata(resProp)[0], readData[0]);
+  BOOST_CHECK_EQUAL(uecho_property_getdata(resProp)[1], readData[1]);
+  
+  resProp = uecho_message_getproperty(resMsg, 1);
+  BOOST_CHECK_EQUAL(uecho_property_getcode(resProp), 0xE2);
+  BOOST_CHECK_EQUAL(uecho_property_getdatasize(resProp), sizeof(smallData));
+  BOOST_CHECK_EQUAL(uecho_property_getdata(resProp)[0], smallData[0]);
+  
+  // Nothing is written when the readable properties don't fit in bufLen
+  
+  BOOST_CHECK_EQUAL(uecho_object_writeresponsemessage(obj, reqMsg, uEchoEsvReadResponse, buf, (resLen - 1)), 0);
+  BOOST_CHECK_EQUAL(uecho_object_writeresponsemessage(obj, reqMsg, uEchoEsvReadResponse, buf, (uEchoMessageMinLen + (2 + 2) + 2)), 0);
+  BOOST_CHECK_EQUAL(uecho_object_writeresponsemessage(obj, reqMsg, uEchoEsvReadResponse, buf, uEchoMessageMinLen), 0);
+  BOOST_CHECK_EQUAL(uecho_object_writeresponsemessage(obj, reqMsg, uEchoEsvReadResponse, buf, (uEchoMessageMinLen - 1)), 0);
+  
+  uecho_message_delete(resMsg);
+  uecho_message_delete(reqMsg);
+  uecho_object_delete(obj);
+}
@@ -0,0 +1,119 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <uecho/util/pool.h>
+#include <uecho/util/thread.h>
+#include <uecho/util/timer.h>
+#include <uecho/message_internal.h>
+
+BOOST_AUTO_TEST_CASE(PoolReuse)
+{
+  uEchoPoolStats stats;
+  
+  uecho_pool_clear();
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolProperty, &stats));
+  BOOST_CHECK_EQUAL(stats.itemCnt, 0);
+  size_t reuseCnt = stats.reuseCnt;
+  
+  // A deleted property is reused by the next new one on the same thread
+  
+  uEchoProperty *prop = uecho_property_new();
+  uecho_property_delete(prop);
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolProperty, &stats));
+  BOOST_CHECK_EQUAL(stats.itemCnt, 1);
+  
+  BOOST_CHECK_EQUAL(uecho_property_new(), prop);
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolProperty, &stats));
+  BOOST_CHECK_EQUAL(stats.itemCnt, 0);
+  BOOST_CHECK_EQUAL(stats.reuseCnt, (reuseCnt + 1));
+  uecho_property_delete(prop);
+  
+  // Messages and their properties
+  
+  uEchoMessage *msg = uecho_message_new();
+  BOOST_CHECK(uecho_message_setopc(msg, 3));
+  uecho_message_delete(msg);
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolMessage, &stats));
+  BOOST_CHECK_EQUAL(stats.itemCnt, 1);
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolProperty, &stats));
+  BOOST_CHECK_EQUAL(stats.itemCnt, 3);
+  
+  uecho_pool_clear();
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolProperty, &stats));
+  BOOST_CHECK_EQUAL(stats.itemCnt, 0);
+}
+
+BOOST_AUTO_TEST_CASE(PoolMaxItemCount)
+{
+  const size_t maxItemCnt = 2;
+  const size_t pktCnt = 5;
+  uEchoPoolStats stats;
+  
+  size_t defaultMaxItemCnt = uecho_pool_getmaxitemcount(uEchoPoolDatagramPacket);
+  BOOST_CHECK_EQUAL(defaultMaxItemCnt, uEchoPoolDatagramPacketDefaultMaxItemCount);
+  BOOST_CHECK(uecho_pool_setmaxitemcount(uEchoPoolDatagramPacket, maxItemCnt));
+  BOOST_CHECK(!uecho_pool_setmaxitemcount(uEchoPoolTypeCount, maxItemCnt));
+  
+  uecho_pool_clear();
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolDatagramPacket, &stats));
+  size_t freeCnt = stats.freeCnt;
+  
+  uEchoDatagramPacket *dgmPkts[pktCnt];
+  for (size_t n=0; n<pktCnt; n++)
+    dgmPkts[n] = uecho_socket_datagram_packet_new();
+  for (size_t n=0; n<pktCnt; n++)
+    uecho_socket_datagram_packet_delete(dgmPkts[n]);
+  
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolDatagramPacket, &stats));
+  BOOST_CHECK_EQUAL(stats.itemCnt, maxItemCnt);
+  BOOST_CHECK_EQUAL(stats.freeCnt, (freeCnt + (pktCnt - maxItemCnt)));
+  
+  BOOST_CHECK(uecho_pool_setmaxitemcount(uEchoPoolDatagramPacket, defaultMaxItemCnt));
+  uecho_pool_clear();
+}
+
+static void uecho_test_poolaction(uEchoThread *thread)
+{
+  uEchoPoolStats *stats = (uEchoPoolStats *)uecho_thread_getuserdata(thread);
+  for (int n=0; n<10; n++) {
+    uecho_message_delete(uecho_message_new());
+  }
+  uecho_pool_getstats(uEchoPoolMessage, stats);
+}
+
+BOOST_AUTO_TEST_CASE(PoolThread)
+{
+  uEchoPoolStats stats, threadStats;
+  
+  uecho_pool_clear();
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolMessage, &stats));
+  
+  // Each thread has own pools
+  
+  memset(&threadStats, 0, sizeof(threadStats));
+  uEchoThread *thread = uecho_thread_new();
+  uecho_thread_setaction(thread, uecho_test_poolaction);
+  uecho_thread_setuserdata(thread, &threadStats);
+  BOOST_CHECK(uecho_thread_start(thread));
+  uecho_sleep(100);
+  BOOST_CHECK(uecho_thread_stop(thread));
+  uecho_thread_delete(thread);
+  
+  BOOST_CHECK_EQUAL(threadStats.allocCnt, 1);
+  BOOST_CHECK_EQUAL(threadStats.reuseCnt, 9);
+  BOOST_CHECK_EQUAL(threadStats.itemCnt, 1);
+  
+  uEchoPoolStats currStats;
+  BOOST_CHECK(uecho_pool_getstats(uEchoPoolMessage, &currStats));
+  BOOST_CHECK_EQUAL(currStats.allocCnt, stats.allocCnt);
+  BOOST_CHECK_EQUAL(currStats.itemCnt, 0);
+}
@@ -173,3 +173,47 @@ BOOST_AUTO_TEST_CASE(PropertyAddData)
   BOOST_CHECK(uecho_property_delete(prop));
 }
 
+
+BOOST_AUTO_TEST_CASE(PropertyInlineData)
+{
+  byte data[uEchoPropertyInlineDataSize * 2];
+  for (size_t n=0; n<sizeof(data); n++)
+    data[n] = (byte)n;
+  
+  uEchoProperty *prop = uecho_property_new();
+  
+  // Small data are stored inline
+  
+  BOOST_CHECK(uecho_property_setdata(prop, data, uEchoPropertyInlineDataSize));
+  BOOST_CHECK(uecho_property_isinlinedata(prop));
+  BOOST_CHECK(memcmp(uecho_property_getdata(prop), data, uEchoPropertyInlineDataSize) == 0);
+  
+  // Growing beyond the inline storage spills to the heap
+  
+  BOOST_CHECK(uecho_property_adddata(prop, (data + uEchoPropertyInlineDataSize), uEchoPropertyInlineDataSize));
+  BOOST_CHECK(!uecho_property_isinlinedata(prop));
+  BOOST_CHECK_EQUAL(uecho_property_getdatasize(prop), sizeof(data));
+  BOOST_CHECK(memcmp(uecho_property_getdata(prop), data, sizeof(data)) == 0);
+  
+  // Shrinking returns to the inline storage
+  
+  BOOST_CHECK(uecho_property_setintegerdata(prop, 0x1234, 2));
+  BOOST_CHECK(uecho_property_isinlinedata(prop));
+  int intData;
+  BOOST_CHECK(uecho_property_getintegerdata(prop, 2, &intData));
+  BOOST_CHECK_EQUAL(intData, 0x1234);
+  
+  // Copies of views are owned
+  
+  BOOST_CHECK(uecho_property_setdataview(prop, data, 2));
+  BOOST_CHECK(uecho_property_addbytedata(prop, 0xFF));
+  BOOST_CHECK(!uecho_property_isdataview(prop));
+  BOOST_CHECK(uecho_property_isinlinedata(prop));
+  BOOST_CHECK_EQUAL(uecho_property_getdata(prop)[1], data[1]);
+  BOOST_CHECK_EQUAL(uecho_property_getdata(prop)[2], 0xFF);
+  
+  BOOST_CHECK(uecho_property_cleardata(prop));
+  BOOST_CHECK(!uecho_property_getdata(prop));
+  
+  BOOST_CHECK(uecho_property_delete(prop));
+}
@@ -11,6 +11,8 @@
 #include <boost/test/unit_test.hpp>
 #include <uecho/core/server.h>
 #include <uecho/net/interface.h>
+#include <uecho/const_internal.h>
+#include <uecho/util/timer.h>
 
 BOOST_AUTO_TEST_CASE(ServerTest)
 {
@@ -50,6 +52,66 @@ BOOST_AUTO_TEST_CASE(UdpServerTest)
   uecho_net_interfacelist_delete(netIfList);
 }
 
+static int uecho_test_udpworkerreceivedcnt = 0;
+
+static void uecho_test_udpworkerlistener(uEchoUdpServer *server, uEchoMessage *msg)
+{
+  __sync_fetch_and_add(&uecho_test_udpworkerreceivedcnt, 1);
+}
+
+BOOST_AUTO_TEST_CASE(UdpServerWorkerTest)
+{
+  const int msgCnt = 32;
+  byte msg[] = {0x10, 0x81, 0x00, 0x01, 0x05, 0xFF, 0x01, 0x0E, 0xF0, 0x01, 0x62, 0x01, 0x80, 0x00};
+  
+  uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
+  
+  if (uecho_net_gethostinterfaces(netIfList) <= 0) {
+    uecho_net_interfacelist_delete(netIfList);
+    return;
+  }
+  
+  uEchoNetworkInterface *netIf = uecho_net_interfacelist_gets(netIfList);
+  const char *bindAddr = uecho_net_interface_getaddress(netIf);
+  
+  uEchoUdpServer *server = uecho_udp_server_new();
+  BOOST_CHECK(server);
+  
+  BOOST_CHECK(!uecho_udp_server_setworkercount(server, 0));
+  BOOST_CHECK(!uecho_udp_server_setworkercount(server, (uEchoUdpServerMaxWorkerCount + 1)));
+  BOOST_CHECK(uecho_udp_server_setworkercount(server, 3));
+  BOOST_CHECK_EQUAL(uecho_udp_server_getworkercount(server), 3);
+  
+  BOOST_CHECK(uecho_udp_server_open(server, bindAddr));
+  BOOST_CHECK_EQUAL(uecho_udp_server_getshardcount(server), 2);
+  
+  uecho_udp_server_setmessagelistener(server, uecho_test_udpworkerlistener);
+  BOOST_CHECK(uecho_udp_server_start(server));
+  BOOST_CHECK(uecho_udp_server_isrunning(server));
+  
+  // Send from different sockets to spread the datagrams over the workers
+  
+  uecho_test_udpworkerreceivedcnt = 0;
+  for (int n=0; n<msgCnt; n++) {
+    uEchoSocket *sock = uecho_socket_dgram_new();
+    BOOST_CHECK_EQUAL(uecho_socket_sendto(sock, bindAddr, uEchoUdpPort, msg, sizeof(msg)), sizeof(msg));
+    uecho_socket_close(sock);
+    uecho_socket_delete(sock);
+  }
+  
+  for (int n=0; n<uEchoWaitRetryCount; n++) {
+    if (msgCnt <= __sync_fetch_and_add(&uecho_test_udpworkerreceivedcnt, 0))
+      break;
+    uecho_sleep(100);
+  }
+  BOOST_CHECK_EQUAL(__sync_fetch_and_add(&uecho_test_udpworkerreceivedcnt, 0), msgCnt);
+  
+  BOOST_CHECK(uecho_udp_server_stop(server));
+  BOOST_CHECK(uecho_udp_server_delete(server));
+  
+  uecho_net_interfacelist_delete(netIfList);
+}
+
 BOOST_AUTO_TEST_CASE(McastServerTest)
 {
   uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
@@ -89,6 +151,29 @@ BOOST_AUTO_TEST_CASE(UdpServerListTest)
   uecho_udp_serverlist_delete(servers);
 }
 
+BOOST_AUTO_TEST_CASE(UdpServerListPostTest)
+{
+  uEchoUdpServerList *servers = uecho_udp_serverlist_new();
+  
+  BOOST_CHECK(servers);
+  BOOST_CHECK(uecho_udp_serverlist_open(servers));
+  
+  uEchoUdpServer *server = uecho_udp_serverlist_gets(servers);
+  BOOST_CHECK(server);
+  if (!server) {
+    uecho_udp_serverlist_delete(servers);
+    return;
+  }
+  
+  const char *bindAddr = uecho_socket_getaddress(uecho_udp_getsocket(server));
+  BOOST_CHECK_EQUAL(uecho_udp_serverlist_selectserver(servers, bindAddr), server);
+  
+  byte msg[] = {0x10, 0x81, 0x00, 0x00};
+  BOOST_CHECK(uecho_udp_serverlist_post(servers, bindAddr, msg, sizeof(msg)));
+  
+  uecho_udp_serverlist_delete(servers);
+}
+
 BOOST_AUTO_TEST_CASE(McastServerListTest)
 {
   uEchoMcastServerList *servers = uecho_mcast_serverlist_new();
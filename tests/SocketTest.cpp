@@ -44,3 +44,293 @@ BOOST_AUTO_TEST_CASE(BindAddr)
   
   uecho_net_interfacelist_delete(netIfList);
 }
+
+BOOST_AUTO_TEST_CASE(DatagramBatchRecv)
+{
+  uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
+  
+  if (uecho_net_gethostinterfaces(netIfList) <= 0) {
+    uecho_net_interfacelist_delete(netIfList);
+    return;
+  }
+  
+  uEchoNetworkInterface *netIf = uecho_net_interfacelist_gets(netIfList);
+  const char *bindAddr = uecho_net_interface_getaddress(netIf);
+  const int bindPort = uEchoUdpPort + 10000;
+  
+  uEchoSocket *recvSock = uecho_socket_dgram_new();
+  BOOST_CHECK(uecho_socket_bind(recvSock, bindPort, bindAddr, true, true));
+  BOOST_CHECK(uecho_socket_settimeout(recvSock, 1));
+  
+  // Send datagrams
+  
+  const int sendCnt = 3;
+  uEchoSocket *sendSock = uecho_socket_dgram_new();
+  for (int n=0; n<sendCnt; n++) {
+    byte data[] = {(byte)n, (byte)n, (byte)n};
+    BOOST_CHECK_EQUAL(uecho_socket_sendto(sendSock, bindAddr, bindPort, data, (n + 1)), (size_t)(n + 1));
+  }
+  
+  // Receive datagrams in batches
+  
+  uEchoDatagramPacket *dgmPkts[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  for (int n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    dgmPkts[n] = uecho_socket_datagram_packet_new();
+  }
+  
+  int recvCnt = 0;
+  while (recvCnt < sendCnt) {
+    ssize_t batchCnt = uecho_socket_recvbatch(recvSock, dgmPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE);
+    BOOST_CHECK(0 < batchCnt);
+    if (batchCnt <= 0)
+      break;
+    for (int n=0; n<batchCnt; n++) {
+      BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getlength(dgmPkts[n]), (size_t)(recvCnt + 1));
+      BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getdata(dgmPkts[n])[0], recvCnt);
+      BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getremoteaddress(dgmPkts[n]), bindAddr);
+      recvCnt++;
+    }
+  }
+  BOOST_CHECK_EQUAL(recvCnt, sendCnt);
+  
+  for (int n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    uecho_socket_datagram_packet_delete(dgmPkts[n]);
+  }
+  
+  uecho_socket_delete(sendSock);
+  uecho_socket_delete(recvSock);
+  
+  uecho_net_interfacelist_delete(netIfList);
+}
+
+BOOST_AUTO_TEST_CASE(DatagramQueueFlush)
+{
+  uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
+  
+  if (uecho_net_gethostinterfaces(netIfList) <= 0) {
+    uecho_net_interfacelist_delete(netIfList);
+    return;
+  }
+  
+  uEchoNetworkInterface *netIf = uecho_net_interfacelist_gets(netIfList);
+  const char *bindAddr = uecho_net_interface_getaddress(netIf);
+  const int recvPort = uEchoUdpPort + 10001;
+  const int sendPort = uEchoUdpPort + 10002;
+  
+  uEchoSocket *recvSock = uecho_socket_dgram_new();
+  BOOST_CHECK(uecho_socket_bind(recvSock, recvPort, bindAddr, true, true));
+  BOOST_CHECK(uecho_socket_settimeout(recvSock, 1));
+  
+  uEchoSocket *sendSock = uecho_socket_dgram_new();
+  BOOST_CHECK(uecho_socket_bind(sendSock, sendPort, bindAddr, true, true));
+  
+  // Queue datagrams until the queue reports back-pressure
+  
+  const int queueSize = 3;
+  uEchoDatagramQueue *queue = uecho_socket_datagram_queue_new(queueSize);
+  BOOST_CHECK(queue);
+  
+  for (int n=0; n<queueSize; n++) {
+    byte data[] = {(byte)n, (byte)n, (byte)n};
+    BOOST_CHECK(!uecho_socket_datagram_queue_isfull(queue));
+    BOOST_CHECK(uecho_socket_datagram_queue_add(queue, bindAddr, recvPort, data, (n + 1)));
+  }
+  BOOST_CHECK_EQUAL(uecho_socket_datagram_queue_size(queue), (size_t)queueSize);
+  BOOST_CHECK(uecho_socket_datagram_queue_isfull(queue));
+  
+  byte overflowData[] = {0xFF};
+  BOOST_CHECK(!uecho_socket_datagram_queue_add(queue, bindAddr, recvPort, overflowData, sizeof(overflowData)));
+  
+  // Flush the queued datagrams
+  
+  BOOST_CHECK(uecho_socket_datagram_queue_flush(queue, sendSock));
+  BOOST_CHECK_EQUAL(uecho_socket_datagram_queue_size(queue), (size_t)0);
+  
+  uEchoDatagramPacket *dgmPkt = uecho_socket_datagram_packet_new();
+  for (int n=0; n<queueSize; n++) {
+    BOOST_CHECK_EQUAL(uecho_socket_recv(recvSock, dgmPkt), (ssize_t)(n + 1));
+    BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getdata(dgmPkt)[0], n);
+    BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getremoteport(dgmPkt), sendPort);
+  }
+  uecho_socket_datagram_packet_delete(dgmPkt);
+  
+  uecho_socket_datagram_queue_delete(queue);
+  uecho_socket_delete(sendSock);
+  uecho_socket_delete(recvSock);
+  
+  uecho_net_interfacelist_delete(netIfList);
+}
+
+BOOST_AUTO_TEST_CASE(SocketSendMsg)
+{
+  uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
+  
+  if (uecho_net_gethostinterfaces(netIfList) <= 0) {
+    uecho_net_interfacelist_delete(netIfList);
+    return;
+  }
+  
+  uEchoNetworkInterface *netIf = uecho_net_interfacelist_gets(netIfList);
+  const char *bindAddr = uecho_net_interface_getaddress(netIf);
+  const int recvPort = uEchoUdpPort + 10003;
+  
+  uEchoSocket *recvSock = uecho_socket_dgram_new();
+  BOOST_CHECK(uecho_socket_bind(recvSock, recvPort, bindAddr, true, true));
+  BOOST_CHECK(uecho_socket_settimeout(recvSock, 1));
+  
+  byte hdr[] = {0x10, 0x81};
+  byte data[] = {0x30, 0x31, 0x32};
+  struct iovec iovs[2];
+  iovs[0].iov_base = hdr;
+  iovs[0].iov_len = sizeof(hdr);
+  iovs[1].iov_base = data;
+  iovs[1].iov_len = sizeof(data);
+  
+  uEchoSocket *sendSock = uecho_socket_dgram_new();
+  BOOST_CHECK_EQUAL(uecho_socket_sendmsg(sendSock, bindAddr, recvPort, iovs, 2), (ssize_t)(sizeof(hdr) + sizeof(data)));
+  
+  uEchoDatagramPacket *dgmPkt = uecho_socket_datagram_packet_new();
+  BOOST_CHECK_EQUAL(uecho_socket_recv(recvSock, dgmPkt), (ssize_t)(sizeof(hdr) + sizeof(data)));
+  BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getdata(dgmPkt)[1], 0x81);
+  BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getdata(dgmPkt)[4], 0x32);
+  uecho_socket_datagram_packet_delete(dgmPkt);
+  
+  uecho_socket_delete(sendSock);
+  uecho_socket_delete(recvSock);
+  
+  uecho_net_interfacelist_delete(netIfList);
+}
+
+BOOST_AUTO_TEST_CASE(SocketDestination)
+{
+  uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
+  
+  if (uecho_net_gethostinterfaces(netIfList) <= 0) {
+    uecho_net_interfacelist_delete(netIfList);
+    return;
+  }
+  
+  uEchoNetworkInterface *netIf = uecho_net_interfacelist_gets(netIfList);
+  const char *bindAddr = uecho_net_interface_getaddress(netIf);
+  const int recvPort = uEchoUdpPort + 10008;
+  
+  // Resolve the destination once and reuse it from the cache
+  
+  uecho_socket_addresscache_clear();
+  
+  uEchoSocketDestination dest;
+  BOOST_CHECK(uecho_socket_destination_set(&dest, bindAddr, recvPort));
+  BOOST_CHECK(uecho_socket_destination_set(&dest, bindAddr, recvPort));
+  BOOST_CHECK_EQUAL(uecho_socket_addresscache_size(), 1);
+  BOOST_CHECK_EQUAL(uecho_socket_addresscache_getmisscount(), 1);
+  BOOST_CHECK_EQUAL(uecho_socket_addresscache_gethitcount(), 1);
+  
+  // The least recently used entries are replaced when the cache is full
+  
+  uEchoSocketDestination otherDest;
+  for (int n=1; n<=UECHO_NET_SOCKET_ADDRCACHE_SIZE; n++) {
+    BOOST_CHECK(uecho_socket_destination_set(&otherDest, bindAddr, recvPort + n));
+  }
+  BOOST_CHECK_EQUAL(uecho_socket_addresscache_size(), UECHO_NET_SOCKET_ADDRCACHE_SIZE);
+  BOOST_CHECK(uecho_socket_destination_set(&otherDest, bindAddr, recvPort + UECHO_NET_SOCKET_ADDRCACHE_SIZE));
+  BOOST_CHECK_EQUAL(uecho_socket_addresscache_gethitcount(), 2);
+  
+  // Send to the resolved destination
+  
+  uEchoSocket *recvSock = uecho_socket_dgram_new();
+  BOOST_CHECK(uecho_socket_bind(recvSock, recvPort, bindAddr, true, true));
+  BOOST_CHECK(uecho_socket_settimeout(recvSock, 1));
+  
+  byte data[] = {0x10, 0x81, 0x00, 0x01};
+  uEchoSocket *sendSock = uecho_socket_dgram_new();
+  BOOST_CHECK_EQUAL(uecho_socket_sendtodestination(sendSock, &dest, NULL, sizeof(data)), 0);
+  BOOST_CHECK_EQUAL(uecho_socket_sendtodestination(sendSock, &dest, data, 0), 0);
+  BOOST_CHECK_EQUAL(uecho_socket_sendtodestination(sendSock, &dest, data, sizeof(data)), (ssize_t)sizeof(data));
+  BOOST_CHECK_EQUAL(uecho_socket_sendto(sendSock, bindAddr, recvPort, data, sizeof(data)), sizeof(data));
+  
+  uEchoDatagramPacket *dgmPkt = uecho_socket_datagram_packet_new();
+  for (int n=0; n<2; n++) {
+    BOOST_CHECK_EQUAL(uecho_socket_recv(recvSock, dgmPkt), (ssize_t)sizeof(data));
+    BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getdata(dgmPkt)[3], 0x01);
+  }
+  uecho_socket_datagram_packet_delete(dgmPkt);
+  
+  uecho_socket_delete(sendSock);
+  uecho_socket_delete(recvSock);
+  
+  uecho_net_interfacelist_delete(netIfList);
+}
+
+BOOST_AUTO_TEST_CASE(SocketRecvBufferSize)
+{
+  uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
+  
+  if (uecho_net_gethostinterfaces(netIfList) <= 0) {
+    uecho_net_interfacelist_delete(netIfList);
+    return;
+  }
+  
+  uEchoNetworkInterface *netIf = uecho_net_interfacelist_gets(netIfList);
+  const char *bindAddr = uecho_net_interface_getaddress(netIf);
+  const int recvPort = uEchoUdpPort + 10009;
+  
+  uEchoSocket *recvSock = uecho_socket_dgram_new();
+  BOOST_CHECK_EQUAL(uecho_socket_getrecvbuffersize(recvSock), UECHO_NET_SOCKET_DGRAM_RECV_BUFSIZE);
+  BOOST_CHECK(!uecho_socket_setrecvbuffersize(recvSock, 0));
+  BOOST_CHECK(!uecho_socket_setrecvbuffersize(recvSock, UECHO_NET_SOCKET_DGRAM_RECV_MAXBUFSIZE + 1));
+  BOOST_CHECK(!uecho_socket_setrecvqueuesize(recvSock, 65536));
+  
+  BOOST_CHECK(uecho_socket_bind(recvSock, recvPort, bindAddr, true, true));
+  BOOST_CHECK(uecho_socket_settimeout(recvSock, 1));
+  BOOST_CHECK(uecho_socket_setrecvqueuesize(recvSock, 65536));
+  BOOST_CHECK(65536 <= uecho_socket_getrecvqueuesize(recvSock));
+  
+  uEchoSocket *sendSock = uecho_socket_dgram_new();
+  uEchoDatagramPacket *dgmPkt = uecho_socket_datagram_packet_new();
+  byte largeData[1024];
+  byte smallData[] = {0x10, 0x81, 0x00, 0x01};
+  memset(largeData, 0x10, sizeof(largeData));
+  
+  // A datagram larger than the buffer is dropped and counted
+  
+  BOOST_CHECK(uecho_socket_setrecvbuffersize(recvSock, sizeof(smallData)));
+  BOOST_CHECK_EQUAL(uecho_socket_sendto(sendSock, bindAddr, recvPort, largeData, sizeof(largeData)), sizeof(largeData));
+  BOOST_CHECK_EQUAL(uecho_socket_recv(recvSock, dgmPkt), 0);
+  BOOST_CHECK_EQUAL(uecho_socket_gettruncatedcount(recvSock), 1);
+  
+  // The batch receive drops it too and keeps the following datagrams
+  
+  BOOST_CHECK_EQUAL(uecho_socket_sendto(sendSock, bindAddr, recvPort, largeData, sizeof(largeData)), sizeof(largeData));
+  BOOST_CHECK_EQUAL(uecho_socket_sendto(sendSock, bindAddr, recvPort, smallData, sizeof(smallData)), sizeof(smallData));
+  
+  uEchoDatagramPacket *dgmPkts[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  for (int n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    dgmPkts[n] = uecho_socket_datagram_packet_new();
+  }
+  
+  ssize_t recvCnt = 0;
+  for (int n=0; (n<2) && (recvCnt <= 0); n++) {
+    recvCnt = uecho_socket_recvbatch(recvSock, dgmPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE);
+  }
+  BOOST_CHECK_EQUAL(recvCnt, 1);
+  BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getlength(dgmPkts[0]), sizeof(smallData));
+  BOOST_CHECK_EQUAL(uecho_socket_gettruncatedcount(recvSock), 2);
+  
+  for (int n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    uecho_socket_datagram_packet_delete(dgmPkts[n]);
+  }
+  
+  // A larger buffer receives the whole datagram
+  
+  BOOST_CHECK(uecho_socket_setrecvbuffersize(recvSock, sizeof(largeData)));
+  BOOST_CHECK_EQUAL(uecho_socket_sendto(sendSock, bindAddr, recvPort, largeData, sizeof(largeData)), sizeof(largeData));
+  BOOST_CHECK_EQUAL(uecho_socket_recv(recvSock, dgmPkt), (ssize_t)sizeof(largeData));
+  BOOST_CHECK_EQUAL(uecho_socket_gettruncatedcount(recvSock), 2);
+  
+  uecho_socket_datagram_packet_delete(dgmPkt);
+  
+  uecho_socket_delete(sendSock);
+  uecho_socket_delete(recvSock);
+  
+  uecho_net_interfacelist_delete(netIfList);
+}
@@ -0,0 +1,130 @@
+/******************************************************************
+ *
+ * uEcho for C
+ *
+ * Copyright (C) Satoshi Konno 2015
+ *
+ * This is licensed under BSD-style license, see file COPYING.
+ *
+ ******************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <uecho/const.h>
+#include <uecho/const_internal.h>
+#include <uecho/controller_internal.h>
+#include <uecho/net/interface.h>
+#include <uecho/net/uring.h>
+
+#include "TestDevice.h"
+
+BOOST_AUTO_TEST_CASE(UringSocketBatch)
+{
+  // The ring is optional, the servers use the socket functions when it is not available
+  
+  if (!uecho_uring_isavailable()) {
+    BOOST_CHECK_EQUAL(uecho_uring_recvbatch(NULL, NULL, NULL, 0, 0), -1);
+    return;
+  }
+  
+  uEchoNetworkInterfaceList *netIfList = uecho_net_interfacelist_new();
+  
+  if (uecho_net_gethostinterfaces(netIfList) <= 0) {
+    uecho_net_interfacelist_delete(netIfList);
+    return;
+  }
+  
+  uEchoNetworkInterface *netIf = uecho_net_interfacelist_gets(netIfList);
+  const char *bindAddr = uecho_net_interface_getaddress(netIf);
+  const int recvPort = uEchoUdpPort + 10006;
+  const int sendPort = uEchoUdpPort + 10007;
+  const int pktCnt = 4;
+  
+  uEchoUring *recvRing = uecho_uring_new(uEchoUringDefaultEntryCount);
+  uEchoUring *sendRing = uecho_uring_new(uEchoUringDefaultEntryCount);
+  BOOST_CHECK(recvRing);
+  BOOST_CHECK(sendRing);
+  
+  uEchoSocket *recvSock = uecho_socket_dgram_new();
+  uEchoSocket *sendSock = uecho_socket_dgram_new();
+  BOOST_CHECK(uecho_socket_bind(recvSock, recvPort, bindAddr, true, true));
+  BOOST_CHECK(uecho_socket_bind(sendSock, sendPort, bindAddr, true, true));
+  
+  // Send a batch with a single submission
+  
+  uEchoDatagramPacket *sendPkts[pktCnt];
+  for (int n=0; n<pktCnt; n++) {
+    byte data[] = {0x10, 0x81, 0x00, (byte)n};
+    sendPkts[n] = uecho_socket_datagram_packet_new();
+    uecho_socket_datagram_packet_setdata(sendPkts[n], data, sizeof(data));
+    uecho_socket_datagram_packet_setremoteaddress(sendPkts[n], bindAddr);
+    uecho_socket_datagram_packet_setremoteport(sendPkts[n], recvPort);
+  }
+  BOOST_CHECK_EQUAL(uecho_uring_sendbatch(sendRing, sendSock, sendPkts, pktCnt), pktCnt);
+  
+  // Receive them through the multishot receive
+  
+  uEchoDatagramPacket *recvPkts[UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE];
+  for (int n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    recvPkts[n] = uecho_socket_datagram_packet_new();
+  }
+  
+  int recvCnt = 0;
+  for (int n=0; (n<uEchoWaitRetryCount) && (recvCnt < pktCnt); n++) {
+    ssize_t batchCnt = uecho_uring_recvbatch(recvRing, recvSock, recvPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE, 100);
+    BOOST_CHECK(0 <= batchCnt);
+    for (int i=0; i<batchCnt; i++) {
+      BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getlength(recvPkts[i]), 4);
+      BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getdata(recvPkts[i])[3], (byte)(recvCnt + i));
+      BOOST_CHECK_EQUAL(uecho_socket_datagram_packet_getremoteport(recvPkts[i]), sendPort);
+    }
+    recvCnt += (int)batchCnt;
+  }
+  BOOST_CHECK_EQUAL(recvCnt, pktCnt);
+  
+  // A timeout returns no datagrams
+  
+  BOOST_CHECK_EQUAL(uecho_uring_recvbatch(recvRing, recvSock, recvPkts, UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE, 10), 0);
+  
+  for (int n=0; n<pktCnt; n++) {
+    uecho_socket_datagram_packet_delete(sendPkts[n]);
+  }
+  for (int n=0; n<UECHO_NET_SOCKET_DGRAM_RECV_BATCHSIZE; n++) {
+    uecho_socket_datagram_packet_delete(recvPkts[n]);
+  }
+  
+  uecho_uring_delete(recvRing);
+  uecho_uring_delete(sendRing);
+  
+  uecho_socket_delete(recvSock);
+  uecho_socket_delete(sendSock);
+  
+  uecho_net_interfacelist_delete(netIfList);
+}
+
+BOOST_AUTO_TEST_CASE(UringControllerSearch)
+{
+  // Run both the controller and the device node with the io_uring option
+  
+  uEchoController *ctrl = uecho_controller_new();
+  uecho_controller_enableuring(ctrl);
+  BOOST_CHECK(uecho_controller_isuringenabled(ctrl));
+  BOOST_CHECK(uecho_controller_start(ctrl));
+  BOOST_CHECK(uecho_controller_isrunning(ctrl));
+  
+  uEchoNode *node = uecho_test_createtestnode();
+  uecho_node_enableuring(node);
+  BOOST_CHECK(uecho_server_isuringenabled(node->server));
+  BOOST_CHECK(uecho_node_start(node));
+  
+  BOOST_CHECK(uecho_controller_searchallobjectswithesv(ctrl, uEchoEsvNotificationRequest));
+  
+  uEchoObject *foundObj = uecho_controller_getobjectbycodewithwait(ctrl, UECHO_TEST_OBJECTCODE, UECHO_TEST_RESPONSE_WAIT_MAX_MTIME);
+  BOOST_CHECK(foundObj);
+  
+  BOOST_CHECK(uecho_controller_stop(ctrl));
+  uecho_controller_delete(ctrl);
+  
+  BOOST_CHECK(uecho_node_stop(node));
+  uecho_node_delete(node);
+}